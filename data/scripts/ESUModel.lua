@@ -80,6 +80,25 @@ function ESUModel:updateInput( esuInput )
 	self.mode = esuInput:mode()
 end
 
+-- Number of jittered points each activation's energy is spread over
+ESUModel.jitterCount = 4
+
+-- Generator for the jitter, seeded so runs repeat
+ESUModel.random = Random( 1 )
+
+-- Returns a table of jitterCount vec2 placements randomly offset from 
+-- xpos, ypos by up to width, passed to the tissue in one call
+function ESUModel.jitterContacts( xpos, ypos, width )
+	local offsets = {}
+	ESUModel.random:fillUniform( offsets, 2 * ESUModel.jitterCount, 0, width )
+	local contacts = {}
+	for i = 1, ESUModel.jitterCount do
+		contacts[i] = vec2( xpos + offsets[2*i - 1], 
+		                    ypos + offsets[2*i] )
+	end
+	return contacts
+end
+
 -- Precondition:  the mode and wattages (coag/cut) have already been set.
 function ESUModel:activate( theTissueSim, xpos, ypos, stylusPos, tissueContactPos, distFromTissue, radius, dt )
 
@@ -116,8 +135,7 @@ function ESUModel:activate( theTissueSim, xpos, ypos, stylusPos, tissueContactPo
 		local widthOfInstrument = 0.005 -- TODO -- get from electrode type
 
 		-- Random jitter for electricity placement
-		xpos = xpos + widthOfInstrument * math.random()
-		ypos = ypos + widthOfInstrument * math.random()
+		local contacts = ESUModel.jitterContacts( xpos, ypos, widthOfInstrument )
 
 		-- print(string.format("Touch energy: (%2.2f, %2.2f, %2.2f, %2.2f, %2.2f, %2.2f, %2.2f)",
 		-- 	xpos, ypos, 
@@ -125,7 +143,7 @@ function ESUModel:activate( theTissueSim, xpos, ypos, stylusPos, tissueContactPo
 		-- 	dutyCycle, 
 		-- 	radius, 
 		-- 	dt ) )
-		theTissueSim:accumulateElectricalEnergy( xpos, ypos, 
+		theTissueSim:accumulateElectricalEnergyAt( contacts, 
 			voltage, current, 
 			dutyCycle, 
 			radius, 
@@ -145,8 +163,7 @@ function ESUModel:activate( theTissueSim, xpos, ypos, stylusPos, tissueContactPo
 			widthOfInstrument = widthOfInstrument * 1.5
 		end
 		-- Random jitter for electricity placement
-		xpos = xpos + widthOfInstrument * math.random()
-		ypos = ypos + widthOfInstrument * math.random()
+		local contacts = ESUModel.jitterContacts( xpos, ypos, widthOfInstrument )
 
 		-- Draw the spark
 		if self.hasCreatedSpark then
@@ -175,7 +192,7 @@ function ESUModel:activate( theTissueSim, xpos, ypos, stylusPos, tissueContactPo
 		-- 	dutyCycle, 
 		-- 	radius, 
 		-- 	dt ) )
-		theTissueSim:accumulateElectricalEnergy( xpos, ypos, 
+		theTissueSim:accumulateElectricalEnergyAt( contacts, 
 			voltage, current, 
 			dutyCycle, 
 			radius, 
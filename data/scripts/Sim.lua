@@ -384,8 +384,8 @@ function Sim.update( owner, dt )
 	if( input:isKeyDown( string.byte('X') ) ) then
 		local touchThreshold = 0.0004 -- meters
 		local sparkThreshold = 0.001 -- meters
-		local xpos = 0 + math.random() * 0.2 - 0.1
-		local ypos = 0 + math.random() * 0.2 - 0.1
+		local xpos = ESUModel.random:uniform( -0.1, 0.1 )
+		local ypos = ESUModel.random:uniform( -0.1, 0.1 )
 		local distFromTissue = 0.0005
 		local radiusOfContact = 0.002
 		-- local tissuePos = vec3( xpos/2.0 + owner.worldOffset.x, 0.1 + owner.worldOffset.y, ypos/2.0 + owner.worldOffset.z )
@@ -0,0 +1,46 @@
+#ifndef SPARK_CHARGEFIELDKERNELS_HPP
+#define SPARK_CHARGEFIELDKERNELS_HPP
+
+#include <cstddef>
+
+namespace spark
+{
+    /// Inner-loop kernels of DBMSpark's candidate field update, over
+    /// points stored as separate coordinate arrays.
+    /// Several implementations exist (scalar, SSE2, AVX2); use
+    /// chargeFieldKernels() to get the fastest one supported by this CPU.
+    /// Kernels must not allocate or lock, as they are called from
+    /// ThreadPool workers.
+    struct ChargeFieldKernels
+    {
+        /// Name of the instruction set, e.g., "AVX2", for logging.
+        const char* name;
+
+        /// Add the field of point charge q at (cx,cy,cz) to the fields
+        /// (phiX,phiY,phiZ) at n points (x,y,z), as pointChargeField()
+        /// with shell radius h.  The new field magnitudes are written to
+        /// mag, and [*minMag, *maxMag] is widened to include them.
+        /// The distance is taken from one reciprocal square root; points
+        /// at the charge's position are not allowed.
+        void (*addChargeField)( float* phiX, float* phiY, float* phiZ,
+                                float* mag, float* minMag, float* maxMag,
+                                const float* x, const float* y, const float* z, size_t n,
+                                float cx, float cy, float cz, float q, float h );
+    };
+
+    /// Returns the fastest kernels supported by the executing CPU.
+    /// Selected once, on first call, using CPUID.
+    const ChargeFieldKernels& chargeFieldKernels( void );
+
+    /// Portable reference kernels; always available.
+    const ChargeFieldKernels& scalarChargeFieldKernels( void );
+
+    /// SSE2 kernels, or NULL if not built for x86.
+    const ChargeFieldKernels* sseChargeFieldKernels( void );
+
+    /// AVX2+FMA kernels, or NULL if not built for x86 or the CPU/OS does
+    /// not support them (see cpuSupportsAVX2()).
+    const ChargeFieldKernels* avx2ChargeFieldKernels( void );
+} // end namespace spark
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SPARK_CHARGEOCTREE_HPP
+#define SPARK_CHARGEOCTREE_HPP
+
+#include "Spark.hpp"
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+namespace spark
+{
+    /// Electric field at offset r from a point charge q, for the
+    /// dielectric breakdown model's spherical shell Green's function
+    /// with shell radius h.
+    inline Eigen::Vector3f pointChargeField( const Eigen::Vector3f& r, float q, float h )
+    {
+        const float d = r.norm();
+        return ( ( 1.0f - ( h / d ) ) * q / d ) * r;
+    }
+
+    /// Octree of point charges for Barnes-Hut evaluation of the field
+    /// they produce (see pointChargeField()).  A node far enough from
+    /// the evaluation point (its width over its distance under the
+    /// opening angle) is evaluated from a multipole expansion about its
+    /// center of charge; nearer nodes are opened.  Evaluation is then
+    /// O(log n) per point instead of O(n).
+    ///
+    /// The field's unit-vector term doesn't decay with distance, so far
+    /// nodes count as much as near ones and a monopole alone errs by
+    /// tens of percent where fields cancel.  The expansion therefore
+    /// carries dipole and quadrupole terms of that term.
+    ///
+    /// Charges are only added, one at a time, as an aggregate grows.  The
+    /// root doubles in size when a charge lands outside it.  Nodes live in
+    /// one array, the eight children of a node adjacent, and each leaf's
+    /// charges are chained through the charge arrays.
+    class ChargeOctree
+    {
+    public:
+        ChargeOctree( void );
+
+        /// Remove every charge.
+        void clear( void );
+
+        /// Add charge q at pos.
+        void insert( const Eigen::Vector3f& pos, float q );
+
+        /// Number of charges inserted.
+        size_t size( void ) const { return m_chargePos.size(); }
+
+        /// Field at pos due to every charge, with shell radius h, opening
+        /// nodes whose width is at least openingAngle times their
+        /// distance.  An openingAngle of zero sums every charge.
+        Eigen::Vector3f field( const Eigen::Vector3f& pos, float h, float openingAngle ) const;
+
+        /// Field at pos due to every charge, summed directly.
+        /// Both evaluations may be called from several threads at once.
+        Eigen::Vector3f directField( const Eigen::Vector3f& pos, float h ) const;
+    private:
+        struct Node
+        {
+            Eigen::Vector3f center;      //< center of the node's cube
+            float halfWidth;             //< half its edge length
+            Eigen::Vector3f weightedPos; //< sum of |q| pos of its charges
+            float absCharge;             //< sum of |q|
+            float charge;                //< sum of q
+            Eigen::Vector3f dipole;      //< sum of q pos
+            float quadrupole[6];         //< sum of q pos pos^T: xx, yy, zz, xy, xz, yz
+            int firstChild;              //< first of 8 children, -1 for a leaf
+            int firstCharge;             //< head of a leaf's chain, -1 if empty
+            unsigned int chargeCount;    //< charges in a leaf
+        };
+
+        /// Append 8 empty children of node, returning the first.
+        int addChildren( int node );
+
+        /// Index of the child of node whose octant holds pos.
+        int childFor( int node, const Eigen::Vector3f& pos ) const;
+
+        /// Add charge c to the sums of node.
+        void accumulate( int node, size_t c );
+
+        /// Move the charges of leaf node, depth levels below the root,
+        /// into new children, until no leaf is over capacity (or at the
+        /// depth limit).
+        void split( int node, unsigned int depth );
+
+        /// Grow the root until it contains pos.
+        void growToContain( const Eigen::Vector3f& pos );
+
+        bool contains( const Node& node, const Eigen::Vector3f& pos ) const;
+
+        /// Add the field at pos of the charges under node to *result.
+        void addNodeField( int node, const Eigen::Vector3f& pos, float h,
+                           float openingAngle2, Eigen::Vector3f* result ) const;
+
+        std::vector< Node > m_nodes;                //< root first
+        std::vector< Eigen::Vector3f > m_chargePos;
+        std::vector< float > m_chargeQ;
+        std::vector< int > m_nextCharge;            //< next charge in the leaf, or -1
+    };
+} // end namespace spark
+
+#endif
@@ -10,9 +10,16 @@
 #define spark_DBMSpark_h
 
 #include "Spark.hpp"
+#include "ChargeOctree.hpp"
+#include "WeightedSampler.hpp"
+#include "ThreadPool.hpp"
+#include "Random.hpp"
 
 #include <vector>
 #include <memory>
+#include <utility>
+
+#include <boost/atomic.hpp>
 
 #include <Eigen/Dense>
 
@@ -37,41 +44,142 @@ namespace spark
     };
     typedef std::vector<PointCharge> PointCharges;
 
+    /// Point charges as a structure of arrays, so the field update can
+    /// run over each coordinate contiguously (see
+    /// ChargeFieldKernels::addChargeField()).
+    struct PointChargeArrays
+    {
+        size_t size( void ) const { return q.size(); }
+        bool empty( void ) const { return q.empty(); }
+        void clear( void );
+        void reserve( size_t n );
+        void pushBack( const PointCharge& a_charge );
+        void popBack( void );
+
+        PointCharge get( size_t i ) const;
+        void set( size_t i, const PointCharge& a_charge );
+        Eigen::Vector3f position( size_t i ) const { return Eigen::Vector3f( x[i], y[i], z[i] ); }
+
+        std::vector<float> x, y, z;          //< Locations of the point charges
+        std::vector<float> phiX, phiY, phiZ; //< Electric field vector at each location
+        std::vector<float> q;                //< Signed electric charges
+    };
+
     float dist( const PointCharge& a, const PointCharge& b );
 
+    /// A dielectric breakdown model: an aggregate of point charges grown,
+    /// one update() at a time, into candidates around it.  This is what
+    /// PointSparkRenderable draws.
+    class DielectricBreakdownModel
+    {
+    public:
+        virtual ~DielectricBreakdownModel() {}
+        virtual void update( double dt ) = 0;
+        virtual const PointCharges& aggregate( void ) const = 0;
+        virtual const PointCharges& candidate( void ) const = 0;
+    };
+    typedef spark::shared_ptr< DielectricBreakdownModel > DielectricBreakdownModelPtr;
 
-    /// Dielectric breakdown model
-    class DBMSpark
+    /// Dielectric breakdown model of point charges, with the field of
+    /// each summed (see GridDBMSpark for one on a grid).
+    class DBMSpark : public DielectricBreakdownModel
     {
     public:
+        /// Methods for evaluating the field at new candidates.
+        typedef enum
+        {
+            DirectFieldEvaluator,    //< sum every aggregate and boundary charge
+            BarnesHutFieldEvaluator  //< approximate with ChargeOctree, O(log n)
+        } FieldEvaluatorType;
+
         DBMSpark();
         void setAggregate( const PointCharges& a_ );
         void initializeBoundary( const PointCharges& a_boundary );
     
         void clear( void );
-        void update( double dt );
-        PointCharges& aggregate( void ) { return m_aggregate; }
-        const PointCharges& aggregate( void ) const { return m_aggregate; }
-        PointCharges& candidate( void ) { return m_candidate; }
-        const PointCharges& candidate( void ) const { return m_candidate; }
+        virtual void update( double dt ) override;
+
+        /// Copies of the aggregate and candidate charges, e.g., for
+        /// rendering.  They are made on demand from the arrays the
+        /// simulation works on (the aggregate's only appended to), and
+        /// stay valid until the next update().
+        virtual const PointCharges& aggregate( void ) const override;
+        virtual const PointCharges& candidate( void ) const override;
+
+        /// Specify the number of threads that share the candidate field
+        /// update.  Zero uses all hardware threads (the default).
+        /// Applied by the next update(), not one in progress.
+        void setThreadCount( unsigned int threadCount );
+
+        /// Returns the number of threads used by the candidate field update.
+        unsigned int getThreadCount( void ) const { return m_threadCount; }
+
+        /// Select how the field at each new candidate is computed.  For
+        /// Barnes-Hut, openingAngle trades accuracy for speed: octree
+        /// nodes narrower than openingAngle times their distance are
+        /// expanded rather than summed.  Growing buildSpark_pointInBall(),
+        /// 0.3 keeps every candidate's field within 0.2%; 0.5 is twice as
+        /// fast and within about 1%.
+        void setFieldEvaluator( FieldEvaluatorType evaluator, float openingAngle = 0.3f );
+        FieldEvaluatorType getFieldEvaluator( void ) const { return m_fieldEvaluator; }
+
+        /// When set, each Barnes-Hut evaluation is also summed directly and
+        /// the largest relative difference kept, see getMaxFieldError().
+        /// For testing; it costs as much as the direct evaluator.
+        void setFieldCheck( bool isCheckingField );
+
+        /// Largest |Barnes-Hut - direct| / |direct| field seen since
+        /// setFieldCheck( true ).
+        float getMaxFieldError( void ) const { return m_maxFieldError; }
+
+        /// A candidate's selection weight is recomputed once its field
+        /// magnitude has moved by more than tolerance times the range of
+        /// candidate field magnitudes, so each weight stays within about
+        /// m_eta * tolerance of the largest one.  All are recomputed when
+        /// the lowest magnitude falls by as much.  Zero recomputes every
+        /// weight on every update().
+        void setWeightTolerance( float tolerance ) { m_weightTolerance = tolerance; }
+
+        /// Restart the random sequence that chooses and places
+        /// candidates; the same seed grows the same spark.
+        void setSeed( boost::uint64_t seed ) { m_random.seed( seed ); }
     private:
         /// Compute new phi (electric field) values at each m_candidate PointCharge
-        /// by adding a_additionalCharge.
+        /// by adding a_additionalCharge, and refresh the selection weights
+        /// that moved beyond m_weightTolerance.  Candidates are split into
+        /// blocks shared by m_threadPool.
         /// Post: m_minPhi and m_maxPhi updated.
         void updateElectricFields( const PointCharge& a_additionalCharge );
+
+        /// Append a_candidate to m_candidate, with its selection weight.
+        void addCandidate( const PointCharge& a_candidate );
+
+        /// Remove candidate index, moving the last candidate into its place.
+        void removeCandidate( size_t index );
+
+        /// Selection weight of a candidate of field magnitude phi: its
+        /// place in the range of candidate magnitudes, to the power m_eta.
+        float candidateWeight( float phi ) const;
+
+        /// Set m_minPhi and m_maxPhi to the range of candidate field
+        /// magnitudes and recompute every selection weight for it.
+        void rebuildCandidateWeights( void );
     
         /// Compute the electric field of a_point by adding field from every
-        /// current memeber of the aggregate and the boundary.
+        /// current memeber of the aggregate and the boundary, as selected
+        /// by setFieldEvaluator().
+        /// Post: m_minPhi and m_maxPhi include its magnitude.
         void recomputeElectricFieldAtPoint( PointCharge& a_point );
+
+        /// Field at a_point from every aggregate and boundary charge,
+        /// summed directly.
+        Eigen::Vector3f directElectricField( const PointCharge& a_point ) const;
     
-        /// Compute the electric field at the location of "to" due to the charge of "from"
-        Eigen::Vector3f field( const PointCharge& to, const PointCharge& from );
-    
-        /// Use m_candidate electric field strengths (phi) to compute the probability
-        /// that a candidate will be selected for inclusion in the aggregate
+        /// Select a candidate with probability proportional to its weight
+        /// (see candidateWeight()), in O(log n).
         /// Returns the index in m_candidate of the selected PointCharge.
         /// Precondition: m_candidate must have at least one element.
-        size_t selectNextCandidate( void ) const;
+        size_t selectNextCandidate( void );
     
         /// Choose a new point in the neighborhoood (with m_h units)
         /// of the a_center position.  Returned PointCharge has the
@@ -88,14 +196,51 @@ namespace spark
         float m_eta; //< "fractal" power, good between 1 and 10
 
         /// Point charges composing the actual spark, note phi values not updated after adding
-        PointCharges m_aggregate;
+        PointChargeArrays m_aggregate;
         /// All candidate point charges that might be included in the aggregate in next step
-        PointCharges m_candidate;
+        PointChargeArrays m_candidate;
+        /// Field magnitude of each m_candidate
+        std::vector< float > m_candidatePhi;
         /// All point charges making up the "boundary"
-        PointCharges m_boundary;
+        PointChargeArrays m_boundary;
+
+        /// Copies returned by aggregate() and candidate()
+        mutable PointCharges m_aggregateView;
+        mutable PointCharges m_candidateView;
+        mutable bool m_isCandidateViewStale;
+
+        /// m_aggregate and m_boundary, for Barnes-Hut evaluation
+        ChargeOctree m_aggregateTree;
+        ChargeOctree m_boundaryTree;
+
+        FieldEvaluatorType m_fieldEvaluator;
+        float m_openingAngle;
+        bool m_isCheckingField;
+        float m_maxFieldError;
     
         float m_minPhi; //< min electric field of candidate point charges
         float m_maxPhi; //< max electric field of candidate point charges
+
+        /// Selection weight of each m_candidate
+        WeightedSampler m_candidateWeights;
+        /// Field magnitude each candidate's weight was computed for
+        std::vector< float > m_weightPhi;
+        /// Range of field magnitudes the weights are normalized to.  Only
+        /// the minimum changes the probabilities; the range keeps the
+        /// weights within float.
+        float m_weightMinPhi;
+        float m_weightMaxPhi;
+        float m_weightTolerance;
+
+        Random m_random;
+
+        ThreadPoolPtr m_threadPool;
+        boost::atomic< unsigned int > m_threadCount; //< m_threadPool's size from the next update()
+        /// Per block of updateElectricFields(): the range of candidate
+        /// field magnitudes, and the (candidate, weight) pairs to set.
+        std::vector< float > m_blockMinPhi;
+        std::vector< float > m_blockMaxPhi;
+        std::vector< std::vector< std::pair< size_t, float > > > m_blockWeights;
     };
     typedef spark::shared_ptr< DBMSpark > DBMSparkPtr;
 
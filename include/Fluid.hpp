@@ -1,243 +1,596 @@
-#ifndef SOFTIE_FLUID_HPP
-#define SOFTIE_FLUID_HPP
-
-#include "VelocityFieldInterface.hpp"
-
-#include "Mesh.hpp"
-#include "VolumeData.hpp"
-
-#include <ostream>
-
-namespace spark
-{
-    /// 3D fluid simulation, based primarily on Jos Stam's Stable Fluids.
-    /// Supports cubic volumes of fixed size.
-    class Fluid : public VolumeData
-    {
-    public:
-        /// Create and initialize a fluid volume, with all-equal dimensions.
-        /// The size argument specifies the number of cells, not the scale.
-        Fluid( int size = 4 );
-        virtual ~Fluid();
-
-        /// Sets the number of cells per dimension.  Contents of the Fluid
-        /// from before a call to setSize() may be lost.
-        void setSize( int size );
-
-        /// Returns the number of cells in a single dimension of the Fluid.
-        int getSize( void );
-
-        /// Save the fluid to a file.
-        /// \see loadFromFile
-        void saveToFile( const char* filename );
-
-        /// Read the state of the fluid from a file.
-        /// \see saveToFile
-        void loadFromFile( const char* filename );
-
-        //////////////////////////////////////////////////////////////////////////
-        // Methods from VolumeData
-        virtual void update( double dt ) override;
-        virtual size_t dimX( void ) const { return m_N+2; }
-        virtual size_t dimY( void ) const { return m_N+2; }
-        virtual size_t dimZ( void ) const { return m_N+2; }
-        /// Provides the "stable" density data (i.e., not currently updated)
-        virtual const float* const getDensityData() const { return m_density; }
-        virtual const float* const getVorticityMagnitudeData() const { return m_vorticityMagnitude; }
-        virtual void getVelocityData( const float*& outVelX, const float*& outVelY, const float*& outVelZ ) const
-        {
-            outVelX = m_velU; outVelY = m_velV; outVelZ = m_velW;
-        }
-        virtual void getVorticityData( const float*& outVorticityX, const float*& outVorticityY, const float*& outVorticityZ ) const
-        {
-            outVorticityX = m_vorticityU; outVorticityY = m_vorticityV; outVorticityZ = m_vorticityW;
-        }
-        virtual void getVorticityForceData( const float*& outVorticityForceX, const float*& outVorticityForceY, const float*& outVorticityForceZ ) const
-        {
-            outVorticityForceX = m_vorticityForceU; outVorticityForceY = m_vorticityForceV; outVorticityForceZ = m_vorticityForceW;
-        }
-        virtual float absorption( void ) const { return m_absorption; }
-        //////////////////////////////////////////////////////////////////////////
-
-        void setViscosity( float visc ) { m_visc = visc; }
-        void setDiffusion( float diff ) { m_diff = diff; }
-        void setVorticity( float vort ) { m_vorticityConfinementFactor = vort; }
-        void setAbsorption( float absorption ) { m_absorption = absorption; }
-        void setGravityFactor( float gravX, float gravY, float gravZ ) 
-        { 
-            m_gravityFactor[0] = gravX; 
-            m_gravityFactor[1] = gravY; 
-            m_gravityFactor[2] = gravZ; 
-        }
-
-        /// Used to update and/or clear the source of density
-        const float* getDensitySource( void ) { return m_density_source; }
-        const float* getTempSource( void ) { return m_temp_source; }
-    
-        /// Used to update and/or clear the source of velocity
-        const float* getVelUSource( void );
-        const float* getVelVSource( void );
-        const float* getVelWSource( void );
-
-        /// Specify the number of inner-loop PDE solver iterations. 
-        /// Roughly linear time taken by entire update() method.
-        void setSolverIterations( unsigned int iterations ) { m_solverIterations = iterations; }
-
-        /// Write Python scripts that instance arrays that hold per-update density slices at y=j
-        std::ostream& writeYDensitySliceToPythonStream( std::ostream& out, const std::string& varName, unsigned int frame, size_t j ) const;
-        /// Write Python scripts that instance arrays that hold per-update velocity field (3d) slices at y=j
-        std::ostream& writeYVelocitySliceToPythonStream( std::ostream& out, const std::string& varName, unsigned int frame, size_t j, float dt ) const;
-
-        /// resets the simulation to some arbitrary initial state
-        void reset( void );
-
-        /// Debugging method to add a density source at the bottom of the Fluid.
-        void addBottomSource( void );
-
-        /// Adds an amount of density at the given coordinates, capping the highest
-        /// possible density to maxDensity.
-        void addSourceAtLocation( float x, float y, 
-                                  float deltaDensity, float maxDensity );
-    private:
-        void reallocate( void );
-        void init( void );
-        void deleteData( void );
-        void zeroData( void );
-        void addDensitySources( float dt );
-        void addVelocitySources( float dt );
-
-        /// Debugging method to add a density and velocity impulse.
-        void addBoom( void );
-
-        /// Compute the curl of a single component, with given (positive) offsets
-        /// h should be the size of one voxel
-        void curl( float* dest, 
-            const float* a, const float* b, 
-            int ax, int ay, int az, 
-            int bx, int by, int bz,
-            float h );
-
-        void computeVorticityConfinment();
-
-        /// Helmholtz projection into a mass-conserving field
-        void project( void );
-
-        /// Solve diffusion of field x_prev, writing new values to x
-        void diffuse( int boundaryCondition, float* x, float* x_prev, float diff, float dt );
-
-        /// Solve the divergence by Gauss-Seidel relaxation, writing new values to x
-        void linearSolve( int boundaryCondition, float* x, float* x_prev, float a, float c );
-    
-        // Slow version of linearSolve is known correct, but not optimized
-        void linearSolveSlow( int boundaryCondition, float* x, float* x_prev, float a, float c );
-
-        // Advect a single dimension held in d[] (with previous timestep d_prev) by the velocity field vx,vy,vz over time dt
-        // typically:
-        //    vx = m_velU;
-        //    vy = m_velV;
-        //    vz = m_velW;
-        void advect( int boundaryCondition, float* d, float* d_prev, float* vx, float* vy, float* vz, float dt );
-
-        // Make the boundary same as the neighboring in-side cell, 
-        // When dim!=0, ensure that dimension has zero total on the boundary wall
-        // i.e., make the outer boundary the negative of the in-side cell.
-        void enforceBoundary( int dim, float* x );
-        // hacked version to remove bounds
-        void enforceConcentrationBoundary( int dim, float* x );
-
-        /// Master function that updates the velocity vector (3d) field, 
-        /// including advection, diffusion and projection 
-        /// onto mass-conserving field.
-        void stepVelocity( float dt );
-
-        /// Master function that updates the density scalar field, including
-        /// advection and diffusion.
-        void stepDensity( float dt );
-
-        /// Returns the index into the parallel arrays (e.g., m_density, m_velU, etc.)
-        /// for the given 3d coordinates
-        size_t index( size_t i, size_t j, size_t k ) const
-        {
-            const size_t dim = m_N+2;
-            return i + dim*(j + dim*k);
-        }
-
-        float& density( size_t i, size_t j, size_t k ) const
-        {
-            return m_density[ index(i,j,k) ];
-        }
-
-        void swapAdvectedFields()
-        {
-            float* tmp = m_density;
-            m_density = m_density_prev;
-            m_density_prev = tmp;
-
-            tmp = m_temp;
-            m_temp = m_temp_prev;
-            m_temp_prev = tmp;
-        }
-
-        void swapVelocityField()
-        {
-            float* tmp = m_velU;
-            m_velU = m_velU_prev;
-            m_velU_prev = tmp;
-
-            tmp = m_velV;
-            m_velV = m_velV_prev;
-            m_velV_prev = tmp;
-
-            tmp = m_velW;
-            m_velW = m_velW_prev;
-            m_velW_prev = tmp;
-        }
-
-        size_t m_N; //< N does not include one-cell boundary at each side
-        float* m_density; //< (N+2)^3 scalar field holding the density
-        
-        float* m_density_prev; //< previous time step's density field (scalar)
-        // sources to be added with each update, needs to be zeroed if no longer adding
-        float* m_density_source;
-
-        float* m_velU;    //< (velU,velV,velW) is a (N+2)^3 vector field holding the velocity
-        float* m_velV;
-        float* m_velW;
-
-        float* m_temp; ///< scalar field holding the temp at that voxel
-        float* m_temp_prev; //< previous time step's temp field (scalar)
-        float* m_temp_source;
-        
-        float* m_vorticityU; //< Curl of the velocity field, used for vorticity confinement
-        float* m_vorticityV; //< referred to as omega in Fedkiw,Stam,Jensen
-        float* m_vorticityW;
-
-        float* m_vorticityMagnitude; //< Magnitude of the fluids "vorticity" (which is the curl of the velocity)
-
-        float* m_vorticityForceU; //< holds the normalized direction of increased vorticity, N in FSJ temporarily inside computeVorticityConfinment()
-        float* m_vorticityForceV; //< and holds the vorticity confinement force after the call to computeVorticityConfinment()
-        float* m_vorticityForceW;
-
-        float* m_velU_prev; //< previous time step's velocity field (UVW as a vector)
-        float* m_velV_prev;
-        float* m_velW_prev;
-
-        float* m_velU_source;
-        float* m_velV_source;
-        float* m_velW_source;
-
-        unsigned int m_solverIterations; //< number of iterations in inner loop of Gauss-Seidel relaxation
-        size_t m_size;  //< total number of elements in main arrays (density and each elem of velocity)
-        float m_visc;  //< viscosity, used in velocity diffusion
-        float m_diff;  //< material density diffusion
-        float* m_div;  //< temporary storage for divergence field (only used in projection)
-        float* m_pressure; //< temporary storage for pressure field (only used in projection)
-        float m_ambientTemp; //< the temp of the embedding medium that the fluid is in.  (Celsius)
-        float m_tempFactor; //< tuning factor that converts a temperature difference to a buoyancy force.
-        float m_gravityFactor[3]; //< tuning factor that converts particle density to gravitational force
-        float m_vorticityConfinementFactor; //< tuning factor for the amount of vorticity to be restored
-        float m_absorption; //< rate at which light is absorbed per unit density
-    };
-    typedef spark::shared_ptr< Fluid > FluidPtr;
-} // end namespace spark
-#endif
+#ifndef SOFTIE_FLUID_HPP
+#define SOFTIE_FLUID_HPP
+
+#include "VelocityFieldInterface.hpp"
+
+#include "Mesh.hpp"
+#include "VolumeData.hpp"
+#include "ThreadPool.hpp"
+#include "FluidKernels.hpp"
+#include "MultigridSolver.hpp"
+#include "TripleBuffer.hpp"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/atomic.hpp>
+
+#include <ostream>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+namespace boost { namespace interprocess { class mapped_region; } }
+
+namespace spark
+{
+    /// 3D fluid simulation, based primarily on Jos Stam's Stable Fluids.
+    /// Supports box-shaped volumes of fixed size.
+    /// In world space the interior cells are centered on the origin.
+    class Fluid : public VolumeData, public VelocityFieldInterface
+    {
+    public:
+        /// Methods for solving the pressure projection.
+        typedef enum
+        {
+            GaussSeidelPressureSolver, //< fixed number of red-black Gauss-Seidel iterations
+            MultigridPressureSolver    //< multigrid-preconditioned CG, stops at a tolerance
+        } PressureSolverType;
+
+        /// Outcome of one pressure projection.
+        struct PressureSolveStats
+        {
+            unsigned int iterations;
+            float residual;    //< relative L2 residual, ||div - A p|| / ||div||
+            float residualMax; //< relative Linf residual, max|div - A p| / max|div|
+        };
+
+        /// Create and initialize a fluid volume.
+        /// The size arguments specify the number of cells, not the scale;
+        /// sizeY or sizeZ of zero copy sizeX.  cellSize is the world-space
+        /// width of a cell, or zero to give the longest side unit length.
+        Fluid( int sizeX = 4, int sizeY = 0, int sizeZ = 0, float cellSize = 0 );
+        virtual ~Fluid();
+
+        /// Sets the number of cells per dimension.  Contents of the Fluid
+        /// from before a call to setSize() may be lost.  Only while
+        /// update() isn't running on another thread.
+        void setSize( int size );
+
+        /// Sets the number of cells along each axis and the world-space
+        /// width of a cell (zero gives the longest side unit length).
+        /// Contents of the Fluid from before the call may be lost.  Only
+        /// while update() isn't running on another thread.
+        void setSize( int sizeX, int sizeY, int sizeZ, float cellSize );
+
+        /// Returns the number of cells in the x dimension of the Fluid.
+        /// \see dimX, dimY, dimZ
+        int getSize( void );
+
+        /// Returns the world-space width of a cell.
+        float getCellSize( void ) const { return m_cellSize; }
+
+        /// Save the density to a text file.
+        /// \see loadFromFile, saveCheckpoint
+        void saveToFile( const char* filename );
+
+        /// Read the density from a text file written by saveToFile().
+        /// Only while update() isn't running on another thread.
+        /// \see saveToFile, loadCheckpoint
+        void loadFromFile( const char* filename );
+
+        /// Save the simulation state to a binary checkpoint: the size and
+        /// physical parameters, and the density, temperature, velocity,
+        /// pressure and source fields.
+        /// \see loadCheckpoint
+        void saveCheckpoint( const char* filename ) const;
+
+        /// Restore the state saved by saveCheckpoint().  The file is
+        /// memory-mapped copy-on-write and the fields point into it, so
+        /// nothing is read until used, and the file is never modified.
+        /// Throws SparkRunTimeException if the file is not a checkpoint of
+        /// a supported version.  Replaces the fields, so only call it
+        /// while update() isn't running on another thread.
+        /// \see saveCheckpoint
+        void loadCheckpoint( const char* filename );
+
+        //////////////////////////////////////////////////////////////////////////
+        // Methods from VolumeData
+        virtual void update( double dt ) override;
+        virtual size_t dimX( void ) const { return m_Nx+2; }
+        virtual size_t dimY( void ) const { return m_Ny+2; }
+        virtual size_t dimZ( void ) const { return m_Nz+2; }
+        /// Provides the "stable" density data (i.e., not currently updated)
+        virtual const float* const getDensityData() const { return m_density; }
+        const float* getTemperatureData( void ) const { return m_temp; }
+        virtual const float* const getDensitySnapshot();
+        virtual const unsigned short* const getHalfDensitySnapshot();
+        virtual const float* const getVorticityMagnitudeData() const { return m_vorticityMagnitude; }
+        virtual void getVelocityData( const float*& outVelX, const float*& outVelY, const float*& outVelZ ) const
+        {
+            outVelX = m_velU; outVelY = m_velV; outVelZ = m_velW;
+        }
+        virtual void getVorticityData( const float*& outVorticityX, const float*& outVorticityY, const float*& outVorticityZ ) const
+        {
+            outVorticityX = m_vorticityU; outVorticityY = m_vorticityV; outVorticityZ = m_vorticityW;
+        }
+        virtual void getVorticityForceData( const float*& outVorticityForceX, const float*& outVorticityForceY, const float*& outVorticityForceZ ) const
+        {
+            outVorticityForceX = m_vorticityForceU; outVorticityForceY = m_vorticityForceV; outVorticityForceZ = m_vorticityForceW;
+        }
+        virtual float absorption( void ) const { return m_absorption; }
+        //////////////////////////////////////////////////////////////////////////
+
+        //////////////////////////////////////////////////////////////////////////
+        // Methods from VelocityFieldInterface
+        /// Trilinearly interpolated velocity of the current state at a
+        /// world-space position.  Positions are clamped to half a cell
+        /// beyond the interior, as in advection.  Not synchronized with
+        /// update().
+        virtual Eigen::Vector3f velocityAtPosition( const Eigen::Vector3f& pos ) override;
+        /// As velocityAtPosition(), using the SIMD kernels of the solver.
+        virtual void velocityAtPositions( const float* xyz, size_t n, float* outVelocity ) override;
+        //////////////////////////////////////////////////////////////////////////
+
+        void setViscosity( float visc ) { m_visc = visc; }
+        void setDiffusion( float diff ) { m_diff = diff; }
+        void setVorticity( float vort ) { m_vorticityConfinementFactor = vort; }
+        void setAbsorption( float absorption ) { m_absorption = absorption; }
+        void setGravityFactor( float gravX, float gravY, float gravZ ) 
+        { 
+            m_gravityFactor[0] = gravX; 
+            m_gravityFactor[1] = gravY; 
+            m_gravityFactor[2] = gravZ; 
+        }
+
+        /// A source of density, heat and momentum, spread evenly over the
+        /// interior cells within radius of position (at least the cell
+        /// holding position).
+        struct Source
+        {
+            Source()
+            : radius( 0 ), density( 0 ), temperature( 0 ),
+              maxDensity( std::numeric_limits< float >::max() ), lifetime( 0 )
+            {
+                position[0] = position[1] = position[2] = 0;
+                velocity[0] = velocity[1] = velocity[2] = 0;
+            }
+            float position[3];  //< world position, as for velocityAtPosition()
+            float radius;       //< world distance
+            float density;      //< density added per unit time
+            float temperature;  //< temperature added per unit time
+            float velocity[3];  //< velocity added per unit time
+            float maxDensity;   //< the source adds no density past this
+            float lifetime;     //< simulation time the source lasts.  Zero
+                                //< makes an impulse, whose amounts are added
+                                //< once at the next update(), not per unit time.
+        };
+
+        /// Add a source, which takes effect at the next update().  Sources
+        /// cost time in proportion to the cells they cover, not the grid.
+        /// Safe to call from any thread, also while update() runs.
+        void addSource( const Source& source );
+        /// As addSource(), with source centered on interior cell (i,j,k),
+        /// counted from 1 and clamped to the interior.
+        void addSourceAtCell( size_t i, size_t j, size_t k, Source source );
+        /// Remove all sources at the next update().  Safe to call from any
+        /// thread, also while update() runs.
+        void clearSources( void );
+        /// Number of sources still active after the last update().
+        size_t getSourceCount( void ) const { return m_sources.size(); }
+
+        /// Specify the number of inner-loop PDE solver iterations. 
+        /// Roughly linear time taken by entire update() method.
+        void setSolverIterations( unsigned int iterations ) { m_solverIterations = iterations; }
+
+        /// Select the solver for the pressure projection.
+        /// Defaults to GaussSeidelPressureSolver.
+        void setPressureSolver( PressureSolverType solver ) { m_pressureSolver = solver; }
+
+        /// The pressure solvers stop once the L2 norm of their residual
+        /// falls below tolerance times that of the divergence, or after
+        /// the solver iterations (see setSolverIterations).  Sets the
+        /// tolerance of both solvers.  By default multigrid stops at
+        /// 1e-3, and Gauss-Seidel has a tolerance of zero: it runs all the
+        /// solver iterations without measuring the residual, as a
+        /// typical 20 sweeps don't reach 1e-3 and each check costs about
+        /// a sweep.  Around 0.05 suits Gauss-Seidel with warm starts.
+        void setPressureTolerance( float tolerance )
+        {
+            m_gaussSeidelTolerance = tolerance;
+            m_multigridTolerance = tolerance;
+        }
+
+        /// Gauss-Seidel iterations between checks of the residual against
+        /// the pressure tolerance (default 4).
+        void setPressureResidualInterval( unsigned int interval ) { m_pressureResidualInterval = std::max( 1u, interval ); }
+
+        /// Start each pressure solve from the pressure of the previous
+        /// projection (the default) rather than from zero.
+        void setPressureWarmStart( bool isWarmStart ) { m_isPressureWarmStart = isWarmStart; }
+
+        /// Returns the number of iterations used by the last pressure projection.
+        unsigned int getPressureIterations( void ) const { return m_pressureIterations; }
+
+        /// Returns the relative L2 residual left by the last pressure projection.
+        float getPressureResidual( void ) const { return m_pressureResidual; }
+
+        /// Returns the relative Linf residual left by the last pressure projection.
+        float getPressureResidualMax( void ) const { return m_pressureResidualMax; }
+
+        /// One entry per pressure projection of the last update(), two
+        /// per substep, in order.
+        const std::vector< PressureSolveStats >& getPressureSolveStats( void ) const { return m_pressureSolveStats; }
+
+        /// Specify the number of threads that share each solver sweep.
+        /// Sweeps are split into z-slabs, one per thread.
+        /// Zero uses all hardware threads (the default).  The pool is
+        /// replaced at the start of the next update(), so this may be
+        /// called (e.g., from Lua) while update() runs on another thread.
+        void setThreadCount( unsigned int threadCount );
+
+        /// Returns the number of threads used by the solver sweeps, from
+        /// the next update() on.
+        unsigned int getThreadCount( void ) const { return m_threadCount; }
+
+        /// Override the inner-loop kernels, e.g., to force scalarFluidKernels()
+        /// for comparison.  Defaults to fluidKernels(), chosen by CPUID.
+        void setKernels( const FluidKernels& kernels ) { m_kernels = &kernels; }
+
+        /// Returns the name of the kernels in use, e.g., "AVX2".
+        const char* getKernelName( void ) const { return m_kernels->name; }
+
+        /// Tile the interior into bricks of brickSize^3 cells and have the
+        /// solver passes skip bricks that are empty and not next to a
+        /// non-empty brick.  A brick is empty when all its density,
+        /// velocity and temperature (relative to ambient) are below the
+        /// brick threshold and it holds no sources.  Empty bricks are
+        /// zeroed as they go inactive.  Off by default.
+        void setBrickSkipping( bool isBrickSkipping );
+        bool getBrickSkipping( void ) const { return m_isBrickSkipping; }
+
+        /// Magnitude below which a brick's contents count as empty.
+        void setBrickThreshold( float threshold ) { m_brickThreshold = threshold; }
+
+        /// Number of bricks updated by the last update(), of getBrickCount().
+        size_t getActiveBrickCount( void ) const { return m_activeBrickCount; }
+        size_t getBrickCount( void ) const { return m_brickActive.size(); }
+
+        /// Also store the vorticity and its magnitude in full fields, for
+        /// getVorticityData() and getVorticityMagnitudeData().  Off by
+        /// default, when those fields stay zero and vorticity confinement
+        /// only keeps a few z-slices of them at a time.
+        void setVorticityOutput( bool isVorticityOutput ) { m_isVorticityOutput = isVorticityOutput; }
+
+        /// update() splits its time step into substeps that move the
+        /// fastest velocity component at most targetCFL cells each
+        /// (default 4, half a brick).
+        void setTargetCFL( float targetCFL ) { m_targetCFL = targetCFL; }
+
+        /// Most substeps taken by one update() (default 8).
+        void setMaxSubsteps( unsigned int maxSubsteps ) { m_maxSubsteps = std::max( 1u, maxSubsteps ); }
+
+        /// Wall-clock budget of one update() in milliseconds; no further
+        /// substeps start once it is spent.  Zero (the default) is
+        /// unlimited.  Time not simulated, by the budget or the maximum
+        /// substeps, is carried into the next update(), up to one
+        /// update's worth.
+        void setUpdateBudget( float milliseconds ) { m_updateBudget = milliseconds; }
+
+        /// Substeps taken by the last update().
+        unsigned int getSubstepCount( void ) const { return m_substepCount; }
+
+        /// Wall-clock time taken by the last update(), in milliseconds.
+        float getUpdateMilliseconds( void ) const { return m_updateMilliseconds; }
+
+        /// CFL number of the whole time step of the last update(), before
+        /// it was split into substeps.
+        float getCFL( void ) const { return m_cfl; }
+
+        /// Hand the state after each update() to recorder (NULL to stop),
+        /// which copies what it records before update() returns.
+        void setRecorder( FluidRecorderPtr recorder ) { m_recorder = recorder; }
+
+        /// Back the fields with transparent huge pages where the OS
+        /// supports them (Linux), from the next setSize() or
+        /// loadCheckpoint().  Off by default.
+        void setHugePages( bool isHugePages ) { m_isHugePages = isHugePages; }
+
+        /// Also publish each density snapshot as half floats, for
+        /// getHalfDensitySnapshot(), halving the bytes a renderer copies
+        /// and uploads.  The solver itself always runs in floats.  Off by
+        /// default; set before update() runs on another thread.
+        void setHalfFloatSnapshots( bool isHalfFloatSnapshots );
+
+        /// Cells per side of a brick.
+        static const size_t brickSize = 8;
+
+        /// Write Python scripts that instance arrays that hold per-update density slices at y=j
+        std::ostream& writeYDensitySliceToPythonStream( std::ostream& out, const std::string& varName, unsigned int frame, size_t j ) const;
+        /// Write Python scripts that instance arrays that hold per-update velocity field (3d) slices at y=j
+        std::ostream& writeYVelocitySliceToPythonStream( std::ostream& out, const std::string& varName, unsigned int frame, size_t j, float dt ) const;
+
+        /// resets the simulation to some arbitrary initial state, at the
+        /// start of the next update() (which may be running on another
+        /// thread, the only one that writes the fields and snapshots).
+        void reset( void );
+
+        /// Debugging method to add a density source at the bottom of the Fluid.
+        void addBottomSource( void );
+
+        /// Adds an amount of density at the given coordinates, capping the highest
+        /// possible density to maxDensity.  An impulse source, see addSource().
+        void addSourceAtLocation( float x, float y, 
+                                  float deltaDensity, float maxDensity );
+    private:
+        /// A Source in the simulation, with the cells it covers.
+        struct ActiveSource
+        {
+            Source source;
+            float remaining;             //< lifetime left
+            std::vector< size_t > cells; //< flat indices of the covered cells
+            size_t lo[3], hi[3];         //< bounding box of the cells, inclusive
+        };
+
+        /// Sets m_Nx, m_Ny, m_Nz, m_cellSize and m_size without reallocating.
+        void setDimensions( int sizeX, int sizeY, int sizeZ, float cellSize );
+        /// Allocate the fields for the current dimensions, and drop the
+        /// active sources, whose cells belong to the old grid.
+        void reallocate( void );
+        void init( void );
+        /// Recompute m_brickActive from the current fields, zeroing bricks that go inactive.
+        void updateActiveBricks( void );
+        /// Reset the fields of an inactive brick to the empty state.
+        void clearBrick( size_t bx, size_t by, size_t bz );
+        void deleteData( void );
+        /// Fills fields with the fields stored in a checkpoint, in file
+        /// order, and returns their number.
+        size_t getCheckpointFields( float** fields[] ) const;
+        /// Copy the density into a snapshot and hand it to getDensitySnapshot().
+        void publishDensitySnapshot( void );
+        void zeroData( void );
+        /// Set fields to value, each z-slab by the ThreadPool worker that
+        /// sweeps it, so fresh pages are first touched (and, on NUMA
+        /// systems, placed) by the thread that uses them.
+        void fillFields( float* const fields[], size_t fieldCount, float value );
+        /// Take the sources queued by addSource() into m_sources, applying
+        /// impulses straight away.
+        void acquireSources( void );
+        /// Find the cells of source.source.
+        void rasterizeSource( ActiveSource& source ) const;
+        /// Shorten the sources' lifetimes by dt, dropping those that ended.
+        void ageSources( float dt );
+        void addDensitySources( float dt );
+        /// Velocity sources, buoyancy, gravity and vorticity confinement.
+        void addVelocitySources( float dt );
+        /// Largest magnitude of any velocity component in the active bricks.
+        float maxVelocity( void ) const;
+
+        /// Debugging method to add a density and velocity impulse.
+        void addBoom( void );
+
+        /// Compute m_vorticityForce{U,V,W} in one sweep over z, keeping the
+        /// vorticity and its magnitude only in a rolling window of z-slices.
+        void computeVorticityConfinment();
+
+        /// Helmholtz projection into a mass-conserving field
+        void project( void );
+
+        /// Solve diffusion of field x_prev, writing new values to x
+        void diffuse( int boundaryCondition, float* x, float* x_prev, float diff, float dt );
+
+        /// Solve the divergence by Gauss-Seidel relaxation, writing new values to x
+        /// Cells are relaxed in red-black order so each half-sweep can be 
+        /// split across m_threadPool; results do not depend on thread count.
+        /// With a tolerance, stops early once the relative L2 residual,
+        /// measured every m_pressureResidualInterval iterations, is at most
+        /// tolerance.  Returns the number of iterations used.  Given
+        /// outResidual and outResidualMax, sets them to the final
+        /// residual (see linearResidual()), reusing the last check.
+        unsigned int linearSolve( int boundaryCondition, float* x, float* x_prev, float a, float c,
+                                  float tolerance = 0,
+                                  float* outResidual = NULL, float* outResidualMax = NULL );
+
+        /// Relative L2 and Linf norms of the residual x_prev + a*(sum of
+        /// neighbors of x) - c*x over the active interior cells.
+        void linearResidual( const float* x, const float* x_prev, float a, float c,
+                             float& outResidual, float& outResidualMax ) const;
+    
+        // Slow version of linearSolve is known correct, but not optimized
+        // Lexicographic ordering, single-threaded; kept as the reference.
+        void linearSolveSlow( int boundaryCondition, float* x, float* x_prev, float a, float c );
+        /// Unit tests check linearSolve() against linearSolveSlow()
+        friend struct FluidSolverTestAccess;
+
+        /// Relax the cells of one color ((i+j+k)%2 == color) in slices [kBegin,kEnd)
+        /// Cells of one color only read cells of the other, so slabs may
+        /// be relaxed concurrently.
+        void relaxRedBlackSlab( int color, float* x, const float* x_prev, 
+                                float a, float invC, 
+                                size_t kBegin, size_t kEnd );
+
+        // Advect a single dimension held in d[] (with previous timestep d_prev) by the velocity field vx,vy,vz over time dt
+        // typically:
+        //    vx = m_velU;
+        //    vy = m_velV;
+        //    vz = m_velW;
+        void advect( int boundaryCondition, float* d, float* d_prev, float* vx, float* vy, float* vz, float dt );
+
+        // Make the boundary same as the neighboring in-side cell, 
+        // When dim!=0, ensure that dimension has zero total on the boundary wall
+        // i.e., make the outer boundary the negative of the in-side cell.
+        void enforceBoundary( int dim, float* x );
+        // hacked version to remove bounds
+        void enforceConcentrationBoundary( int dim, float* x );
+
+        /// Master function that updates the velocity vector (3d) field, 
+        /// including advection, diffusion and projection 
+        /// onto mass-conserving field.
+        void stepVelocity( float dt );
+
+        /// Master function that updates the density scalar field, including
+        /// advection and diffusion.
+        void stepDensity( float dt );
+
+        /// Returns the index into the parallel arrays (e.g., m_density, m_velU, etc.)
+        /// for the given 3d coordinates
+        size_t index( size_t i, size_t j, size_t k ) const
+        {
+            return i + (m_Nx+2)*(j + (m_Ny+2)*k);
+        }
+
+        /// Calls rowFunc( i, j, k, count ) for each run of count interior
+        /// cells starting at i,j,k that lie in active bricks, over the rows
+        /// of z-slabs kBegin to kEnd-1.  Whole rows without brick skipping.
+        template< typename RowFunc >
+        void forEachActiveRow( size_t kBegin, size_t kEnd, RowFunc rowFunc ) const
+        {
+            for( size_t k = kBegin; k < kEnd; k++ )
+            {
+                for( size_t j = 1; j <= m_Ny; j++ )
+                {
+                    if( !m_isBrickSkipping )
+                    {
+                        rowFunc( 1, j, k, m_Nx );
+                        continue;
+                    }
+                    const unsigned char* active = &m_brickActive[ 
+                        m_bricksX*( (j-1)/brickSize + m_bricksY*((k-1)/brickSize) ) ];
+                    for( size_t b = 0; b < m_bricksX; )
+                    {
+                        if( !active[b] )
+                        {
+                            ++b;
+                            continue;
+                        }
+                        size_t e = b + 1;
+                        while( e < m_bricksX && active[e] )
+                        {
+                            ++e;
+                        }
+                        const size_t iBegin = 1 + b*brickSize;
+                        const size_t iEnd = std::min( 1 + e*brickSize, m_Nx + 1 );
+                        rowFunc( iBegin, j, k, iEnd - iBegin );
+                        b = e;
+                    }
+                }
+            }
+        }
+
+        float& density( size_t i, size_t j, size_t k ) const
+        {
+            return m_density[ index(i,j,k) ];
+        }
+
+        void swapAdvectedFields()
+        {
+            float* tmp = m_density;
+            m_density = m_density_prev;
+            m_density_prev = tmp;
+
+            tmp = m_temp;
+            m_temp = m_temp_prev;
+            m_temp_prev = tmp;
+        }
+
+        void swapVelocityField()
+        {
+            float* tmp = m_velU;
+            m_velU = m_velU_prev;
+            m_velU_prev = tmp;
+
+            tmp = m_velV;
+            m_velV = m_velV_prev;
+            m_velV_prev = tmp;
+
+            tmp = m_velW;
+            m_velW = m_velW_prev;
+            m_velW_prev = tmp;
+        }
+
+        size_t m_Nx; //< Nx, Ny, Nz do not include one-cell boundary at each side
+        size_t m_Ny;
+        size_t m_Nz;
+        float m_cellSize; //< world-space width of a cell
+        float* m_density; //< (Nx+2)(Ny+2)(Nz+2) scalar field holding the density
+        
+        float* m_density_prev; //< previous time step's density field (scalar)
+
+        float* m_velU;    //< (velU,velV,velW) is a vector field holding the velocity
+        float* m_velV;
+        float* m_velW;
+
+        float* m_temp; ///< scalar field holding the temp at that voxel
+        float* m_temp_prev; //< previous time step's temp field (scalar)
+        
+        float* m_vorticityU; //< Curl of the velocity field, referred to as omega in Fedkiw,Stam,Jensen
+        float* m_vorticityV; //< only written with setVorticityOutput( true )
+        float* m_vorticityW;
+
+        float* m_vorticityMagnitude; //< Magnitude of the fluids "vorticity" (which is the curl of the velocity), only written with setVorticityOutput( true )
+
+        float* m_vorticityForceU; //< the vorticity confinement force after the call to computeVorticityConfinment()
+        float* m_vorticityForceV;
+        float* m_vorticityForceW;
+
+        float* m_velU_prev; //< previous time step's velocity field (UVW as a vector)
+        float* m_velV_prev;
+        float* m_velW_prev;
+
+        unsigned int m_solverIterations; //< number of iterations in inner loop of Gauss-Seidel relaxation
+        size_t m_size;  //< total number of elements in main arrays (density and each elem of velocity)
+        float m_visc;  //< viscosity, used in velocity diffusion
+        float m_diff;  //< material density diffusion
+        float* m_div;  //< temporary storage for divergence field (only used in projection)
+        float* m_pressure; //< temporary storage for pressure field (only used in projection)
+        float m_ambientTemp; //< the temp of the embedding medium that the fluid is in.  (Celsius)
+        float m_tempFactor; //< tuning factor that converts a temperature difference to a buoyancy force.
+        float m_gravityFactor[3]; //< tuning factor that converts particle density to gravitational force
+        float m_vorticityConfinementFactor; //< tuning factor for the amount of vorticity to be restored
+        float m_absorption; //< rate at which light is absorbed per unit density
+        ThreadPoolPtr m_threadPool; //< workers sharing the z-slabs of each solver sweep
+        boost::atomic< unsigned int > m_threadCount; //< set by setThreadCount(), applied by update()
+        const FluidKernels* m_kernels; //< row kernels for the instruction set in use
+        PressureSolverType m_pressureSolver; //< method used by project()
+        float m_gaussSeidelTolerance; //< relative residual at which Gauss-Seidel stops, zero to never check
+        float m_multigridTolerance; //< relative residual at which the multigrid solver stops
+        unsigned int m_pressureIterations; //< iterations used by the last project()
+        float m_pressureResidual; //< relative residual after the last project()
+        float m_pressureResidualMax; //< relative Linf residual after the last project()
+        unsigned int m_pressureResidualInterval; //< Gauss-Seidel iterations between residual checks
+        bool m_isPressureWarmStart; //< keep m_pressure between projections as the initial guess
+        std::vector< PressureSolveStats > m_pressureSolveStats; //< projections of the last update()
+        MultigridSolverPtr m_multigrid; //< created on first use for the current size
+        bool m_isBrickSkipping; //< solver passes only visit active bricks
+        float m_brickThreshold; //< magnitude below which a brick is empty
+        size_t m_bricksX; //< bricks along each axis, covering the interior
+        size_t m_bricksY;
+        size_t m_bricksZ;
+        std::vector< unsigned char > m_brickActive; //< per brick, x fastest; all set without brick skipping
+        std::vector< unsigned char > m_brickOccupied; //< scratch for updateActiveBricks()
+        size_t m_activeBrickCount;
+        bool m_isVorticityOutput; //< write m_vorticity{U,V,W} and m_vorticityMagnitude
+        TripleBuffer< std::vector< float > > m_densitySnapshots; //< completed density frames for other threads
+        float m_targetCFL; //< cells the fastest flow may cross per substep
+        unsigned int m_maxSubsteps; //< most substeps per update()
+        float m_updateBudget; //< milliseconds per update(), zero for unlimited
+        float m_pendingTime; //< simulation time not yet stepped
+        unsigned int m_substepCount; //< substeps taken by the last update()
+        float m_updateMilliseconds; //< wall-clock time of the last update()
+        float m_cfl; //< CFL number of the last update()'s whole time step
+        spark::shared_ptr< boost::interprocess::mapped_region > m_checkpoint; //< copy-on-write backing of the fields from loadCheckpoint()
+        FluidRecorderPtr m_recorder; //< sees every update(), may be NULL
+        char* m_slab; //< one allocation holding every field, each 64-byte aligned
+        size_t m_slabBytes;
+        bool m_isSlabHugePages; //< m_slab was allocated for huge pages
+        bool m_isHugePages; //< allocate the next slab for huge pages
+        bool m_isHalfFloatSnapshots; //< also fill m_halfDensitySnapshots
+        TripleBuffer< std::vector< unsigned short > > m_halfDensitySnapshots; //< binary16 copies of m_densitySnapshots
+        std::vector< ActiveSource > m_sources; //< sources in effect, only used by update()
+        boost::mutex m_sourceMutex; //< guards m_queuedSources and m_isClearingSources
+        std::vector< Source > m_queuedSources; //< added since the last update()
+        std::vector< Source > m_acquiredSources; //< scratch for acquireSources()
+        bool m_isClearingSources; //< clearSources() was called since the last update()
+        boost::atomic< bool > m_isResetPending; //< reset() was called since the last update()
+    };
+    typedef spark::shared_ptr< Fluid > FluidPtr;
+} // end namespace spark
+#endif
@@ -0,0 +1,99 @@
+#ifndef SPARK_FLUIDKERNELS_HPP
+#define SPARK_FLUIDKERNELS_HPP
+
+#include <cstddef>
+
+namespace spark
+{
+    /// Inner-loop kernels of the Fluid solver, one x-row at a time.
+    /// Each kernel processes the n cells starting at flat index ind0
+    /// of arrays laid out as in Fluid::index(); dy and dz are the flat
+    /// offsets to the +y and +z neighbors.
+    /// Several implementations exist (scalar, SSE2, AVX2); use
+    /// fluidKernels() to get the fastest one supported by this CPU.
+    /// Kernels must not allocate or lock, as they are called from
+    /// ThreadPool workers.
+    struct FluidKernels
+    {
+        /// Name of the instruction set, e.g., "AVX2", for logging.
+        const char* name;
+
+        /// Red-black Gauss-Seidel relaxation of one row.
+        /// Updates cells ind0+first, ind0+first+2, ... (first is 0 or 1):
+        ///   x[ind] = invC*( x_prev[ind] + a*(sum of the 6 neighbors of ind) )
+        /// Neighbors are only read from the other color, so cells of
+        /// the color being relaxed never depend on each other.
+        void (*relaxRow)( float* x, const float* x_prev,
+                          size_t ind0, size_t n, size_t first,
+                          ptrdiff_t dy, ptrdiff_t dz,
+                          float a, float invC );
+
+        /// Semi-Lagrangian advection of one row at (j,k), whose first
+        /// cell has x-coordinate i0.  Back-traced positions are clamped
+        /// to [0.5, max{X,Y,Z}] and d_prev is trilinearly interpolated.
+        void (*advectRow)( float* d, const float* d_prev,
+                           const float* vx, const float* vy, const float* vz,
+                           size_t ind0, size_t n,
+                           float i0, float j, float k,
+                           ptrdiff_t dy, ptrdiff_t dz,
+                           float dt0,
+                           float maxX, float maxY, float maxZ );
+
+        /// Vorticity (curl of the velocity) and its magnitude:
+        ///   (wx,wy,wz) = h*( w[ind+dy]-v[ind+dz], u[ind+dz]-w[ind+1], v[ind+1]-u[ind+dy] )
+        ///   mag = |(wx,wy,wz)|
+        void (*vorticityRow)( float* wx, float* wy, float* wz, float* mag,
+                              const float* u, const float* v, const float* w,
+                              size_t ind0, size_t n,
+                              ptrdiff_t dy, ptrdiff_t dz,
+                              float h );
+
+        /// Vorticity confinement force: the normalized central-difference
+        /// gradient N of the vorticity magnitude, crossed with the vorticity,
+        ///   (fx,fy,fz) = f * ( N x (wx,wy,wz) )
+        /// Gradients shorter than 1e-10 (after scaling by h) give zero force.
+        /// The magnitude is read at ind+-1 and ind+-dy of mag, and at ind of
+        /// magBelow and magAbove, the z-1 and z+1 slices.
+        void (*confinementRow)( float* fx, float* fy, float* fz,
+                                const float* magBelow, const float* mag, const float* magAbove,
+                                const float* wx, const float* wy, const float* wz,
+                                size_t ind0, size_t n,
+                                ptrdiff_t dy,
+                                float h, float f );
+
+        /// Trilinear samples of the velocity (vx,vy,vz) at n points.
+        /// Point p has grid coordinates xyz[3p+a]*scale + offset[a] along
+        /// axis a, clamped to [0.5, max{X,Y,Z}] as in advectRow, and its
+        /// velocity is written to out[3p], out[3p+1], out[3p+2].
+        void (*sampleVelocity)( float* out, const float* xyz, size_t n,
+                                const float* vx, const float* vy, const float* vz,
+                                ptrdiff_t dy, ptrdiff_t dz,
+                                float scale,
+                                float offsetX, float offsetY, float offsetZ,
+                                float maxX, float maxY, float maxZ );
+
+        /// Convert n floats to IEEE half floats (binary16), rounding to
+        /// nearest even; out of range values become infinity.
+        void (*floatToHalf)( unsigned short* out, const float* in, size_t n );
+    };
+
+    /// Returns the fastest kernels supported by the executing CPU.
+    /// Selected once, on first call, using CPUID.
+    const FluidKernels& fluidKernels( void );
+
+    /// Portable reference kernels; always available.
+    const FluidKernels& scalarFluidKernels( void );
+
+    /// SSE2 kernels, or NULL if not built for x86.
+    const FluidKernels* sseFluidKernels( void );
+
+    /// AVX2+FMA(+F16C) kernels, or NULL if not built for x86 or the
+    /// CPU/OS does not support them.
+    const FluidKernels* avx2FluidKernels( void );
+
+    /// True if both the CPU and the OS (saved YMM state) support AVX2,
+    /// FMA and F16C.  Always false if not built for x86.
+    bool cpuSupportsAVX2( void );
+} // end namespace spark
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef SPARK_FLUIDRECORDER_HPP
+#define SPARK_FLUIDRECORDER_HPP
+
+#include "Spark.hpp"
+
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/atomic.hpp>
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace spark
+{
+    /// Records fields of a Fluid to an append-only binary file while it
+    /// runs.  Every interval-th update is copied into a ring of buffers
+    /// allocated up front, and a background thread writes the ring out.
+    /// capture() never waits for the writer: when the ring is full the
+    /// frame is dropped and counted instead.
+    ///
+    /// Each frame is two consecutive NPY arrays, so it can be read back
+    /// with repeated numpy.load() calls on one open file:
+    ///  - int64 [frame, update], the frame's number and the number of
+    ///    Fluid updates before it;
+    ///  - float32 (fields, dimZ, dimY, dimX) for the full volume, or
+    ///    (fields, slices, dimZ, dimX) when y-slices are selected, in the
+    ///    order density, temperature, velocity x, y, z.
+    class FluidRecorder
+    {
+    public:
+        /// Fields to record, combined as a bit mask.
+        enum Field
+        {
+            DensityField = 1,
+            TemperatureField = 2,
+            VelocityField = 4   //< all three components
+        };
+
+        /// Start recording fluid to filename, truncating it.  Recorded
+        /// frames are sized for fluid's current dimensions; later frames
+        /// of another size are dropped.  An empty ySlices records the full
+        /// volume.  Throws SparkRunTimeException if the file can't be
+        /// opened.
+        FluidRecorder( const std::string& filename,
+                       const Fluid& fluid,
+                       int fields = DensityField,
+                       unsigned int interval = 1,
+                       const std::vector< size_t >& ySlices = std::vector< size_t >(),
+                       size_t ringSize = 8 );
+
+        /// Writes any frames still in the ring, then closes the file.
+        ~FluidRecorder();
+
+        /// Called after each Fluid update; copies the fields of every
+        /// interval-th call.  Only one thread may call capture().
+        void capture( const Fluid& fluid );
+
+        /// Frames captured, including those dropped.
+        size_t getFrameCount( void ) const { return m_frameCount; }
+
+        /// Frames dropped because the writer fell behind or the size changed.
+        size_t getDroppedFrameCount( void ) const { return m_droppedFrameCount; }
+
+        /// Frames written to the file so far.
+        size_t getWrittenFrameCount( void ) const { return m_writtenFrameCount.load( boost::memory_order_acquire ); }
+    private:
+        struct Frame
+        {
+            long long index[2];          //< frame, update
+            std::vector< float > data;   //< fields, slices or z, y or z, x
+        };
+
+        /// Copy the selected fields of fluid into frame.
+        void copyFields( const Fluid& fluid, Frame& frame ) const;
+        /// Function executed by the writer thread.
+        void writerLoop( void );
+        void writeFrame( const Frame& frame );
+
+        // MSVC doesn't have move semantics, so disable copy-ctor and op=
+        FluidRecorder( const FluidRecorder& ); // No impl
+        FluidRecorder& operator=( const FluidRecorder& ); // No impl
+    private:
+        std::ofstream m_out;
+        int m_fields;
+        unsigned int m_interval;
+        std::vector< size_t > m_ySlices;
+        size_t m_dimX, m_dimY, m_dimZ;  //< size of the Fluid frames are sized for
+        std::string m_indexHeader;       //< NPY header of a frame's index
+        std::string m_dataHeader;        //< NPY header of a frame's fields
+
+        std::vector< Frame > m_ring;
+        boost::atomic< size_t > m_head;  //< frames filled, written by capture()
+        boost::atomic< size_t > m_tail;  //< frames written, written by the writer
+        size_t m_updateCount;
+        size_t m_frameCount;
+        size_t m_droppedFrameCount;
+        boost::atomic< size_t > m_writtenFrameCount;
+
+        boost::mutex m_mutex;
+        boost::condition_variable m_frameReady;
+        bool m_isStopping;
+        boost::thread m_writer;
+    };
+    typedef spark::shared_ptr< FluidRecorder > FluidRecorderPtr;
+} // end namespace spark
+
+#endif
@@ -0,0 +1,149 @@
+#ifndef SPARK_GRIDDBMSPARK_HPP
+#define SPARK_GRIDDBMSPARK_HPP
+
+#include "Spark.hpp"
+#include "DBMSpark.hpp"
+#include "MultigridSolver.hpp"
+#include "ThreadPool.hpp"
+#include "Random.hpp"
+
+#include <vector>
+
+#include <boost/atomic.hpp>
+
+#include <Eigen/Dense>
+
+namespace spark
+{
+    /// Dielectric breakdown model on a grid, as in Kim and Lin's
+    /// lightning.  The potential solves Laplace's equation with the
+    /// aggregate's cells held at 1 and the faces of the grid at 0.  Each
+    /// update() adds one of the cells touching the aggregate (its 26
+    /// neighbors), chosen with probability proportional to
+    /// (1 - potential)^eta, then solves again with Fluid's
+    /// MultigridSolver, starting from the last potential.  One cell
+    /// changes little of it, so few iterations are needed, and their
+    /// cost follows the grid size rather than the aggregate's.
+    ///
+    /// The y=0 face of MultigridSolver copies its neighbors, so the
+    /// first row of cells (j=1) is held at 0 to stand for that face.
+    class GridDBMSpark : public DielectricBreakdownModel
+    {
+    public:
+        /// Grid of Nx*Ny*Nz cells h wide, centered on the origin.
+        GridDBMSpark( size_t Nx, size_t Ny, size_t Nz, float h );
+
+        /// Add the interior cell (i,j,k), 1-based with j >= 2, to the
+        /// aggregate, e.g., a seed.
+        void addAggregateCell( size_t i, size_t j, size_t k );
+
+        /// Add a cell to the aggregate, and solve for the new potential.
+        /// Does nothing once the aggregate has reached a face.
+        virtual void update( double dt ) override;
+
+        /// The aggregate's cells, in the order they were added, with
+        /// the field when they were added.
+        virtual const PointCharges& aggregate( void ) const override { return m_aggregate; }
+
+        /// The cells that could be added next, with their current field.
+        virtual const PointCharges& candidate( void ) const override;
+
+        /// True once the aggregate touches a face of the grid.
+        bool hasStruck( void ) const { return m_hasStruck; }
+
+        /// "Fractal" power of the growth probability, good between 1 and 10.
+        void setEta( float eta ) { m_eta = eta; }
+
+        /// Restart the random sequence that chooses cells; the same seed
+        /// grows the same aggregate.
+        void setSeed( boost::uint64_t seed ) { m_random.seed( seed ); }
+
+        /// Each solve stops at a relative residual of tolerance (see
+        /// MultigridSolver::solve()) or after maxIterations.
+        void setSolverTolerance( float tolerance, unsigned int maxIterations );
+
+        /// Iterations used by the last solve.
+        unsigned int getSolverIterations( void ) const { return m_solverIterations; }
+
+        /// Specify the number of threads that share the solver.
+        /// Zero uses all hardware threads (the default).  Applied by the
+        /// next update().
+        void setThreadCount( unsigned int threadCount );
+
+        /// Returns the number of threads used by the solver.
+        unsigned int getThreadCount( void ) const { return m_threadCount; }
+
+        /// Potential of every cell, laid out as in Fluid::index(),
+        /// including a boundary layer one cell thick.
+        const float* getPotentialData( void ) const { return &m_potential[0]; }
+
+        size_t index( size_t i, size_t j, size_t k ) const
+        {
+            return i + ( m_Nx + 2 ) * ( j + ( m_Ny + 2 ) * k );
+        }
+    private:
+        typedef enum
+        {
+            FreeCell,
+            CandidateCell,
+            AggregateCell,
+            GroundCell       //< the j=1 row, held at 0
+        } CellState;
+
+        /// Solve for m_potential from its current contents.
+        void solve( void );
+
+        /// Add cell ind, free or a candidate no longer in m_candidates,
+        /// to the aggregate.
+        void addToAggregate( size_t ind );
+
+        /// Make the free neighbors of cell ind candidates, and note
+        /// whether it touches a face.
+        void addNeighborCandidates( size_t ind );
+
+        /// Index in m_candidates of a candidate chosen with probability
+        /// proportional to its weight.
+        size_t selectCandidate( void );
+
+        Eigen::Vector3f cellPosition( size_t ind ) const;
+
+        /// Field at cell ind, the central difference of the potential
+        /// (so it points away from the aggregate).
+        Eigen::Vector3f cellField( size_t ind ) const;
+
+        // MSVC doesn't have move semantics, so disable copy-ctor and op=
+        GridDBMSpark( const GridDBMSpark& ); // No impl
+        GridDBMSpark& operator=( const GridDBMSpark& ); // No impl
+    private:
+        size_t m_Nx, m_Ny, m_Nz;
+        float m_h;                          //< cell width
+        float m_eta;
+        float m_tolerance;
+        unsigned int m_maxIterations;
+        unsigned int m_solverIterations;
+        bool m_hasStruck;
+        bool m_isSolved;                    //< m_potential is current
+
+        std::vector< float > m_potential;
+        std::vector< float > m_zero;        //< Laplace's right-hand side
+        std::vector< unsigned char > m_cellState;
+        std::vector< size_t > m_candidates; //< cell indices
+        std::vector< double > m_weightSums; //< scratch for selectCandidate()
+
+        PointCharges m_aggregate;
+        mutable PointCharges m_candidateView;
+        mutable bool m_isCandidateViewStale;
+
+        Random m_random;
+        MultigridSolver m_solver;
+        ThreadPoolPtr m_threadPool;
+        boost::atomic< unsigned int > m_threadCount; //< m_threadPool's size from the next update()
+    };
+    typedef spark::shared_ptr< GridDBMSpark > GridDBMSparkPtr;
+
+    /// Setup a grid DBM of N^3 cells spanning [-halfWidth, halfWidth]^3,
+    /// seeded at its center, the grid counterpart of buildSpark_pointInBall().
+    GridDBMSparkPtr buildGridSpark_pointInBox( size_t N, float halfWidth );
+} // end namespace spark
+
+#endif
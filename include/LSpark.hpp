@@ -12,6 +12,7 @@
 
 #include "Spark.hpp"
 #include "VelocityFieldInterface.hpp"
+#include "Random.hpp"
 
 #include <Eigen/Dense>
 #include <vector>
@@ -82,9 +83,12 @@ namespace spark
 
         /// Returns the total length of the spark, begin to end.
         float length( void ) const;
+
+        /// Restart the random sequence used by create() and update().
+        void setSeed( boost::uint64_t seed ) { m_random.seed( seed ); }
     private:
-        /// Returns a float in [-1, 1]
-        static float unitRandom( void );
+        /// Returns a float in [-1, 1)
+        float unitRandom( void ) { return m_random.uniform( -1.0f, 1.0f ); }
         /// Split the segment at a_index, replacing m_segmetn[a_index]
         /// with a new leg, and adding one or more additional segments to
         /// m_segments.  a_forkProb specifies the probability that this
@@ -104,6 +108,7 @@ namespace spark
         bool isTerminalSegment( size_t a_index ) const;
         Segments m_segments;
         ConstProjectionPtr m_camera;
+        Random m_random;
     };
     typedef spark::shared_ptr< LSpark > LSparkPtr;
 }
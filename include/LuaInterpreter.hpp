@@ -5,6 +5,7 @@
 #include "ShaderManager.hpp"
 #include "SceneFacade.hpp"
 #include "input/Input.hpp"
+#include "Random.hpp"
 
 #include "lua.hpp"
 #include "luabind/luabind.hpp"
@@ -95,6 +96,26 @@ namespace spark
     inline float mat4_at( glm::mat4& m, int i, int j ) { return m[i][j]; }
     inline void mat4_set( glm::mat4& m, int i, int j, float x ) { m[i][j] = x; }
     /////////////////////////////////////////////////////////////////////
+
+    /// Pseudo member function for TissueMesh::accumulateElectricalEnergy()
+    /// taking a lua table (array) of vec2 contact points.
+    void TissueMesh_accumulateElectricalEnergyAt( TissueMesh* tissue,
+                                                  const luabind::object& contacts,
+                                                  float voltage,
+                                                  float current,
+                                                  float dutyCycle,
+                                                  float radiusOfContact,
+                                                  float dt );
+
+    /// Pseudo member function for Random::seed(), as lua numbers don't
+    /// convert to 64-bit integers.
+    inline void Random_seed( Random* random, unsigned int seed ) { random->seed( seed ); }
+
+    /// Pseudo member function for Random::fillUniform(), setting
+    /// table[1..n] to uniforms in [lo,hi).
+    void Random_fillUniform( Random* random,
+                             const luabind::object& table,
+                             int n, float lo, float hi );
     
     inline bool isWindows( void )
     {
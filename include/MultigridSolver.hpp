@@ -0,0 +1,138 @@
+#ifndef SPARK_MULTIGRIDSOLVER_HPP
+#define SPARK_MULTIGRIDSOLVER_HPP
+
+#include "Spark.hpp"
+#include "ThreadPool.hpp"
+#include "FluidKernels.hpp"
+
+#include <vector>
+
+namespace spark
+{
+    /// Multigrid-preconditioned conjugate gradient solver for Fluid's
+    /// pressure Poisson equation,
+    ///   6 x[i,j,k] - (sum of the 6 neighbors of x[i,j,k]) = b[i,j,k]
+    /// on an Nx*Ny*Nz cell-centered grid with a one-cell boundary laid out as
+    /// in Fluid::index().  Boundary conditions match
+    /// Fluid::enforceConcentrationBoundary( 0, ... ): x is zero on every
+    /// face except y=0, where it is copied from the first interior row.
+    ///
+    /// The preconditioner is one geometric multigrid V-cycle: red-black
+    /// Gauss-Seidel smoothing (the same FluidKernels::relaxRow as
+    /// Fluid::linearSolve), trilinear prolongation and its transpose as
+    /// restriction.  All axes are coarsened together, odd sizes to (N+1)/2.  The coarse
+    /// grids only approximate Fluid's boundary, which would stall a
+    /// plain V-cycle iteration, but CG converges with any symmetric
+    /// preconditioner, so post-smoothing reverses the color order to
+    /// keep the V-cycle symmetric.
+    ///
+    /// Cells inside the grid may also be held at fixed values (see
+    /// addFixedCell()).  CG then runs on the remaining cells, with the
+    /// fixed cells zeroed from every residual, direction and
+    /// preconditioned residual.  The coarse levels don't see them, so
+    /// the preconditioner is weaker near them but still symmetric.
+    class MultigridSolver
+    {
+    public:
+        /// Build the grid hierarchy for Nx, Ny, Nz interior cells.
+        MultigridSolver( size_t Nx, size_t Ny, size_t Nz );
+
+        /// Number of interior cells along x of the finest level.
+        size_t sizeX( void ) const { return m_levels.front().nx; }
+        size_t sizeY( void ) const { return m_levels.front().ny; }
+        size_t sizeZ( void ) const { return m_levels.front().nz; }
+
+        /// Number of grid levels, including the finest.
+        size_t levelCount( void ) const { return m_levels.size(); }
+
+        /// Solve for x, using its current contents as the initial guess,
+        /// until ||b - Ax|| <= tolerance * ||b|| (L2) or maxIterations
+        /// CG iterations (one V-cycle each) have run.
+        /// Only interior cells and faces of x are written.  With fixed
+        /// cells, the norms only cover the other cells, and b includes
+        /// the fixed cells' part of Ax, so a zero b still has a solution.
+        /// Returns the number of iterations used.
+        unsigned int solve( float* x, const float* b,
+                            float tolerance, unsigned int maxIterations,
+                            ThreadPool& pool, const FluidKernels& kernels );
+
+        /// Relative L2 residual, ||b - Ax|| / ||b||, at the end of the last solve().
+        float getResidual( void ) const { return m_residual; }
+
+        /// Hold the interior cell at flat index ind (as in Fluid::index())
+        /// at its value in x during later solve()s: a Dirichlet condition
+        /// inside the grid, such as an electrode.
+        void addFixedCell( size_t ind );
+
+        /// Release every cell held by addFixedCell().
+        void clearFixedCells( void ) { m_fixedCells.clear(); }
+
+        /// Number of cells held by addFixedCell().
+        size_t fixedCellCount( void ) const { return m_fixedCells.size(); }
+
+        /// Gauss-Seidel sweeps before and after each coarse-grid correction.
+        /// Keep them equal, as CG needs a symmetric preconditioner.
+        void setSmoothingIterations( unsigned int smoothIterations )
+        {
+            m_preSmooth = smoothIterations;
+            m_postSmooth = smoothIterations;
+        }
+    private:
+        struct Level
+        {
+            size_t nx, ny, nz;        //< interior cells per dimension
+            size_t dimX, dimY;        //< nx+2, ny+2, cells per row and column including the boundary
+            std::vector< float > x;   //< solution (the correction on coarse levels)
+            std::vector< float > b;   //< right-hand side
+            std::vector< float > r;   //< residual
+
+            size_t index( size_t i, size_t j, size_t k ) const
+            {
+                return i + dimX*(j + dimY*k);
+            }
+        };
+
+        /// Finest level x = one V-cycle applied to finest level b, from zero.
+        void precondition( void );
+        void vCycle( size_t level );
+        /// Red-black sweeps of level.x; reversed sweeps relax black before red.
+        void relax( Level& level, unsigned int iterations, bool isReversed );
+        /// ax = A x on the interior; boundary of x must be set
+        void applyOperator( const Level& level, const float* x, float* ax );
+        /// out = a + alpha*b and, if accumulate is given, accumulate += gamma*c.
+        /// Returns ||out||^2.  out may alias a or b.
+        double axpy( const Level& level,
+                     const float* a, float alpha, const float* b, float* out,
+                     const float* c, float gamma, float* accumulate );
+        /// Dot product over the interior cells
+        double dot( const Level& level, const float* a, const float* b );
+        /// coarse.b = restriction of fine.r
+        void restrictResidual( const Level& fine, Level& coarse );
+        /// fine.x += prolongation of coarse.x
+        void prolongAndCorrect( const Level& coarse, Level& fine );
+        void enforceBoundary( const Level& level, float* x );
+        /// Zero the fixed cells of the finest level vector v.
+        void zeroFixedCells( float* v ) const;
+
+        // MSVC doesn't have move semantics, so disable copy-ctor and op=
+        MultigridSolver( const MultigridSolver& ); // No impl
+        MultigridSolver& operator=( const MultigridSolver& ); // No impl
+    private:
+        std::vector< Level > m_levels;
+        std::vector< float > m_direction; //< CG search direction p
+        std::vector< float > m_product;   //< A p
+        std::vector< double > m_slabSums; //< per-z-slab partial sums for dot products
+        std::vector< size_t > m_fixedCells; //< finest level indices, see addFixedCell()
+        unsigned int m_preSmooth;
+        unsigned int m_postSmooth;
+        unsigned int m_coarsestIterations;
+        float m_residual;
+
+        // valid during solve()
+        ThreadPool* m_pool;
+        const FluidKernels* m_kernels;
+    };
+    typedef spark::shared_ptr< MultigridSolver > MultigridSolverPtr;
+} // end namespace spark
+
+#endif
@@ -42,7 +42,7 @@ namespace spark
       public Updateable
     {
     public:
-        PointSparkRenderable( DBMSparkPtr spark,
+        PointSparkRenderable( DielectricBreakdownModelPtr spark,
                               TextureManagerPtr tm,
                               ShaderManagerPtr sm );
         virtual ~PointSparkRenderable() {}
@@ -52,7 +52,7 @@ namespace spark
         virtual void loadTextures() {}
         virtual void loadShaders() {}
     private:
-        DBMSparkPtr m_spark;
+        DielectricBreakdownModelPtr m_spark;
         std::vector< PointSparkVertex > m_pointData;
     };
     typedef spark::shared_ptr< PointSparkRenderable > PointSparkRenderablePtr;
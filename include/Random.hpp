@@ -0,0 +1,67 @@
+#ifndef SPARK_RANDOM_HPP
+#define SPARK_RANDOM_HPP
+
+#include "Spark.hpp"
+
+#include <boost/cstdint.hpp>
+
+namespace spark
+{
+    /// xoshiro128** pseudo-random generator (Blackman and Vigna), for
+    /// simulations that own their randomness instead of sharing
+    /// std::rand()'s global, locked state.  The same seed always gives
+    /// the same sequence, on any platform.  Not thread-safe; give each
+    /// simulation (or thread) its own.
+    class Random
+    {
+    public:
+        /// Seeded with seed, see seed().
+        explicit Random( boost::uint64_t seed = 1 );
+
+        /// Restart the sequence.  Every seed, including 0, is valid;
+        /// nearby seeds give unrelated sequences.
+        void seed( boost::uint64_t seed );
+
+        /// Next 32 random bits.
+        boost::uint32_t next( void )
+        {
+            const boost::uint32_t result = rotl( m_s[1] * 5, 7 ) * 9;
+            const boost::uint32_t t = m_s[1] << 9;
+            m_s[2] ^= m_s[0];
+            m_s[3] ^= m_s[1];
+            m_s[1] ^= m_s[2];
+            m_s[0] ^= m_s[3];
+            m_s[2] ^= t;
+            m_s[3] = rotl( m_s[3], 11 );
+            return result;
+        }
+
+        /// Uniform in [0,1), from the top 24 bits so every value is exact.
+        float uniform( void ) { return ( next() >> 8 ) * ( 1.0f / 16777216.0f ); }
+
+        /// Uniform in [lo,hi).
+        float uniform( float lo, float hi ) { return lo + ( hi - lo ) * uniform(); }
+
+        /// Uniform in [0,1), with 53 random bits.
+        double uniformDouble( void )
+        {
+            const boost::uint64_t hi = next() >> 5;
+            const boost::uint64_t lo = next() >> 6;
+            return ( hi * 67108864.0 + lo ) * ( 1.0 / 9007199254740992.0 );
+        }
+
+        /// Fill out[0..n) with uniforms in [lo,hi), the same values as
+        /// n calls to uniform( lo, hi ).
+        void fillUniform( float* out, size_t n, float lo = 0.0f, float hi = 1.0f );
+    private:
+        static boost::uint32_t rotl( boost::uint32_t x, int k )
+        {
+            return ( x << k ) | ( x >> ( 32 - k ) );
+        }
+
+        boost::uint32_t m_s[4];
+    };
+    typedef spark::shared_ptr< Random > RandomPtr;
+} // end namespace spark
+
+#endif
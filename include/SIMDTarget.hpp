@@ -0,0 +1,32 @@
+#ifndef SPARK_SIMDTARGET_HPP
+#define SPARK_SIMDTARGET_HPP
+
+// Shared by the SIMD kernel files (FluidKernelsSIMD.cpp,
+// ChargeFieldKernelsSIMD.cpp).  Each function there carries its
+// instruction set as a target attribute (GCC/Clang) rather than relying
+// on per-file compiler flags, so the files build with the project-wide
+// flags and AVX2 code only runs after cpuSupportsAVX2() has checked
+// CPUID.  MSVC allows the intrinsics without flags.
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SPARK_SIMD_X86 1
+#endif
+
+#ifdef SPARK_SIMD_X86
+
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SPARK_TARGET_SSE2 __attribute__((target("sse2")))
+#define SPARK_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#else
+#define SPARK_TARGET_SSE2
+#define SPARK_TARGET_AVX2
+#endif
+
+#endif // SPARK_SIMD_X86
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef SPARK_THREADPOOL_HPP
+#define SPARK_THREADPOOL_HPP
+
+#include "Spark.hpp"
+
+#include <boost/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+
+#include <functional>
+#include <vector>
+
+namespace spark
+{
+    /// Fixed set of worker threads for data-parallel loops over a range,
+    /// e.g., z-slabs of a Fluid volume.
+    /// parallelFor() splits the range into one contiguous chunk per thread
+    /// and blocks until every chunk has been processed.  The calling
+    /// thread processes the first chunk itself, so a pool of one thread
+    /// creates no workers and simply runs the task inline.
+    /// Chunk boundaries depend only on the range and threadCount(), so
+    /// a given chunk is always handled by the same worker.
+    class ThreadPool
+    {
+    public:
+        /// Task executed over the half-open range [begin, end).
+        typedef std::function< void ( size_t begin, size_t end ) > RangeTask;
+
+        /// Create a pool with threadCount threads (including the caller).
+        /// A threadCount of zero uses hardwareThreadCount().
+        explicit ThreadPool( unsigned int threadCount = 0 );
+        ~ThreadPool();
+
+        /// Number of threads, including the calling thread, that share
+        /// the work of parallelFor().
+        unsigned int threadCount( void ) const { return m_threadCount; }
+
+        /// Execute task over [begin, end) split across all threads.
+        /// Returns once every chunk has finished.
+        /// Not re-entrant: task must not call parallelFor() on this pool.
+        void parallelFor( size_t begin, size_t end, const RangeTask& task );
+
+        /// Returns the number of hardware threads, or 1 if unknown.
+        static unsigned int hardwareThreadCount( void );
+    private:
+        /// Function executed by each worker thread.
+        void workerLoop( unsigned int chunkIndex );
+
+        /// Returns the start of chunk c when [begin,end) is split
+        /// into m_threadCount chunks.
+        size_t chunkBegin( unsigned int c ) const
+        {
+            return m_begin + ( (m_end - m_begin) * c ) / m_threadCount;
+        }
+
+        // MSVC doesn't have move semantics, so disable copy-ctor and op=
+        ThreadPool( const ThreadPool& ); // No impl
+        ThreadPool& operator=( const ThreadPool& ); // No impl
+    private:
+        unsigned int m_threadCount;
+        boost::thread_group m_workers;
+
+        boost::mutex m_mutex;
+        boost::condition_variable m_workReady;
+        boost::condition_variable m_workDone;
+
+        const RangeTask* m_task;       //< current task, valid during parallelFor()
+        size_t m_begin;                //< current range begin
+        size_t m_end;                  //< current range end
+        unsigned long m_generation;    //< incremented for each parallelFor()
+        unsigned int m_pendingWorkers; //< workers yet to finish current task
+        bool m_isStopping;
+    };
+    typedef spark::shared_ptr< ThreadPool > ThreadPoolPtr;
+} // end namespace spark
+
+#endif
@@ -6,9 +6,12 @@
 #include "Updateable.hpp"
 #include "Renderable.hpp"
 #include "Mesh.hpp"
+#include "ThreadPool.hpp"
 
 #include <limits>
 
+#include <boost/atomic.hpp>
+
 namespace spark
 {
     /// 2D model of tissue temperature that provides methods for adding
@@ -18,6 +21,7 @@ namespace spark
     class TissueMesh
     : public Updateable
     {
+    public:
         // Possible states/conditions the tissue can be in 
         // (not a enum class due to VS2010)
         enum TissueCondition { normalTissue, 
@@ -25,7 +29,26 @@ namespace spark
                                vaporizingTissue, 
                                vaporizedTissue,
                                charredTissue };
-    public:
+
+        /// A change of condition of one cell during update().  A cell may
+        /// change more than once in an update (e.g., dessicated then
+        /// charred); each change is an event, in order.
+        struct ConditionEvent
+        {
+            ConditionEvent( size_t aIndex, unsigned char aOld, unsigned char aNew )
+            : index( aIndex ), oldCondition( aOld ), newCondition( aNew ) {}
+            size_t index;               //< cell, as x + (heatDim+2)*y
+            unsigned char oldCondition; //< TissueCondition before
+            unsigned char newCondition; //< TissueCondition after
+        };
+
+        /// Methods for integrating the heat diffusion.
+        typedef enum
+        {
+            ExplicitThermalSolver, //< 100 explicit 9-point substeps per update()
+            ImplicitThermalSolver  //< one backward-Euler ADI step per update()
+        } ThermalSolverType;
+
         TissueMesh( const RenderableName& name,
                     TextureManagerPtr tm,
                     float totalLengthMeters,
@@ -46,7 +69,11 @@ namespace spark
         /// applied at the location x,y.
         /// radiusOfContact assumes a circle of contact centered at x,y
         /// Elements inside the radius are given energy directly,
-        /// elements outside receive dissipating energy.
+        /// elements outside receive energy falling off with the cube of
+        /// their distance from the contact's edge (at least half a cell).
+        /// The falloff is cut off where the energy left beyond it is under
+        /// 1% of what the contact deposits, so the total stays within 1%
+        /// of heating every element.
         void accumulateElectricalEnergy( float x, float y,
                                          float voltage,
                                          float current,
@@ -54,9 +81,21 @@ namespace spark
                                          float radiusOfContact,
                                          float dt );
 
+        /// As accumulateElectricalEnergy(), for a contact spread over
+        /// several points (e.g., jittered placements).  The points share
+        /// the energy of one contact equally.
+        void accumulateElectricalEnergy( const std::vector< glm::vec2 >& contacts,
+                                         float voltage,
+                                         float current,
+                                         float dutyCycle,
+                                         float radiusOfContact,
+                                         float dt );
+
         /// Returns the handle/name of the texture holding the temperature 
         /// map.  Note that 310.15 Kelvin is typical body temperature and should
-        /// be considered the baseline temperature.
+        /// be considered the baseline temperature.  The texture is half
+        /// float, so it resolves 0.25 K steps near body temperature and
+        /// 0.5 K above 512 K.
         const TextureName& getTempMapTextureName( void ) const;
         
         /// Returns the handle/name of the map holding the height of the
@@ -74,13 +113,60 @@ namespace spark
         /// equal mass of water has been injected) the tissue becomes charred.
         const TextureName& getConditionMapTextureName( void ) const;
 
-        /// Adds positions of each cell currently vaporizing.
+        /// Returns the condition changes made by the last update(), in
+        /// cell order within each tile, tiles in increasing order.
+        const std::vector< ConditionEvent >& getConditionEvents( void ) const { return m_conditionEvents; }
+
+        /// Adds positions of up to maxLocations cells that started
+        /// vaporizing in the last update(), spread evenly over them when
+        /// there are more.
         /// Positions in "world" scale with center of tissue at 0,0
-        void acquireVaporizingLocations( std::vector<glm::vec2>& vaping );
+        void acquireVaporizingLocations( std::vector<glm::vec2>& vaping,
+                                         size_t maxLocations = 32 ) const;
+
+        /// Provides "world" x,y coordinates for cell at index ind.
+        /// Assumes center (m_N/2)+0.5 is located at the origin
+        void indexToPosition( size_t ind, float* pX, float* pY ) const;
 
         /// Returns the real-world units (meters) length of one side of
         /// the tissue sample, not including the boundary elements.
         float totalLengthPerSide( void ) const;
+
+        /// Returns the temperature map, (heatDim+2)^2 values in Kelvin
+        /// with x fastest, including the boundary elements.
+        const float* getTemperatureData( void ) const { return &(*m_currTempMap)[0]; }
+
+        /// Returns the TissueCondition of each cell, laid out as
+        /// getTemperatureData().
+        const unsigned char* getConditionData( void ) const { return &m_tissueCondition[0]; }
+
+        /// Returns the heat (joules) accumulated since the last update(),
+        /// laid out as getTemperatureData().
+        const double* getHeatData( void ) const { return &m_heatMap[0]; }
+
+        /// Specify the number of threads that share the diffusion sweeps.
+        /// Zero uses all hardware threads (the default).  Takes effect at
+        /// the start of the next update(), so an update() already running
+        /// on another thread keeps its pool.
+        void setThreadCount( unsigned int threadCount );
+
+        /// Returns the number of threads the next update() will use.
+        unsigned int getThreadCount( void ) const { return m_threadCount; }
+
+        /// Select the integrator for heat diffusion.  The implicit solver
+        /// is stable at any time step and costs about as much as two
+        /// explicit substeps.  Its error is first order in the time step:
+        /// where a frame diffuses heat by about half a cell (6*a*dt/h^2
+        /// near 0.4), a heated spot several cells across stays within 5%
+        /// of the explicit solver's rise above baseline, though a single
+        /// heated cell can peak 20% higher.  Defaults to
+        /// ExplicitThermalSolver.
+        void setThermalSolver( ThermalSolverType solver ) { m_thermalSolver = solver; }
+
+        /// Returns the number of tiles the last update() computed: those
+        /// that were heated or away from baseline temperature, plus a
+        /// one-tile halo.  The rest of the map is at baseline and skipped.
+        size_t getActiveTileCount( void ) const { return m_updateTiles.size(); }
     protected:
         virtual void attachShaderAttributes( GLuint shaderIndex ) { }
 
@@ -112,27 +198,72 @@ namespace spark
         /// Unites: J/kg
         float latentHeatOfVaporization( size_t x, size_t y ) const;
     private:
-        struct BoundingBox
+        /// A run of consecutive update tiles along a row (or column) of
+        /// tiles, as the cells it spans in both directions.
+        struct TileRun
         {
-            int minX;
-            int minY;
-            int maxX;
-            int maxY;
-            BoundingBox() { reset(); }
-            void reset() 
-            { 
-                minX = minY = std::numeric_limits<int>::max();
-                maxX = maxY = 0; }
-            /// Extend the region to encompass the given point.
-            void addPoint( int x, int y )
-            {
-                minX = std::min( x, minX ); 
-                minY = std::min( y, minY ); 
-                maxX = std::max( x, maxX ); 
-                maxY = std::max( y, maxY ); 
-            }
+            size_t begin, end;         //< cells along the run
+            size_t lineBegin, lineEnd; //< rows (or columns) it spans
         };
 
+        /// Run iterations explicit 9-point diffusion substeps from
+        /// m_currTempMap, leaving the result in m_currTempMap.  The update
+        /// tiles are spread across m_threadPool, and each tile runs several
+        /// substeps on a local copy (with a halo as wide as the substeps)
+        /// before writing back.
+        void diffuseTemperature( size_t iterations, float k );
+
+        /// One implicit step of m_currTempMap, in place: solve
+        /// (1 - r d2/dx2)(1 - r d2/dy2) T' = T as a tridiagonal system
+        /// along each row, then each column, of every run of update tiles.
+        /// r is the diffusivity times dt over the squared cell size.
+        void diffuseTemperatureImplicit( float r );
+
+        /// Interior cells [*x0,*x1) x [*y0,*y1) of tile
+        void tileBounds( size_t tile, size_t* x0, size_t* y0, size_t* x1, size_t* y1 ) const;
+
+        /// Returns the tile holding the cell at ind; boundary elements
+        /// belong to the tile next to them.
+        size_t tileFromIndex( size_t ind ) const;
+
+        /// Add scale times the electrical falloff around world position
+        /// x,y to m_heatMap, for the radius m_falloffTable was built for.
+        void depositElectricalEnergy( float x, float y, float scale );
+
+        /// Rebuild m_falloffTable and its cutoff for radiusOfContact,
+        /// unless it was built for that radius.
+        void updateFalloffTable( float radiusOfContact );
+
+        /// Queue uploads of the tiles of each map changed since the last
+        /// update(), then clear their dirty flags.
+        void queueDirtyTileUploads( void );
+
+        /// The texture rectangles of the tiles flagged in isDirty, which
+        /// is cleared.  Edge tiles take in the boundary cells next to
+        /// them, so m_N x m_N is covered when all are flagged.
+        std::vector< TextureTile > takeDirtyTextureTiles( std::vector< unsigned char >& isDirty );
+        /// Unit tests collect the dirty tiles without a TextureManager
+        friend struct TissueMeshTestAccess;
+
+        /// Fill m_updateTiles with the active and heated tiles and their
+        /// neighbors, then clear the heated flags.
+        void gatherUpdateTiles( void );
+
+        /// Scale each update tile's difference from baseline by decay.
+        /// A tile whose cells all end up near baseline, with none
+        /// vaporizing, is set to baseline exactly and marked inactive, so
+        /// later updates can skip it.
+        void coolUpdateTiles( float decay );
+
+        /// Set the condition of cell ind, in tile, recording the event
+        /// and marking the tile for upload.
+        void setCondition( size_t ind, size_t tile, TissueCondition condition )
+        {
+            m_conditionEvents.push_back( ConditionEvent( ind, m_tissueCondition[ind], condition ) );
+            m_tissueCondition[ind] = condition;
+            m_isConditionTileDirty[tile] = 1;
+        }
+
         void swapTempMaps( void )
         {
             std::vector<float>* tmp = m_currTempMap;
@@ -160,10 +291,6 @@ namespace spark
         /// Inverse operation of indexToPosition()
         size_t indexFromXY( float x, float y ) const;
 
-        /// Provides "world" x,y coordinates for cell at index ind.
-        /// Assumes center (m_N/2)+0.5 is located at the origin
-        void indexToPosition( size_t ind, float* pX, float* pY ) const;
-        
         TextureName m_tempTextureName;
         TextureName m_conditionTextureName;
         TextureName m_vaporizationDepthMapTextureName;
@@ -188,12 +315,43 @@ namespace spark
         /// integer component gives the condition of the tissue (see TissueCondition)
         /// fractional component gives how long 
         std::vector< unsigned char > m_tissueCondition;
-        BoundingBox m_tissueConditionUpdateBounds;
+        /// Condition changes of the last update()
+        std::vector< ConditionEvent > m_conditionEvents;
+        /// Tiles per side of the interior cells
+        size_t m_tilesPerSide;
+        /// Per tile, set while any cell is away from baseline temperature
+        /// or part way through vaporizing
+        std::vector< unsigned char > m_isTileActive;
+        /// Per tile, set when heat was added since the last update()
+        std::vector< unsigned char > m_isTileHeated;
+        /// Tiles update() computes, in increasing order
+        std::vector< size_t > m_updateTiles;
+        /// Per tile, set when the cells of m_tissueCondition,
+        /// m_vaporizationDepthMap or the temperature map changed since
+        /// they were last queued for upload
+        std::vector< unsigned char > m_isConditionTileDirty;
+        std::vector< unsigned char > m_isDepthTileDirty;
+        std::vector< unsigned char > m_isTempTileDirty;
+        /// Half float copy of *m_currTempMap, current for every tile
+        /// uploaded
+        std::vector< unsigned short > m_tempHalfMap;
+        /// Electrical heating weight per unit of current^2 * dt, sampled
+        /// along the squared distance from the contact center in cells
+        std::vector< float > m_falloffTable;
+        /// Contact radius (meters) m_falloffTable was built for
+        float m_falloffRadius;
+        /// Squared distance (cells) beyond which no energy is deposited
+        float m_falloffCutoff2;
         /// Holds the depth of tissue removed due to vaporization effects.
         std::vector< float > m_vaporizationDepthMap;
         
         /// Iteration count for SOR diffusion calcs
         size_t m_diffusionIters;
+        /// Workers sharing the tiles of each diffusion sweep
+        ThreadPoolPtr m_threadPool;
+        /// Requested by setThreadCount(), m_threadPool's size from the next update()
+        boost::atomic< unsigned int > m_threadCount;
+        ThermalSolverType m_thermalSolver;
         /// Overshoot factor for SOR, must be 1.0 or more and less than 2.0
         /// 1.0 equivalent to Guass-Seidel; 2.0 is unstable!
         //double m_SORovershoot;
@@ -0,0 +1,70 @@
+#ifndef SPARK_TRIPLEBUFFER_HPP
+#define SPARK_TRIPLEBUFFER_HPP
+
+#include <boost/atomic.hpp>
+
+namespace spark
+{
+    /// Lock-free handoff of complete frames from one writer thread to one
+    /// reader thread.
+    /// The writer fills getBack() and publish()es it; the reader calls
+    /// acquire() and then reads getFront().  Three buffers let each side
+    /// own one while the third holds the newest published frame, so
+    /// neither side ever waits for the other.  Frames published faster
+    /// than they are acquired are dropped, oldest first.
+    template< typename T >
+    class TripleBuffer
+    {
+    public:
+        TripleBuffer( void )
+        : m_middle( 1 ),
+          m_back( 0 ),
+          m_front( 2 )
+        { }
+
+        /// Writer: the buffer to fill with the next frame.
+        T& getBack( void ) { return m_buffers[m_back]; }
+
+        /// Writer: make getBack() the newest frame, and take over the
+        /// buffer it replaces (which holds an older frame) as getBack().
+        void publish( void )
+        {
+            m_back = m_middle.exchange( m_back | isFreshBit, boost::memory_order_acq_rel )
+                     & indexMask;
+        }
+
+        /// Reader: switch getFront() to the newest published frame.
+        /// Returns false, keeping the current front, if nothing was
+        /// published since the last acquire().
+        bool acquire( void )
+        {
+            if( !( m_middle.load( boost::memory_order_relaxed ) & isFreshBit ) )
+            {
+                return false;
+            }
+            m_front = m_middle.exchange( m_front, boost::memory_order_acq_rel ) & indexMask;
+            return true;
+        }
+
+        /// Reader: the frame taken by the last acquire().
+        const T& getFront( void ) const { return m_buffers[m_front]; }
+
+        /// Direct access to all three buffers, e.g., to resize them.
+        /// Only safe while neither the reader nor the writer is active.
+        T& getBuffer( unsigned int i ) { return m_buffers[i]; }
+    private:
+        static const unsigned int indexMask = 3;
+        static const unsigned int isFreshBit = 4;
+
+        // MSVC doesn't have move semantics, so disable copy-ctor and op=
+        TripleBuffer( const TripleBuffer& ); // No impl
+        TripleBuffer& operator=( const TripleBuffer& ); // No impl
+
+        T m_buffers[3];
+        boost::atomic< unsigned int > m_middle; //< index of the newest frame, plus isFreshBit until acquired
+        unsigned int m_back;  //< owned by the writer
+        unsigned int m_front; //< owned by the reader
+    };
+} // end namespace spark
+
+#endif
@@ -19,6 +19,20 @@ namespace spark
     {
     public:
         virtual Eigen::Vector3f velocityAtPosition( const Eigen::Vector3f& pos ) = 0;
+
+        /// Velocities at n positions, x,y,z interleaved in both xyz and
+        /// outVelocity.  Override to sample many points faster than one
+        /// velocityAtPosition() call each.
+        virtual void velocityAtPositions( const float* xyz, size_t n, float* outVelocity )
+        {
+            for( size_t p = 0; p < n; ++p )
+            {
+                const Eigen::Vector3f v = velocityAtPosition( Eigen::Vector3f( xyz[3*p], xyz[3*p+1], xyz[3*p+2] ) );
+                outVelocity[3*p]   = v.x();
+                outVelocity[3*p+1] = v.y();
+                outVelocity[3*p+2] = v.z();
+            }
+        }
     };
     typedef spark::shared_ptr< VelocityFieldInterface > VelocityFieldInterfacePtr;
 } // end namespace spark
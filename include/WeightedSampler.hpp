@@ -0,0 +1,51 @@
+#ifndef SPARK_WEIGHTEDSAMPLER_HPP
+#define SPARK_WEIGHTEDSAMPLER_HPP
+
+#include "Spark.hpp"
+
+#include <vector>
+
+namespace spark
+{
+    /// Non-negative weights of n items, kept in a Fenwick tree of their
+    /// prefix sums so that setting a weight, appending or removing the
+    /// last item, and drawing an item with probability proportional to
+    /// its weight are each O(log n).
+    class WeightedSampler
+    {
+    public:
+        WeightedSampler( void );
+
+        /// Replace every weight, in O(n).
+        void assign( const std::vector< float >& weights );
+
+        void clear( void );
+
+        size_t size( void ) const { return m_weights.size(); }
+
+        float weight( size_t i ) const { return m_weights[i]; }
+
+        /// Sum of every weight.
+        double total( void ) const;
+
+        void set( size_t i, float weight );
+        void pushBack( float weight );
+        void popBack( void );
+
+        /// The item i whose weights before it sum to at most u * total(),
+        /// and including it to more, for u in [0,1).  Items of zero
+        /// weight are never drawn while others have weight.
+        /// Precondition: size() > 0.
+        size_t sample( double u ) const;
+    private:
+        /// Sum of the first count weights.
+        double prefixSum( size_t count ) const;
+
+        std::vector< float > m_weights;
+        /// Fenwick tree, 1-based: m_tree[k] sums the weights of items
+        /// [k - lowbit(k), k)
+        std::vector< double > m_tree;
+    };
+} // end namespace spark
+
+#endif
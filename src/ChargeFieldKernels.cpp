@@ -0,0 +1,64 @@
+#include "ChargeFieldKernels.hpp"
+#include "Spark.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    void addChargeFieldScalar( float* phiX, float* phiY, float* phiZ,
+                               float* mag, float* minMag, float* maxMag,
+                               const float* x, const float* y, const float* z, size_t n,
+                               float cx, float cy, float cz, float q, float h )
+    {
+        for( size_t i = 0; i < n; ++i )
+        {
+            const float rx = x[i] - cx;
+            const float ry = y[i] - cy;
+            const float rz = z[i] - cz;
+            const float invD = 1.0f / std::sqrt( rx*rx + ry*ry + rz*rz );
+            const float s = ( 1.0f - h*invD ) * q * invD;
+            phiX[i] += s*rx;
+            phiY[i] += s*ry;
+            phiZ[i] += s*rz;
+            mag[i] = std::sqrt( phiX[i]*phiX[i] + phiY[i]*phiY[i] + phiZ[i]*phiZ[i] );
+            *minMag = std::min( *minMag, mag[i] );
+            *maxMag = std::max( *maxMag, mag[i] );
+        }
+    }
+
+    const spark::ChargeFieldKernels* selectChargeFieldKernels( void )
+    {
+        const spark::ChargeFieldKernels* kernels = spark::avx2ChargeFieldKernels();
+        if( !kernels )
+        {
+            kernels = spark::sseChargeFieldKernels();
+        }
+        if( !kernels )
+        {
+            kernels = &spark::scalarChargeFieldKernels();
+        }
+        LOG_INFO(g_log) << "Charge field kernels using " << kernels->name;
+        return kernels;
+    }
+} // end anonymous namespace
+
+const spark::ChargeFieldKernels&
+spark
+::scalarChargeFieldKernels( void )
+{
+    static const ChargeFieldKernels kernels =
+    {
+        "scalar",
+        addChargeFieldScalar
+    };
+    return kernels;
+}
+
+const spark::ChargeFieldKernels&
+spark
+::chargeFieldKernels( void )
+{
+    static const ChargeFieldKernels* best = selectChargeFieldKernels();
+    return *best;
+}
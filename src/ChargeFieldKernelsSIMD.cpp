@@ -0,0 +1,190 @@
+// SSE2 and AVX2 implementations of ChargeFieldKernels.
+// See SIMDTarget.hpp for how the instruction sets are targeted.
+
+#include "ChargeFieldKernels.hpp"
+#include "FluidKernels.hpp"
+#include "SIMDTarget.hpp"
+
+#ifdef SPARK_SIMD_X86
+
+namespace
+{
+    ////////////////////////////////////////////////////////////////////////
+    // SSE2
+
+    /// 1/sqrt(v) from the estimate refined by one Newton step, to
+    /// about float precision.
+    SPARK_TARGET_SSE2
+    inline __m128 rsqrtSSE( __m128 v )
+    {
+        const __m128 y = _mm_rsqrt_ps( v );
+        const __m128 yyv = _mm_mul_ps( _mm_mul_ps( y, y ), v );
+        return _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( 0.5f ), y ),
+                           _mm_sub_ps( _mm_set1_ps( 3.0f ), yyv ) );
+    }
+
+    /// Smallest of the four lanes of v.
+    SPARK_TARGET_SSE2
+    inline float horizontalMinSSE( __m128 v )
+    {
+        v = _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+        return _mm_cvtss_f32( _mm_min_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) ) );
+    }
+
+    /// Largest of the four lanes of v.
+    SPARK_TARGET_SSE2
+    inline float horizontalMaxSSE( __m128 v )
+    {
+        v = _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 1, 0, 3, 2 ) ) );
+        return _mm_cvtss_f32( _mm_max_ps( v, _mm_shuffle_ps( v, v, _MM_SHUFFLE( 2, 3, 0, 1 ) ) ) );
+    }
+
+    SPARK_TARGET_SSE2
+    void addChargeFieldSSE( float* phiX, float* phiY, float* phiZ,
+                            float* mag, float* minMag, float* maxMag,
+                            const float* x, const float* y, const float* z, size_t n,
+                            float cx, float cy, float cz, float q, float h )
+    {
+        const __m128 vcx = _mm_set1_ps( cx );
+        const __m128 vcy = _mm_set1_ps( cy );
+        const __m128 vcz = _mm_set1_ps( cz );
+        const __m128 vq = _mm_set1_ps( q );
+        const __m128 vh = _mm_set1_ps( h );
+        const __m128 one = _mm_set1_ps( 1.0f );
+        const __m128 zero = _mm_setzero_ps();
+        __m128 vmin = _mm_set1_ps( *minMag );
+        __m128 vmax = _mm_set1_ps( *maxMag );
+        size_t i = 0;
+        for( ; i + 4 <= n; i += 4 )
+        {
+            const __m128 rx = _mm_sub_ps( _mm_loadu_ps( x + i ), vcx );
+            const __m128 ry = _mm_sub_ps( _mm_loadu_ps( y + i ), vcy );
+            const __m128 rz = _mm_sub_ps( _mm_loadu_ps( z + i ), vcz );
+            const __m128 invD = rsqrtSSE( _mm_add_ps( _mm_add_ps( _mm_mul_ps( rx, rx ), _mm_mul_ps( ry, ry ) ),
+                                                      _mm_mul_ps( rz, rz ) ) );
+            const __m128 s = _mm_mul_ps( _mm_sub_ps( one, _mm_mul_ps( vh, invD ) ), _mm_mul_ps( vq, invD ) );
+            const __m128 fx = _mm_add_ps( _mm_loadu_ps( phiX + i ), _mm_mul_ps( s, rx ) );
+            const __m128 fy = _mm_add_ps( _mm_loadu_ps( phiY + i ), _mm_mul_ps( s, ry ) );
+            const __m128 fz = _mm_add_ps( _mm_loadu_ps( phiZ + i ), _mm_mul_ps( s, rz ) );
+            _mm_storeu_ps( phiX + i, fx );
+            _mm_storeu_ps( phiY + i, fy );
+            _mm_storeu_ps( phiZ + i, fz );
+            const __m128 m2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( fx, fx ), _mm_mul_ps( fy, fy ) ),
+                                          _mm_mul_ps( fz, fz ) );
+            // |phi| = |phi|^2 / |phi|; 0*inf lanes are masked out
+            const __m128 m = _mm_and_ps( _mm_cmpgt_ps( m2, zero ), _mm_mul_ps( m2, rsqrtSSE( m2 ) ) );
+            _mm_storeu_ps( mag + i, m );
+            vmin = _mm_min_ps( vmin, m );
+            vmax = _mm_max_ps( vmax, m );
+        }
+        *minMag = horizontalMinSSE( vmin );
+        *maxMag = horizontalMaxSSE( vmax );
+        if( i < n )
+        {
+            spark::scalarChargeFieldKernels().addChargeField( phiX + i, phiY + i, phiZ + i,
+                                                              mag + i, minMag, maxMag,
+                                                              x + i, y + i, z + i, n - i,
+                                                              cx, cy, cz, q, h );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    // AVX2 + FMA
+
+    SPARK_TARGET_AVX2
+    inline __m256 rsqrtAVX2( __m256 v )
+    {
+        const __m256 y = _mm256_rsqrt_ps( v );
+        const __m256 yyv = _mm256_mul_ps( _mm256_mul_ps( y, y ), v );
+        return _mm256_mul_ps( _mm256_mul_ps( _mm256_set1_ps( 0.5f ), y ),
+                              _mm256_sub_ps( _mm256_set1_ps( 3.0f ), yyv ) );
+    }
+
+    SPARK_TARGET_AVX2
+    void addChargeFieldAVX2( float* phiX, float* phiY, float* phiZ,
+                             float* mag, float* minMag, float* maxMag,
+                             const float* x, const float* y, const float* z, size_t n,
+                             float cx, float cy, float cz, float q, float h )
+    {
+        const __m256 vcx = _mm256_set1_ps( cx );
+        const __m256 vcy = _mm256_set1_ps( cy );
+        const __m256 vcz = _mm256_set1_ps( cz );
+        const __m256 vq = _mm256_set1_ps( q );
+        const __m256 vh = _mm256_set1_ps( h );
+        const __m256 one = _mm256_set1_ps( 1.0f );
+        const __m256 zero = _mm256_setzero_ps();
+        __m256 vmin = _mm256_set1_ps( *minMag );
+        __m256 vmax = _mm256_set1_ps( *maxMag );
+        size_t i = 0;
+        for( ; i + 8 <= n; i += 8 )
+        {
+            const __m256 rx = _mm256_sub_ps( _mm256_loadu_ps( x + i ), vcx );
+            const __m256 ry = _mm256_sub_ps( _mm256_loadu_ps( y + i ), vcy );
+            const __m256 rz = _mm256_sub_ps( _mm256_loadu_ps( z + i ), vcz );
+            const __m256 invD = rsqrtAVX2( _mm256_fmadd_ps( rz, rz, _mm256_fmadd_ps( ry, ry, _mm256_mul_ps( rx, rx ) ) ) );
+            const __m256 s = _mm256_mul_ps( _mm256_fnmadd_ps( vh, invD, one ), _mm256_mul_ps( vq, invD ) );
+            const __m256 fx = _mm256_fmadd_ps( s, rx, _mm256_loadu_ps( phiX + i ) );
+            const __m256 fy = _mm256_fmadd_ps( s, ry, _mm256_loadu_ps( phiY + i ) );
+            const __m256 fz = _mm256_fmadd_ps( s, rz, _mm256_loadu_ps( phiZ + i ) );
+            _mm256_storeu_ps( phiX + i, fx );
+            _mm256_storeu_ps( phiY + i, fy );
+            _mm256_storeu_ps( phiZ + i, fz );
+            const __m256 m2 = _mm256_fmadd_ps( fz, fz, _mm256_fmadd_ps( fy, fy, _mm256_mul_ps( fx, fx ) ) );
+            const __m256 m = _mm256_and_ps( _mm256_cmp_ps( m2, zero, _CMP_GT_OQ ),
+                                            _mm256_mul_ps( m2, rsqrtAVX2( m2 ) ) );
+            _mm256_storeu_ps( mag + i, m );
+            vmin = _mm256_min_ps( vmin, m );
+            vmax = _mm256_max_ps( vmax, m );
+        }
+        *minMag = horizontalMinSSE( _mm_min_ps( _mm256_castps256_ps128( vmin ), _mm256_extractf128_ps( vmin, 1 ) ) );
+        *maxMag = horizontalMaxSSE( _mm_max_ps( _mm256_castps256_ps128( vmax ), _mm256_extractf128_ps( vmax, 1 ) ) );
+        if( i < n )
+        {
+            addChargeFieldSSE( phiX + i, phiY + i, phiZ + i, mag + i, minMag, maxMag,
+                               x + i, y + i, z + i, n - i, cx, cy, cz, q, h );
+        }
+    }
+} // end anonymous namespace
+
+const spark::ChargeFieldKernels*
+spark
+::sseChargeFieldKernels( void )
+{
+    static const ChargeFieldKernels kernels =
+    {
+        "SSE2",
+        addChargeFieldSSE
+    };
+    return &kernels;
+}
+
+const spark::ChargeFieldKernels*
+spark
+::avx2ChargeFieldKernels( void )
+{
+    static const ChargeFieldKernels kernels =
+    {
+        "AVX2",
+        addChargeFieldAVX2
+    };
+    static const bool isSupported = cpuSupportsAVX2();
+    return isSupported ? &kernels : NULL;
+}
+
+#else // !SPARK_SIMD_X86
+
+const spark::ChargeFieldKernels*
+spark
+::sseChargeFieldKernels( void )
+{
+    return NULL;
+}
+
+const spark::ChargeFieldKernels*
+spark
+::avx2ChargeFieldKernels( void )
+{
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,277 @@
+#include "ChargeOctree.hpp"
+#include "Exceptions.hpp"
+
+#include <cmath>
+#include <algorithm>
+
+namespace
+{
+    /// Charges a leaf holds before it is split.
+    const unsigned int leafCapacity = 8;
+    /// Leaves this far below the root are not split, so coincident
+    /// charges can't recurse forever.
+    const unsigned int maxSplitDepth = 24;
+    /// Half width of the root around the first charge; the root grows
+    /// as needed.
+    const float initialHalfWidth = 1.0f;
+}
+
+spark::ChargeOctree
+::ChargeOctree( void )
+{
+}
+
+void
+spark::ChargeOctree
+::clear( void )
+{
+    m_nodes.clear();
+    m_chargePos.clear();
+    m_chargeQ.clear();
+    m_nextCharge.clear();
+}
+
+void
+spark::ChargeOctree
+::insert( const Eigen::Vector3f& pos, float q )
+{
+    if( !( std::isfinite( pos[0] ) && std::isfinite( pos[1] ) && std::isfinite( pos[2] ) ) )
+    {
+        throw SparkRunTimeException( "ChargeOctree given a charge at a non-finite position" );
+    }
+    const size_t c = m_chargePos.size();
+    m_chargePos.push_back( pos );
+    m_chargeQ.push_back( q );
+    m_nextCharge.push_back( -1 );
+
+    if( m_nodes.empty() )
+    {
+        Node root;
+        root.center = pos;
+        root.halfWidth = initialHalfWidth;
+        root.weightedPos << 0, 0, 0;
+        root.absCharge = 0;
+        root.charge = 0;
+        root.dipole << 0, 0, 0;
+        std::fill( root.quadrupole, root.quadrupole + 6, 0.0f );
+        root.firstChild = -1;
+        root.firstCharge = -1;
+        root.chargeCount = 0;
+        m_nodes.push_back( root );
+    }
+    else
+    {
+        growToContain( pos );
+    }
+
+    int node = 0;
+    unsigned int depth = 0;
+    accumulate( node, c );
+    while( m_nodes[node].firstChild >= 0 )
+    {
+        node = childFor( node, pos );
+        ++depth;
+        accumulate( node, c );
+    }
+    Node& leaf = m_nodes[node];
+    m_nextCharge[c] = leaf.firstCharge;
+    leaf.firstCharge = (int)c;
+    ++leaf.chargeCount;
+    if( leaf.chargeCount > leafCapacity && depth < maxSplitDepth )
+    {
+        split( node, depth );
+    }
+}
+
+Eigen::Vector3f
+spark::ChargeOctree
+::field( const Eigen::Vector3f& pos, float h, float openingAngle ) const
+{
+    Eigen::Vector3f result( 0, 0, 0 );
+    if( !m_nodes.empty() )
+    {
+        addNodeField( 0, pos, h, openingAngle * openingAngle, &result );
+    }
+    return result;
+}
+
+Eigen::Vector3f
+spark::ChargeOctree
+::directField( const Eigen::Vector3f& pos, float h ) const
+{
+    Eigen::Vector3f result( 0, 0, 0 );
+    for( size_t c = 0; c < m_chargePos.size(); ++c )
+    {
+        result += pointChargeField( pos - m_chargePos[c], m_chargeQ[c], h );
+    }
+    return result;
+}
+
+void
+spark::ChargeOctree
+::addNodeField( int node, const Eigen::Vector3f& pos, float h,
+                float openingAngle2, Eigen::Vector3f* result ) const
+{
+    const Node& n = m_nodes[node];
+    if( n.absCharge == 0 )
+    {
+        return;
+    }
+    if( n.firstChild < 0 )
+    {
+        for( int c = n.firstCharge; c >= 0; c = m_nextCharge[c] )
+        {
+            *result += pointChargeField( pos - m_chargePos[c], m_chargeQ[c], h );
+        }
+        return;
+    }
+    // Far enough away, expand about the center of charge
+    const Eigen::Vector3f c = n.weightedPos / n.absCharge;
+    const Eigen::Vector3f r = pos - c;
+    const float width = 2.0f * n.halfWidth;
+    const float d2 = r.squaredNorm();
+    if( width * width < openingAngle2 * d2 )
+    {
+        // Moments about c: D = sum q (x-c), M = sum q (x-c)(x-c)^T
+        const Eigen::Vector3f D = n.dipole - n.charge * c;
+        Eigen::Matrix3f M;
+        M << n.quadrupole[0], n.quadrupole[3], n.quadrupole[4],
+             n.quadrupole[3], n.quadrupole[1], n.quadrupole[5],
+             n.quadrupole[4], n.quadrupole[5], n.quadrupole[2];
+        M += n.charge * c * c.transpose() - n.dipole * c.transpose() - c * n.dipole.transpose();
+
+        // Taylor series of the unit-vector term K(r) = r/d about r:
+        // sum q K(r - delta) = Q K - J D + 1/2 sum_bc H_abc M_bc, where
+        // J = (I - u u^T)/d and the contracted Hessian is
+        // ( 3 u (u.Mu) - 2 M u - tr(M) u ) / d^2, with u = r/d.
+        const float d = std::sqrt( d2 );
+        const Eigen::Vector3f u = r / d;
+        const Eigen::Vector3f Mu = M * u;
+        const Eigen::Vector3f expansion = n.charge * u
+            - ( D - u * u.dot( D ) ) / d
+            + ( 1.5f * u.dot( Mu ) - 0.5f * M.trace() ) / d2 * u - Mu / d2;
+        // The shell term falls off as 1/d; its monopole is enough.
+        *result += expansion - ( n.charge * h / d2 ) * r;
+        return;
+    }
+    for( int child = n.firstChild; child < n.firstChild + 8; ++child )
+    {
+        addNodeField( child, pos, h, openingAngle2, result );
+    }
+}
+
+int
+spark::ChargeOctree
+::addChildren( int node )
+{
+    const int first = (int)m_nodes.size();
+    const float quarter = 0.5f * m_nodes[node].halfWidth;
+    for( int octant = 0; octant < 8; ++octant )
+    {
+        Node child;
+        child.center = m_nodes[node].center;
+        child.center[0] += ( octant & 1 ) ? quarter : -quarter;
+        child.center[1] += ( octant & 2 ) ? quarter : -quarter;
+        child.center[2] += ( octant & 4 ) ? quarter : -quarter;
+        child.halfWidth = quarter;
+        child.weightedPos << 0, 0, 0;
+        child.absCharge = 0;
+        child.charge = 0;
+        child.dipole << 0, 0, 0;
+        std::fill( child.quadrupole, child.quadrupole + 6, 0.0f );
+        child.firstChild = -1;
+        child.firstCharge = -1;
+        child.chargeCount = 0;
+        m_nodes.push_back( child );
+    }
+    m_nodes[node].firstChild = first;
+    return first;
+}
+
+int
+spark::ChargeOctree
+::childFor( int node, const Eigen::Vector3f& pos ) const
+{
+    const Node& n = m_nodes[node];
+    return n.firstChild
+        + ( pos[0] >= n.center[0] ? 1 : 0 )
+        + ( pos[1] >= n.center[1] ? 2 : 0 )
+        + ( pos[2] >= n.center[2] ? 4 : 0 );
+}
+
+void
+spark::ChargeOctree
+::accumulate( int node, size_t c )
+{
+    Node& n = m_nodes[node];
+    const float absQ = std::abs( m_chargeQ[c] );
+    const float q = m_chargeQ[c];
+    const Eigen::Vector3f& x = m_chargePos[c];
+    n.weightedPos += absQ * x;
+    n.absCharge += absQ;
+    n.charge += q;
+    n.dipole += q * x;
+    n.quadrupole[0] += q * x[0] * x[0];
+    n.quadrupole[1] += q * x[1] * x[1];
+    n.quadrupole[2] += q * x[2] * x[2];
+    n.quadrupole[3] += q * x[0] * x[1];
+    n.quadrupole[4] += q * x[0] * x[2];
+    n.quadrupole[5] += q * x[1] * x[2];
+}
+
+void
+spark::ChargeOctree
+::split( int node, unsigned int depth )
+{
+    addChildren( node );
+    int c = m_nodes[node].firstCharge;
+    m_nodes[node].firstCharge = -1;
+    m_nodes[node].chargeCount = 0;
+    while( c >= 0 )
+    {
+        const int next = m_nextCharge[c];
+        const int child = childFor( node, m_chargePos[c] );
+        accumulate( child, c );
+        m_nextCharge[c] = m_nodes[child].firstCharge;
+        m_nodes[child].firstCharge = c;
+        ++m_nodes[child].chargeCount;
+        c = next;
+    }
+    const int first = m_nodes[node].firstChild;
+    for( int child = first; child < first + 8; ++child )
+    {
+        if( m_nodes[child].chargeCount > leafCapacity && depth + 1 < maxSplitDepth )
+        {
+            split( child, depth + 1 );
+        }
+    }
+}
+
+void
+spark::ChargeOctree
+::growToContain( const Eigen::Vector3f& pos )
+{
+    while( !contains( m_nodes[0], pos ) )
+    {
+        // The old root becomes the octant of a root twice its size
+        // that faces away from pos
+        const Node oldRoot = m_nodes[0];
+        Node& root = m_nodes[0];
+        for( int a = 0; a < 3; ++a )
+        {
+            root.center[a] += ( pos[a] >= oldRoot.center[a] ) ? oldRoot.halfWidth : -oldRoot.halfWidth;
+        }
+        root.halfWidth = 2.0f * oldRoot.halfWidth;
+        root.firstCharge = -1;
+        root.chargeCount = 0;
+        addChildren( 0 );
+        m_nodes[childFor( 0, oldRoot.center )] = oldRoot;
+    }
+}
+
+bool
+spark::ChargeOctree
+::contains( const Node& node, const Eigen::Vector3f& pos ) const
+{
+    return ( pos - node.center ).cwiseAbs().maxCoeff() <= node.halfWidth;
+}
@@ -7,20 +7,106 @@
 //
 
 #include "DBMSpark.hpp"
+#include "ChargeFieldKernels.hpp"
 
-#include <iterator>
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
 #include <algorithm>
+#include <limits>
 
 using namespace Eigen;
 
+namespace
+{
+    /// Candidates per block of DBMSpark::updateElectricFields(), large
+    /// enough to amortize handing blocks to threads.
+    const size_t fieldBlockSize = 4096;
+
+    /// Field at pos due to every one of charges, summed directly.
+    Vector3f sumField( const spark::PointChargeArrays& charges, const Vector3f& pos, float h )
+    {
+        Vector3f phi( 0, 0, 0 );
+        for( size_t i=0; i<charges.size(); ++i )
+        {
+            phi += spark::pointChargeField( pos - charges.position( i ), charges.q[i], h );
+        }
+        return phi;
+    }
+}
+
+void
+spark::PointChargeArrays
+::clear( void )
+{
+    x.clear(); y.clear(); z.clear();
+    phiX.clear(); phiY.clear(); phiZ.clear();
+    q.clear();
+}
+
+void
+spark::PointChargeArrays
+::reserve( size_t n )
+{
+    x.reserve( n ); y.reserve( n ); z.reserve( n );
+    phiX.reserve( n ); phiY.reserve( n ); phiZ.reserve( n );
+    q.reserve( n );
+}
+
+void
+spark::PointChargeArrays
+::pushBack( const PointCharge& a_charge )
+{
+    x.push_back( a_charge.pos[0] ); y.push_back( a_charge.pos[1] ); z.push_back( a_charge.pos[2] );
+    phiX.push_back( a_charge.phi[0] ); phiY.push_back( a_charge.phi[1] ); phiZ.push_back( a_charge.phi[2] );
+    q.push_back( a_charge.q );
+}
+
+void
+spark::PointChargeArrays
+::popBack( void )
+{
+    x.pop_back(); y.pop_back(); z.pop_back();
+    phiX.pop_back(); phiY.pop_back(); phiZ.pop_back();
+    q.pop_back();
+}
+
+spark::PointCharge
+spark::PointChargeArrays
+::get( size_t i ) const
+{
+    PointCharge charge( x[i], y[i], z[i] );
+    charge.phi << phiX[i], phiY[i], phiZ[i];
+    charge.q = q[i];
+    return charge;
+}
+
+void
+spark::PointChargeArrays
+::set( size_t i, const PointCharge& a_charge )
+{
+    x[i] = a_charge.pos[0]; y[i] = a_charge.pos[1]; z[i] = a_charge.pos[2];
+    phiX[i] = a_charge.phi[0]; phiY[i] = a_charge.phi[1]; phiZ[i] = a_charge.phi[2];
+    q[i] = a_charge.q;
+}
+
 spark::DBMSpark
 ::DBMSpark()
 : m_h( 0.025f ),
   m_degree( 5 ),
-  m_eta( 10 )
+  m_eta( 10 ),
+  m_isCandidateViewStale( true ),
+  m_fieldEvaluator( DirectFieldEvaluator ),
+  m_openingAngle( 0.3f ),
+  m_isCheckingField( false ),
+  m_maxFieldError( 0.0f ),
+  m_minPhi( std::numeric_limits<float>::max() ),
+  m_maxPhi( 0.0f ),
+  m_weightMinPhi( 0.0f ),
+  m_weightMaxPhi( 0.0f ),
+  m_weightTolerance( 1e-3f ),
+  m_threadPool( new ThreadPool() ),
+  m_threadCount( m_threadPool->threadCount() )
 {
     
 }
@@ -31,19 +117,38 @@ spark::DBMSpark
 {
     m_aggregate.clear();
     m_aggregate.reserve( a_.size() );
-    copy( a_.begin(), a_.end(), std::back_inserter(m_aggregate) );
+    m_aggregateView.clear();
+    m_aggregateTree.clear();
+    for( size_t i=0; i<a_.size(); ++i )
+    {
+        m_aggregate.pushBack( a_[i] );
+        m_aggregateTree.insert( a_[i].pos, a_[i].q );
+    }
 }
 
 void
 spark::DBMSpark
 ::initializeBoundary( const PointCharges& a_boundary )
 {
+    m_boundary.clear();
+    m_boundary.reserve( a_boundary.size() );
+    m_boundaryTree.clear();
+    for( size_t i=0; i<a_boundary.size(); ++i )
+    {
+        m_boundary.pushBack( a_boundary[i] );
+        m_boundaryTree.insert( a_boundary[i].pos, a_boundary[i].q );
+    }
     // Compute the electric field for each candidate
     // based on the given boundary
     for( size_t i=0; i<m_candidate.size(); ++i )
     {
-        recomputeElectricFieldAtPoint( m_candidate[i] );
+        PointCharge candidate = m_candidate.get( i );
+        recomputeElectricFieldAtPoint( candidate );
+        m_candidate.set( i, candidate );
+        m_candidatePhi[i] = candidate.phi.norm();
     }
+    m_isCandidateViewStale = true;
+    rebuildCandidateWeights();
 }
 
 void
@@ -52,12 +157,75 @@ spark::DBMSpark
 {
     m_aggregate.clear();
     m_candidate.clear();
+    m_candidatePhi.clear();
+    m_aggregateView.clear();
+    m_isCandidateViewStale = true;
+    m_aggregateTree.clear();
+    m_candidateWeights.clear();
+    m_weightPhi.clear();
+    m_minPhi = std::numeric_limits<float>::max();
+    m_maxPhi = 0.0f;
+}
+
+const spark::PointCharges&
+spark::DBMSpark
+::aggregate( void ) const
+{
+    // Aggregate charges never change once added, so only copy new ones
+    for( size_t i=m_aggregateView.size(); i<m_aggregate.size(); ++i )
+    {
+        m_aggregateView.push_back( m_aggregate.get( i ) );
+    }
+    return m_aggregateView;
+}
+
+const spark::PointCharges&
+spark::DBMSpark
+::candidate( void ) const
+{
+    if( m_isCandidateViewStale )
+    {
+        m_candidateView.resize( m_candidate.size() );
+        for( size_t i=0; i<m_candidate.size(); ++i )
+        {
+            m_candidateView[i] = m_candidate.get( i );
+        }
+        m_isCandidateViewStale = false;
+    }
+    return m_candidateView;
+}
+
+void
+spark::DBMSpark
+::setThreadCount( unsigned int threadCount )
+{
+    m_threadCount = threadCount ? threadCount : ThreadPool::hardwareThreadCount();
+}
+
+void
+spark::DBMSpark
+::setFieldEvaluator( FieldEvaluatorType evaluator, float openingAngle )
+{
+    m_fieldEvaluator = evaluator;
+    m_openingAngle = openingAngle;
+}
+
+void
+spark::DBMSpark
+::setFieldCheck( bool isCheckingField )
+{
+    m_isCheckingField = isCheckingField;
+    m_maxFieldError = 0.0f;
 }
 
 void
 spark::DBMSpark
 ::update( double dt )
 {
+    if( m_threadCount != m_threadPool->threadCount() )
+    {
+        m_threadPool.reset( new ThreadPool( m_threadCount ) );
+    }
     LOG_DEBUG(g_log) << "Begin Spark::update(), agg: "
     << m_aggregate.size() << ", can: " << m_candidate.size() << "\n";
     if( m_aggregate.empty() && m_candidate.empty() )
@@ -65,26 +233,40 @@ spark::DBMSpark
         return;
     }
     
+    size_t newSamples = m_degree - 1;
     if( !m_candidate.empty() )
     {
         // Select a new pointcharge from the candidates
         size_t index = selectNextCandidate();
     
         // Add this PointCharge to the Aggregate
-        m_aggregate.push_back( m_candidate[index] );
+        m_aggregate.pushBack( m_candidate.get( index ) );
+        m_aggregateTree.insert( m_candidate.position( index ), m_candidate.q[index] );
 
-        // Remove from the list of candidates, and replace with a sample from the neighborhood
-        m_candidate[index] = sampleNeighborhood( m_aggregate.back(), 0, m_degree );
+        // Remove from the list of candidates; a sample from the
+        // neighborhood replaces it below
+        removeCandidate( index );
+        ++newSamples;
     }
-    // Add additional samples from the neighborhood of the newly selected candidate
-    for( size_t i=0; i<m_degree-1; ++i )
+    // Incorporate the new aggregate member into every candidate's
+    // electric field.  (New samples include it already.)
+    const PointCharge newest = m_aggregate.get( m_aggregate.size() - 1 );
+    updateElectricFields( newest );
+
+    // Add samples from the neighborhood of the newly selected candidate
+    for( size_t i=0; i<newSamples; ++i )
     {
-        m_candidate.push_back( sampleNeighborhood(m_aggregate.back(), i, m_degree ) );
+        addCandidate( sampleNeighborhood( newest, i, m_degree ) );
+    }
+    // Weights are normalized to a past range of fields; renormalize if
+    // the lowest has fallen, or the highest grown enough to lose
+    // precision.
+    const float slack = m_weightTolerance * ( m_weightMaxPhi - m_weightMinPhi );
+    if(    m_minPhi < m_weightMinPhi - slack
+        || m_maxPhi - m_weightMinPhi > 2.0f * ( m_weightMaxPhi - m_weightMinPhi ) )
+    {
+        rebuildCandidateWeights();
     }
-    
-    // Incorporate the new aggregate member into every candidate's
-    // electric field.
-    updateElectricFields( m_aggregate.back() );
     LOG_DEBUG(g_log) << "End  Spark::update(), agg: "
     << m_aggregate.size() << ", can: " << m_candidate.size() << "\n";
 }
@@ -93,70 +275,185 @@ void
 spark::DBMSpark
 ::updateElectricFields( const PointCharge& a_additionalCharge )
 {
+    const size_t count = m_candidate.size();
+    if( count == 0 )
+    {
+        return;
+    }
+    m_isCandidateViewStale = true;
+    const size_t blockCount = ( count + fieldBlockSize - 1 ) / fieldBlockSize;
+    m_blockMinPhi.resize( blockCount );
+    m_blockMaxPhi.resize( blockCount );
+    if( m_blockWeights.size() < blockCount )
+    {
+        m_blockWeights.resize( blockCount );
+    }
+    const float slack = m_weightTolerance * ( m_weightMaxPhi - m_weightMinPhi );
+    const ChargeFieldKernels& kernels = chargeFieldKernels();
+    const Vector3f& pos = a_additionalCharge.pos;
+    auto updateBlocks = [&]( size_t blockBegin, size_t blockEnd )
+    {
+        for( size_t b=blockBegin; b<blockEnd; ++b )
+        {
+            const size_t begin = b * fieldBlockSize;
+            const size_t end = std::min( begin + fieldBlockSize, count );
+            float minPhi = std::numeric_limits<float>::max();
+            float maxPhi = 0.0f;
+            kernels.addChargeField( &m_candidate.phiX[begin], &m_candidate.phiY[begin],
+                                    &m_candidate.phiZ[begin],
+                                    &m_candidatePhi[begin], &minPhi, &maxPhi,
+                                    &m_candidate.x[begin], &m_candidate.y[begin],
+                                    &m_candidate.z[begin], end - begin,
+                                    pos[0], pos[1], pos[2], a_additionalCharge.q, m_h );
+            // Weights are set after the blocks finish, as the sampler's
+            // sums are shared
+            std::vector< std::pair< size_t, float > >& weights = m_blockWeights[b];
+            weights.clear();
+            for( size_t i=begin; i<end; ++i )
+            {
+                const float phi = m_candidatePhi[i];
+                if( std::abs( phi - m_weightPhi[i] ) > slack )
+                {
+                    m_weightPhi[i] = phi;
+                    weights.push_back( std::make_pair( i, candidateWeight( phi ) ) );
+                }
+            }
+            m_blockMinPhi[b] = minPhi;
+            m_blockMaxPhi[b] = maxPhi;
+        }
+    };
+    if( blockCount == 1 )
+    {
+        updateBlocks( 0, 1 );
+    }
+    else
+    {
+        m_threadPool->parallelFor( 0, blockCount, updateBlocks );
+    }
+    for( size_t b=0; b<blockCount; ++b )
+    {
+        m_minPhi = std::min( m_minPhi, m_blockMinPhi[b] );
+        m_maxPhi = std::max( m_maxPhi, m_blockMaxPhi[b] );
+        const std::vector< std::pair< size_t, float > >& weights = m_blockWeights[b];
+        for( size_t w=0; w<weights.size(); ++w )
+        {
+            m_candidateWeights.set( weights[w].first, weights[w].second );
+        }
+    }
+}
+
+void
+spark::DBMSpark
+::addCandidate( const PointCharge& a_candidate )
+{
+    m_candidate.pushBack( a_candidate );
+    const float phi = a_candidate.phi.norm();
+    m_candidatePhi.push_back( phi );
+    m_weightPhi.push_back( phi );
+    m_isCandidateViewStale = true;
+    m_candidateWeights.pushBack( candidateWeight( phi ) );
+}
+
+void
+spark::DBMSpark
+::removeCandidate( size_t index )
+{
+    const size_t last = m_candidate.size() - 1;
+    m_candidate.set( index, m_candidate.get( last ) );
+    m_candidate.popBack();
+    m_candidatePhi[index] = m_candidatePhi.back();
+    m_candidatePhi.pop_back();
+    m_isCandidateViewStale = true;
+    m_weightPhi[index] = m_weightPhi.back();
+    m_weightPhi.pop_back();
+    const float lastWeight = m_candidateWeights.weight( m_candidateWeights.size() - 1 );
+    m_candidateWeights.popBack();
+    if( index < m_candidate.size() )
+    {
+        m_candidateWeights.set( index, lastWeight );
+    }
+}
+
+float
+spark::DBMSpark
+::candidateWeight( float phi ) const
+{
+    const float range = m_weightMaxPhi - m_weightMinPhi;
+    if( range <= 0.0f )
+    {
+        return 1.0f;
+    }
+    return std::pow( std::max( 0.0f, ( phi - m_weightMinPhi ) / range ), m_eta );
+}
+
+void
+spark::DBMSpark
+::rebuildCandidateWeights( void )
+{
+    m_minPhi = std::numeric_limits<float>::max();
+    m_maxPhi = 0.0f;
+    m_weightPhi = m_candidatePhi;
+    for( size_t i=0; i<m_weightPhi.size(); ++i )
+    {
+        m_minPhi = std::min<float>( m_minPhi, m_weightPhi[i] );
+        m_maxPhi = std::max<float>( m_maxPhi, m_weightPhi[i] );
+    }
+    m_weightMinPhi = m_minPhi;
+    m_weightMaxPhi = m_maxPhi;
+    std::vector< float > weights( m_candidate.size() );
     for( size_t i=0; i<m_candidate.size(); ++i )
     {
-        m_candidate[i].phi += field( m_candidate[i], a_additionalCharge );
+        weights[i] = candidateWeight( m_weightPhi[i] );
     }
+    m_candidateWeights.assign( weights );
 }
 
 void
 spark::DBMSpark
 ::recomputeElectricFieldAtPoint( PointCharge& a_point )
 {
-    a_point.phi << 0, 0, 0;
-    for( size_t a=0; a<m_aggregate.size(); ++a )
+    if( m_fieldEvaluator == BarnesHutFieldEvaluator )
     {
-        Vector3f fieldAtA = field( a_point, m_aggregate[a] );
-        a_point.phi += fieldAtA;
-        float phi = fieldAtA.norm();
-        m_minPhi = std::min<float>( m_minPhi, phi );
-        m_maxPhi = std::max<float>( m_maxPhi, phi );
+        a_point.phi = m_aggregateTree.field( a_point.pos, m_h, m_openingAngle )
+                    + m_boundaryTree.field( a_point.pos, m_h, m_openingAngle );
+        if( m_isCheckingField )
+        {
+            const Vector3f direct = directElectricField( a_point );
+            const float error = ( a_point.phi - direct ).norm() / direct.norm();
+            m_maxFieldError = std::max( m_maxFieldError, error );
+        }
     }
-    for( size_t b=0; b<m_boundary.size(); ++b )
+    else
     {
-        Vector3f fieldAtA = field( a_point, m_boundary[b] );
-        a_point.phi += fieldAtA;
-        float phi = fieldAtA.norm();
-        m_minPhi = std::min<float>( m_minPhi, phi );
-        m_maxPhi = std::max<float>( m_maxPhi, phi );
+        a_point.phi = directElectricField( a_point );
     }
+    const float phi = a_point.phi.norm();
+    m_minPhi = std::min<float>( m_minPhi, phi );
+    m_maxPhi = std::max<float>( m_maxPhi, phi );
 }
 
 Eigen::Vector3f
 spark::DBMSpark
-::field( const PointCharge& to, const PointCharge& from )
+::directElectricField( const PointCharge& a_point ) const
 {
-    Vector3f r = (to.pos-from.pos);
-    float d = r.norm();
     // Green's func soln to spherical shell boundary-value problem
-    return ( 1.0f - ( m_h / d ) ) * r.normalized() * from.q;
+    return sumField( m_aggregate, a_point.pos, m_h ) + sumField( m_boundary, a_point.pos, m_h );
 }
 
 size_t
 spark::DBMSpark
-::selectNextCandidate( void ) const
+::selectNextCandidate( void )
 {
     if( m_candidate.empty() ) throw "Cannot call selectNextCandidate on empty candidate list.";
 
-    float invRange = 1.0f / (m_maxPhi - m_minPhi);
-    
-    // compute total probability
-    float totProb = 0.0f;
-    for( size_t i=0; i<m_candidate.size(); ++i )
-    {
-        totProb += std::pow( (m_candidate[i].phi.norm() - m_minPhi)/invRange, m_eta );
-    }
     // randomly select a number between 1.0f and 0.0f.
-    float p = std::rand()*1.0f/RAND_MAX;
-    
-    // gobble-up the p until you reach the choosen one.
-    for( size_t i=0; i<m_candidate.size(); ++i )
+    const double p = m_random.uniformDouble();
+    if( m_candidateWeights.total() <= 0.0 )
     {
-        float prob = std::pow( (m_candidate[i].phi.norm() - m_minPhi)/invRange, m_eta ) / totProb;
-        if( prob < p ) return i;
-        p -= prob;
+        // every candidate at the lowest field; all equally likely
+        return std::min( (size_t)( p * m_candidate.size() ), m_candidate.size() - 1 );
     }
-    return m_candidate.size() - 1;
+    return m_candidateWeights.sample( p );
 }
 
 spark::PointCharge
@@ -167,9 +464,37 @@ spark::DBMSpark
     // add some small random displacement
     for( size_t dim=0; dim<2; ++dim )
     {
-        p.pos[dim] += m_h - (2.0f*std::rand()*m_h/RAND_MAX);
+        p.pos[dim] += m_random.uniform( -m_h, m_h );
     }
     recomputeElectricFieldAtPoint( p );
     return p;
 }
 
+
+spark::DBMSparkPtr
+spark::buildSpark_pointInBall( float radius )
+{
+    DBMSparkPtr spark( new DBMSpark );
+
+    PointCharges aggregate( 1 );
+    aggregate[0].q = -1.0f;
+    spark->setAggregate( aggregate );
+
+    // Spread evenly over the sphere (Fibonacci lattice), a charge per
+    // 0.01 radius^2 of its area
+    const size_t count = (size_t)( 4.0 * M_PI / 0.01 );
+    const float goldenAngle = (float)( M_PI * ( 3.0 - std::sqrt( 5.0 ) ) );
+    PointCharges boundary;
+    boundary.reserve( count );
+    for( size_t i=0; i<count; ++i )
+    {
+        const float z = 1.0f - ( 2.0f * i + 1.0f ) / count;
+        const float r = std::sqrt( 1.0f - z*z );
+        const float theta = goldenAngle * i;
+        boundary.push_back( PointCharge( radius * r * std::cos( theta ),
+                                         radius * r * std::sin( theta ),
+                                         radius * z ) );
+    }
+    spark->initializeBoundary( boundary );
+    return spark;
+}
@@ -1,949 +1,1805 @@
-#include "Fluid.hpp"
-
-#include "Utilities.hpp" //< for getTime() only
-
-#include <limits>
-#include <fstream>
-#include <algorithm>
-#include <cassert>
-
-std::ostream&
-spark::Fluid
-::writeYDensitySliceToPythonStream(std::ostream& out,
-                                   const std::string& varName,
-                                   unsigned int frame,
-                                   size_t j ) const
-{
-    out << varName << "[" << frame << "] = array( [";
-    for( size_t i=0; i < m_N+2; ++i )
-    {
-        out << "[";
-        for( size_t k=0; k < m_N+2; ++k )
-        {
-            out << m_density[index(i, j, k)];
-            if( k != (m_N+1) ) out << ", ";
-        }
-        out << "]";
-        if( i != (m_N+1) ) out << ", \n"; //new line optional
-    }
-    out << "], dtype=float32 )\n\n";
-    return out;
-}
-
-std::ostream&
-spark::Fluid
-::writeYVelocitySliceToPythonStream(std::ostream& out,
-                                    const std::string& varName,
-                                    unsigned int frame,
-                                    size_t j,
-                                    float dt ) const
-{
-    out << varName << "[" << frame <<"] = array( [";
-    for( size_t i=0; i < m_N+2; ++i )
-    {
-        out << "[";
-        for( size_t k=0; k < m_N+2; ++k )
-        {
-            out << "["
-                << dt * m_N * m_velU[index(i, j, k)] << ", "
-                << dt * m_N * m_velV[index(i, j, k)] << ", "
-                << dt * m_N * m_velW[index(i, j, k)] << "] ";
-            if( k != (m_N+1) ) out << ", ";
-        }
-        out << "]";
-        if( i != (m_N+1) ) out << ", \n"; //new line optional
-    }
-    out << "], dtype=float32 )\n\n";
-    return out;
-}
-
-spark::Fluid
-::Fluid( int size ) 
-    :
-    m_N( size - 2 ),
-    m_density( NULL ), m_density_prev( NULL ), m_density_source( NULL ),
-    m_velU( NULL ), m_velV( NULL ), m_velW( NULL ),
-    m_temp( NULL ), m_temp_prev( NULL ), m_temp_source( NULL ),
-    m_vorticityU( NULL ), m_vorticityV( NULL ), m_vorticityW( NULL ),
-    m_vorticityMagnitude( NULL ),
-    m_vorticityForceU( NULL ), m_vorticityForceV( NULL ), m_vorticityForceW( NULL ),
-    m_velU_prev( NULL ), m_velV_prev( NULL ), m_velW_prev( NULL ),
-    m_velU_source( NULL ), m_velV_source( NULL ), m_velW_source( NULL ),
-    m_solverIterations( 20 ),
-    m_size( size*size*size ),
-    m_visc( 0.0000 ),
-    m_diff( 0.000 ), // ????
-    m_div( NULL ), m_pressure( NULL ),
-    m_ambientTemp( 20.0f ),
-    m_tempFactor( 1.0f ), 
-    m_vorticityConfinementFactor( size * 60.0f ),
-    m_absorption( 1.0 )
-{
-    m_gravityFactor[0] = 0;
-    m_gravityFactor[1] = 0;
-    m_gravityFactor[2] = 0.3f;
-    // enforce a minimum size
-    const int minSize = 8;
-    if( size < minSize )
-    {
-        m_N = minSize;
-        m_size = (m_N+2)*(m_N+2)*(m_N+2);
-    }
-    reallocate();
-    init();
-}
-
-void 
-spark::Fluid
-::reallocate( void )
-{
-    deleteData();
-
-    m_density = new float[m_size];
-    m_density_prev = new float[m_size];
-    m_density_source = new float[m_size];
-
-    m_temp = new float[m_size];
-    m_temp_prev = new float[m_size];
-    m_temp_source = new float[m_size];
-
-    m_velU = new float[m_size];
-    m_velU_prev = new float[m_size];
-    m_velU_source = new float[m_size];
-
-    m_velV = new float[m_size];
-    m_velV_prev = new float[m_size];
-    m_velV_source = new float[m_size];
-
-    m_velW = new float[m_size];
-    m_velW_prev = new float[m_size];
-    m_velW_source = new float[m_size];
-
-    m_vorticityU = new float[m_size];
-    m_vorticityV = new float[m_size];
-    m_vorticityW = new float[m_size];
-
-    m_vorticityMagnitude = new float[m_size];
-
-    m_vorticityForceU = new float[m_size];
-    m_vorticityForceV = new float[m_size];
-    m_vorticityForceW = new float[m_size];
-
-    m_pressure = new float[m_size];
-    m_div = new float[m_size];
-}
-
-void
-spark::Fluid
-::deleteData( void )
-{
-    delete[] m_density;
-    delete[] m_density_prev;
-    delete[] m_temp;
-    delete[] m_temp_prev;
-    delete[] m_temp_source;
-    delete[] m_density_source;
-    delete[] m_velU;
-    delete[] m_velU_prev;
-    delete[] m_velU_source;
-    delete[] m_velV;
-    delete[] m_velV_prev;
-    delete[] m_velV_source;
-    delete[] m_velW;
-    delete[] m_velW_prev;
-    delete[] m_velW_source;
-    delete[] m_vorticityU;
-    delete[] m_vorticityV;
-    delete[] m_vorticityW;
-    delete[] m_vorticityMagnitude;
-    delete[] m_vorticityForceU;
-    delete[] m_vorticityForceV;
-    delete[] m_vorticityForceW;
-    delete[] m_pressure;
-    delete[] m_div;
-}
-
-spark::Fluid
-::~Fluid()
-{
-    deleteData();
-}
-
-void 
-spark::Fluid
-::init( void )
-{
-    zeroData();
-    swapAdvectedFields();
-    swapVelocityField();
-    zeroData();
-}
-
-void
-spark::Fluid
-::reset( void )
-{
-    init();
-}
-
-void
-spark::Fluid
-::setSize( int size )
-{
-    m_N = size - 2;
-    m_size = size*size*size;
-
-    reallocate();
-    init();
-}
-
-int
-spark::Fluid
-::getSize( void )
-{
-    return (int)m_N + 2;
-}
-
-void
-spark::Fluid
-::zeroData( void )
-{
-    for( size_t i=0; i < m_size; ++i )
-    {
-        m_density[i] = 0.0f;
-        m_temp[i] = m_ambientTemp;
-        m_velU[i] = 0.0f;
-        m_velV[i] = 0.0f;
-        m_velW[i] = 0.0f;
-        m_div[i] = 0.0f;
-        m_pressure[i] = 0.0f;
-        m_density_source[i] = 0.0f;
-        m_temp_source[i] = 0.0f;
-        m_velU_source[i] = 0.0f;
-        m_velV_source[i] = 0.0f;
-        m_velW_source[i] = 0.0f;
-        m_vorticityU[i] = 0.0f;
-        m_vorticityV[i] = 0.0f;
-        m_vorticityW[i] = 0.0f;
-        m_vorticityForceU[i] = 0.0f;
-        m_vorticityForceV[i] = 0.0f;
-        m_vorticityForceW[i] = 0.0f;
-    }
-}
-
-/// Create a 4x4x1 area at the bottom with high temp and source
-void
-spark::Fluid
-::addBottomSource( void )
-{
-    int cx  = m_N/2;
-    int cy  = 0;//m_N/4;
-    int cz  = m_N/2;
-    float r = (float)m_N/12.0f;
-
-    for( int x=1; x<m_N; ++x )
-    {
-        for( int y=1; y<m_N; ++y )
-        {
-            for( int z=1; z<m_N; ++z )
-            {
-                float d = std::sqrt( 
-                    (x-(float)cx)*(x-(float)cx)
-                    + (y-(float)cy)*(y-(float)cy)
-                    + (z-(float)cz)*(z-(float)cz)
-                    );
-                if( d <= r )
-                {
-                    int i = index(x,y,z);
-                    m_density[i] = 0.5f;
-                    //m_density_source[i] = 10.0;
-                    //m_temp[i] = 4.2f * m_ambientTemp;
-                    //m_temp_source[i] = 1.8f * m_ambientTemp;
-                }
-            }
-        }
-    }
-}
-
-
-void
-spark::Fluid
-::addBoom( void )
-{
-    const float vu = 100;
-    const float vv = 100;
-    const float vw = 100;
-    const float d = 10.5;
-
-    const size_t cx = m_N/2;
-    const size_t cy = m_N/2;
-    const size_t cz = m_N/4;
-
-    // Initialize middle
-    m_velU[index(cx, cy, cz)] =   vu;
-    m_velU[index(cx-1, cy, cz)] = vu;
-    m_velU[index(cx+1, cy, cz)] = vu;
-    m_velU[index(cx, cy-1, cz)] = vu;
-    m_velU[index(cx, cy+1, cz)] = vu;
-    m_velU[index(cx, cy, cz-1)] = vu;
-    m_velU[index(cx, cy, cz+1)] = vu;
-
-    m_velV[index(cx, cy, cz)] =   vv;
-    m_velV[index(cx-1, cy, cz)] = vv;
-    m_velV[index(cx+1, cy, cz)] = vv;
-    m_velV[index(cx, cy-1, cz)] = vv;
-    m_velV[index(cx, cy+1, cz)] = vv;
-    m_velV[index(cx, cy, cz-1)] = vv;
-    m_velV[index(cx, cy, cz+1)] = vv;
-
-    m_velW[index(cx, cy, cz)] =   vw;
-    m_velW[index(cx-1, cy, cz)] = vw;
-    m_velW[index(cx+1, cy, cz)] = vw;
-    m_velW[index(cx, cy-1, cz)] = vw;
-    m_velW[index(cx, cy+1, cz)] = vw;
-    m_velW[index(cx, cy, cz-1)] = vw;
-    m_velW[index(cx, cy, cz+1)] = vw;
-
-    //// for starters, but a little density at the middle
-    m_density[index(m_N/2,     m_N/2,     m_N/2)] = d;
-    m_density[index(m_N/2 + 1, m_N/2 + 1, m_N/2)] = d;
-    m_density[index(m_N/2 + 1, m_N/2 - 1, m_N/2)] = d;
-    m_density[index(m_N/2 - 1, m_N/2 + 1, m_N/2)] = d;
-    m_density[index(m_N/2 - 1, m_N/2 - 1, m_N/2)] = d;
-    m_density[index(m_N/2, m_N/2, m_N/2+1)] = d;
-    m_density[index(m_N/2, m_N/2, m_N/2-1)] = d;
-
-    m_temp[index(m_N/2,     m_N/2,     m_N/2)] = 1.8f * m_ambientTemp;
-    m_temp[index(m_N/2 + 1, m_N/2 + 1, m_N/2)] = 1.8f * m_ambientTemp;
-    m_temp[index(m_N/2 + 1, m_N/2 - 1, m_N/2)] = 1.8f * m_ambientTemp;
-    m_temp[index(m_N/2 - 1, m_N/2 + 1, m_N/2)] = 1.8f * m_ambientTemp;
-    m_temp[index(m_N/2 - 1, m_N/2 - 1, m_N/2)] = 1.8f * m_ambientTemp;
-    m_temp[index(m_N/2, m_N/2, m_N/2+1)] = 1.8f * m_ambientTemp;
-    m_temp[index(m_N/2, m_N/2, m_N/2-1)] = 1.8f * m_ambientTemp;
-}
-
-void
-spark::Fluid
-::saveToFile( const char* filename )
-{
-    using namespace std;
-    ofstream out( filename, std::ios::ate );
-    out.precision( numeric_limits< double >::max_digits10 );
-    out << m_N << endl;
-    assert( m_size == ((m_N+2)*(m_N+2)*(m_N+2)) );
-    for( size_t i = 0; i < m_size; ++i )
-    {
-        out << scientific << m_density[i] << endl;
-    }
-}
-
-void
-spark::Fluid
-::loadFromFile( const char* filename )
-{
-    using namespace std;
-    ifstream infile( filename );
-    infile >> m_N;
-    m_size = (m_N+2)*(m_N+2)*(m_N+2);
-    reallocate();
-    init();
-    for( size_t i = 0; i < m_size; ++i )
-    {
-        infile >> m_density[i];
-        m_density_prev[i] = m_density[i];
-    }
-    LOG_DEBUG(g_log) << "Finished loading file with N=" << m_N 
-                     << " and size=" << m_size << "\n";
-}
-
-void
-spark::Fluid
-::addDensitySources( float dt )
-{
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                const size_t ind = index(i,j,k);
-
-                // Explicit sources
-                m_density[ind] += dt * m_density_source[ind];
-                m_temp[ind]    += dt * m_temp_source[ind];
-            }
-        }
-    }
-}
-
-void
-spark::Fluid
-::addVelocitySources( float dt )
-{
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                const size_t ind = index(i,j,k);
-                m_velU[ind]    += dt * m_velU_source[ind];
-                m_velV[ind]    += dt * m_velV_source[ind];
-                m_velW[ind]    += dt * m_velW_source[ind];
-
-                // Buoyancy force
-                // assume z = 0,0,1 so only affect w
-                m_velW[ind]    += dt * m_tempFactor * ( m_temp[ind] - m_ambientTemp );
-
-                // Gravity force
-                // assume z = 0,0,1
-                m_velU[ind]    -= dt * m_density[ind] * m_gravityFactor[0];
-                m_velV[ind]    -= dt * m_density[ind] * m_gravityFactor[1];
-                m_velW[ind]    -= dt * m_density[ind] * m_gravityFactor[2];
-
-                // Vorticity confinement term
-                m_velU[ind]    += dt * m_vorticityForceU[ind];
-                m_velV[ind]    += dt * m_vorticityForceV[ind];
-                m_velW[ind]    += dt * m_vorticityForceW[ind];
-            }
-        }
-    }
-}
-
-void
-spark::Fluid
-::project( void )
-{
-    // compute divergence of velocity field
-    float* div = m_div;//m_velV_prev;  
-    float* p   = m_pressure; //m_velU_prev;  
-    float* vx  = m_velU;
-    float* vy  = m_velV;
-    float* vz  = m_velW;
-    float  a   = -0.5f/m_N;
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                div[index(i, j, k)] = 
-                    a * (  vx[index(i+1, j,   k  )] - vx[index(i-1,j,  k  )]
-                         + vy[index(i,   j+1, k  )] - vy[index(i,  j-1,k  )]
-                         + vz[index(i,   j,   k+1)] - vz[index(i,  j,  k-1)] );
-                p[index(i,j,k)] = 0;
-            }
-        }
-    }
-
-    enforceConcentrationBoundary( 0, div );
-    enforceConcentrationBoundary( 0, p );
-
-    // Gauss-Seidel solver of the pressure field
-    linearSolve( 0, p, div, 1, 6 );
-
-    // subtract the gradient of pressure field from velocity
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                vx[index(i,j,k)] -= 0.5f*m_N*( p[index(i+1, j,   k  )] - p[index(i-1, j,   k  )] );
-                vy[index(i,j,k)] -= 0.5f*m_N*( p[index(i,   j+1, k  )] - p[index(i,   j-1, k  )] );
-                vz[index(i,j,k)] -= 0.5f*m_N*( p[index(i,   j,   k+1)] - p[index(i,   j,   k-1)] );
-            }
-        }
-    }
-    enforceConcentrationBoundary( 1, vx );
-    enforceConcentrationBoundary( 2, vy );
-    enforceConcentrationBoundary( 3, vz );
-}
-
-void 
-spark::Fluid
-::diffuse( int boundaryCondition, 
-           float* x, float* x_prev, 
-           float diff, float dt )
-{
-    float a = dt * diff * m_N * m_N * m_N;
-    linearSolve( boundaryCondition, x, x_prev, a, 1+6*a );
-}
-
-void
-spark::Fluid
-::linearSolveSlow( int boundaryCondition, 
-                   float* x, float* x_prev, 
-                   float a, float c )
-{
-    const float invC = 1.0 / c;
-    //LOG_DEBUG(g_log) << "PRE linear Solve a=" << a << ", invc=" << invC << ",  middle voxel = " << x[index(m_N/2, m_N/2, m_N/2)] << " prev=" << x_prev[index(m_N/2, m_N/2, m_N/2)] << "\n";
-    for ( size_t iter = 0 ; iter < m_solverIterations; ++iter ) 
-    {
-        for( size_t k = 1; k <= m_N; k++ )
-        {
-            for( size_t j = 1; j <= m_N; j++ )
-            {
-                for( size_t i = 1; i <= m_N; i++ )
-                {
-                    x[index(i, j, k)] = invC * ( x_prev[index(i, j, k)] 
-                    + a*( x[index(i-1, j,   k  )] 
-                        + x[index(i+1, j,   k  )] 
-                        + x[index(i,   j-1, k  )]
-                        + x[index(i,   j+1, k  )]
-                        + x[index(i,   j,   k-1)] 
-                        + x[index(i,   j,   k+1)] 
-                      )
-                    );
-                }
-            }
-        }
-        // Each iteration, enforce boundary
-        enforceConcentrationBoundary( boundaryCondition, x );
-    }
-    //LOG_DEBUG(g_log) << "POST linear Solve a=" << a << ", invc=" << invC << ",  middle voxel = " << x[index(m_N/2, m_N/2, m_N/2)] << " prev=" << x_prev[index(m_N/2, m_N/2, m_N/2)] << "\n";
-}
-
-void 
-spark::Fluid
-::linearSolve( int boundaryCondition, 
-               float* x, float* x_prev, 
-               float a, float c )
-{
-    const int dim = m_N+2;
-    const int dim2 = dim*dim;
-    const float invC = 1.0 / c;
-    size_t ind;
-    for ( size_t iter = 0 ; iter < m_solverIterations; ++iter ) 
-    {
-        for( size_t k = 1; k <= m_N; k++ )
-        {
-            for( size_t j = 1; j <= m_N; j++ )
-            {
-                for( size_t i = 1; i <= m_N; i++ )
-                {
-                    ind = index(i, j, k);
-                    x[ind] = invC * ( x_prev[ind] 
-                    + a*( x[ind-1]  //index(i-1, j, k) 
-                    + x[ind+1] // index(i+1, j,   k  )] 
-                    + x[ind-dim]//index(i,   j-1, k  )]
-                    + x[ind+dim]//index(i,   j+1, k  )]
-                    + x[ind-dim2]// index(i,   j,   k-1)] 
-                    + x[ind+dim2]//index(i,   j,   k+1)] 
-                    )
-                        );
-                }
-            }
-        }
-        // Each iteration, enforce boundary
-        enforceConcentrationBoundary( boundaryCondition, x );
-    }
-}
-
-void 
-spark::Fluid
-::curl( float* dest, 
-        const float* a, const float* b, 
-        int ax, int ay, int az, 
-        int bx, int by, int bz,
-        float h )
-{
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                // TODO -- reduce # of calls to index
-                dest[index(i, j, k)] = h * ( a[index(i+ax,j+ay,k+az)] - b[index(i+bx,j+by,k+bz)] );
-            }
-        }
-    }
-}
-
-void 
-spark::Fluid
-::computeVorticityConfinment( void )
-{
-    if( m_vorticityConfinementFactor == 0.0 )
-    {
-        return;
-    }
-    float h = 2.0/(m_N+2); // width of two voxels
-    // Compute curl of the velocity = known as the vorticity of the fluid (\omega)
-    curl( m_vorticityU, m_velW, m_velV, 0,1,0, 0,0,1, h );
-    curl( m_vorticityV, m_velU, m_velW, 0,0,1, 1,0,0, h );
-    curl( m_vorticityW, m_velV, m_velU, 1,0,0, 0,1,0, h );
-
-    // \omega = \nabla \cross u
-    // \eta = \nabla | \omega |  -- gradient of the scalar field that is the magnitude of the vorticity
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                // Compute eta = | \omega |
-                const int ind = index(i,j,k);
-                m_vorticityMagnitude[ind] 
-                = std::sqrt( m_vorticityU[ind]*m_vorticityU[ind] 
-                           + m_vorticityV[ind]*m_vorticityV[ind]
-                           + m_vorticityW[ind]*m_vorticityW[ind] );
-            }
-        }
-    }
-    // compute the gradient of the magnitude of the vorticity  
-    // NOTE, m_vorticityForceUVW is used as a temporary var holding the gradient of the vorticity
-    // \eta = \nabla | \omega |
-    const int dx = index(1,0,0) - index(0,0,0);
-    const int dy = index(0,1,0) - index(0,0,0);
-    const int dz = index(0,0,1) - index(0,0,0);
-    int ind = 0;
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                ind = index(i,j,k);
-                //if( index(i+1,j,k) != (ind + dx) ) throw "ERROR";
-                //if( index(i,j+1,k) != (ind + dy) ) throw "ERROR";
-                //if( index(i,j,k+1) != (ind + dz) ) throw "ERROR";
-                //if( index(i-1,j,k) != (ind - dx) ) throw "ERROR";
-                //if( index(i,j-1,k) != (ind - dy) ) throw "ERROR";
-                //if( index(i,j,k-1) != (ind - dz) ) throw "ERROR";
-
-                m_vorticityForceU[ind] = h * ( m_vorticityMagnitude[ind+dx] - m_vorticityMagnitude[ind-dx] );
-                m_vorticityForceV[ind] = h * ( m_vorticityMagnitude[ind+dy] - m_vorticityMagnitude[ind-dy] );
-                m_vorticityForceW[ind] = h * ( m_vorticityMagnitude[ind+dz] - m_vorticityMagnitude[ind-dz] );
-            }
-        }
-    }
-    // Normalize the vorticity gradient  N = \frac{\eta}{|\eta|}
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                const int ind = index(i,j,k);
-                float len = std::sqrt( m_vorticityForceU[ind]*m_vorticityForceU[ind]
-                                     + m_vorticityForceV[ind]*m_vorticityForceV[ind]
-                                     + m_vorticityForceW[ind]*m_vorticityForceW[ind] );
-                float invlen = 0;
-                const float epsilon = 1e-10f;
-                if( len > epsilon )
-                {
-                    invlen = 1.0f / len;
-                }
-                m_vorticityForceU[ind] *= invlen;
-                m_vorticityForceV[ind] *= invlen;
-                m_vorticityForceW[ind] *= invlen;
-            }
-        }
-    }
-    // now m_vorticityForceUVW holds the gradient of the normalized velocity curl, AKA N in FSJ
-
-    // compute the final force as the scaled cross product of N x w
-    // or m_vorticityForce x m_velCurl, since vorticityForce temporarily holds N (normalized)
-    float f = m_vorticityConfinementFactor * (1.0/(m_N+2));
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                const int ind = index(i,j,k);
-                float nU = m_vorticityForceU[ind];
-                float nV = m_vorticityForceV[ind];
-                float nW = m_vorticityForceW[ind];
-                m_vorticityForceU[ind] = f * ( nV * m_vorticityW[ind] - nW * m_vorticityV[ind] );
-                m_vorticityForceV[ind] = f * ( nW * m_vorticityU[ind] - nU * m_vorticityW[ind] );
-                m_vorticityForceW[ind] = f * ( nU * m_vorticityV[ind] - nV * m_vorticityU[ind] );
-            }
-        }
-    }
-}
-
-/// Compute the scalar field d by back-projecting d_prev by velocity field vx,vy,vz
-void
-spark::Fluid
-::advect( int boundaryCondition, 
-          float* d, float* d_prev, 
-          float* vx, float* vy, float* vz, 
-          float dt )
-{
-    float dt0 = dt * m_N;
-    float x, y, z;  // back-traced position
-    int i0, i1, j0, j1, k0, k1;  // index of grid points around the back-traced position xyz
-    float s0, s1, t0, t1, u0, u1; // distance between grid points and xyz
-
-    for( size_t k = 1; k <= m_N; k++ )
-    {
-        for( size_t j = 1; j <= m_N; j++ )
-        {
-            for( size_t i = 1; i <= m_N; i++ )
-            {
-                // back-project the velocities to find x,y,z that landed here at i,j,k
-                x = i - dt0 * vx[index(i,j,k)]; 
-                y = j - dt0 * vy[index(i,j,k)];
-                z = k - dt0 * vz[index(i,j,k)]; 
-
-                // bound x,y,z to the grid  (so pulling from the outside of the grid gives 
-                // you the clamped edge)
-                x = std::max( 0.5f, x ); x = std::min( ((float)m_N)+0.5f, x );
-                y = std::max( 0.5f, y ); y = std::min( ((float)m_N)+0.5f, y );
-                z = std::max( 0.5f, z ); z = std::min( ((float)m_N)+0.5f, z );
-                // (xyz) lies inside a cell, get the coordinates around it.
-                // note -- we'll average x from coordinates
-                // i0,j0,k0, i1,j0,k0, i1,j1,k0, i0,j1,k0
-                // i0,j0,k1, i1,j0,k1, i1,j1,k1, i0,j1,k1
-                // note that the truncated xyz coord becomes i0,j0,z0
-                i0 = (int)x; i1 = i0+1;
-                j0 = (int)y; j1 = j0+1;
-                k0 = (int)z; k1 = k0+1;
-
-                // the distance of the xyz point from the ijk vertex
-                s1 = x - i0;  s0 = 1.0f - s1;
-                t1 = y - j0;  t0 = 1.0f - t1;
-                u1 = z - k0;  u0 = 1.0f - u1;
-
-                // reverse projection -- add up all the densities that would have 
-                // gotten to i,j,k
-                // scaled by the normalized distance from the xyz back-traced position
-                d[index(i,j,k)] 
-                =  s0*(
-                      t0*(u0*d_prev[index(i0,j0,k0)] + u1*d_prev[index(i0,j0,k1)])
-                    +(t1*(u0*d_prev[index(i0,j1,k0)] + u1*d_prev[index(i0,j1,k1)]))
-                  )
-                 + s1*(
-                      t0*(u0*d_prev[index(i1,j0,k0)] + u1*d_prev[index(i1,j0,k1)])
-                    +(t1*(u0*d_prev[index(i1,j1,k0)] + u1*d_prev[index(i1,j1,k1)]))
-                  );
-            }
-        }
-    }
-    enforceConcentrationBoundary( boundaryCondition, d );
-}
-
-void
-spark::Fluid
-::enforceBoundary( int dim, float* x )
-{
-    const float N = m_N;
-
-    // 4 walls
-    for( size_t a = 1; a <= N; a++ )
-    {
-        for( size_t b = 1; b <= N; b++ )
-        {
-            x[index(0,  a,b)] = dim==1 ? -x[index(1,a,b)] : x[index(1,a,b)];
-            x[index(N+1,a,b)] = dim==1 ? -x[index(N,a,b)] : x[index(N,a,b)];
-
-            x[index(a,0,  b)] = dim==2 ? -x[index(a,1,b)] : x[index(a,1,b)];
-            x[index(a,N+1,b)] = dim==2 ? -x[index(a,N,b)] : x[index(a,N,b)];
-
-            x[index(a,b,  0)] = dim==3 ? -x[index(a,b,1)] : x[index(a,b,1)];
-            x[index(a,b,N+1)] = dim==3 ? -x[index(a,b,N)] : x[index(a,b,N)];
-        }
-    }
-
-    // 12 edges
-    for( size_t a = 1; a <= N; ++a )
-    {
-        // x varies
-        x[index(a,0,0)] = 0.5*( x[index(a,1,0)] + x[index(a,0,1)] );
-        x[index(a,N+1,0)] = 0.5*( x[index(a,N,0)] + x[index(a,N+1,1)] );
-        x[index(a,0,N+1)] = 0.5*( x[index(a,1,N+1)] + x[index(a,0,N)] );
-        x[index(a,N+1,N+1)] = 0.5*( x[index(a,N,N+1)] + x[index(a,N+1,N)] );
-
-        // y varies
-        x[index(0,a,0)] = 0.5*( x[index(1,a,0)] + x[index(0,a,1)] );
-        x[index(N+1,a,0)] = 0.5*( x[index(N,a,0)] + x[index(N+1,a,1)] );
-        x[index(0,a,N+1)] = 0.5*( x[index(1,a,N+1)] + x[index(0,a,N)] );
-        x[index(N+1,a,N+1)] = 0.5*( x[index(N,a,N+1)] + x[index(N+1,a,N)] );
-
-        // z varies
-        x[index(0,0,a)] = 0.5*( x[index(1,0,a)] + x[index(0,1,a)] );
-        x[index(N+1,0,a)] = 0.5*( x[index(N,0,a)] + x[index(N+1,1,a)] );
-        x[index(0,N+1,a)] = 0.5*( x[index(1,N+1,a)] + x[index(0,N,a)] );
-        x[index(N+1,N+1,a)] = 0.5*( x[index(N,N+1,a)] + x[index(N+1,N,a)] );
-    }
-
-    // 8 corners
-    const float third = 1.0f/3.0f;
-    x[index(0,  0,  0  )] = third*( x[index(1,  0,  0)] + x[index(0,  1,  0)] + x[index(0,  0,  1)] );
-
-    x[index(N+1,0,  0  )] = third*( x[index(N,  0,  0)] + x[index(N+1,1,  0)] + x[index(N+1,0,  1)] );
-    x[index(0,  N+1,0  )] = third*( x[index(1,N+1,  0)] + x[index(0  ,N,  0)] + x[index(0,  N+1,1)] );
-    x[index(0,  0,  N+1)] = third*( x[index(1,  0,N+1)] + x[index(0  ,1,N+1)] + x[index(0,  0,  N)] );
-
-    x[index(0  ,N+1,N+1)] = third*( x[index(1,N+1,N+1)] + x[index(0,  N,N+1)] + x[index(0,  N+1,N)] );
-    x[index(N+1,0,  N+1)] = third*( x[index(N,0,  N+1)] + x[index(N+1,0,N+1)] + x[index(N+1,0,  N)] );
-    x[index(N+1,N+1,0  )] = third*( x[index(N,N+1,  0)] + x[index(N+1,N,  0)] + x[index(N+1,N+1,1)] );
-
-    x[index(N+1,N+1,N+1)] = third*( x[index(N,N+1,N+1)] + x[index(N+1,N,N+1)] + x[index(N+1,N+1,N)] );
-}
-
-void
-spark::Fluid
-::enforceConcentrationBoundary( int dim, float* x )
-{
-    const float N = m_N;
-    
-    // 4 walls
-    for( size_t a = 1; a <= N; a++ )
-    {
-        for( size_t b = 1; b <= N; b++ )
-        {
-            x[index(0,  a,b)] = 0;
-            x[index(N+1,a,b)] = 0;
-            
-            x[index(a,0,  b)] = dim==2 ? -x[index(a,1,b)] : x[index(a,1,b)];
-            x[index(a,N+1,b)] = 0;
-            
-            x[index(a,b,  0)] = 0;
-            x[index(a,b,N+1)] = 0;
-        }
-    }
-
-    // 12 edges
-    for( size_t a = 1; a <= N; ++a )
-    {
-        // x varies
-        x[index(a,0,0)] = 0;
-        x[index(a,N+1,0)] = 0;
-        x[index(a,0,N+1)] = 0;
-        x[index(a,N+1,N+1)] = 0;
-        
-        // y varies
-        x[index(0,a,0)] = 0;
-        x[index(N+1,a,0)] = 0;
-        x[index(0,a,N+1)] = 0;
-        x[index(N+1,a,N+1)] = 0;
-        
-        // z varies
-        x[index(0,0,a)] = 0;
-        x[index(N+1,0,a)] = 0;
-        x[index(0,N+1,a)] = 0;
-        x[index(N+1,N+1,a)] = 0;
-    }
-    
-    // 8 corners
-    const float third = 1.0f/3.0f;
-    x[index(0,  0,  0  )] = third*( x[index(1,  0,  0)] + x[index(0,  1,  0)] + x[index(0,  0,  1)] );
-    
-    x[index(N+1,0,  0  )] = third*( x[index(N,  0,  0)] + x[index(N+1,1,  0)] + x[index(N+1,0,  1)] );
-    x[index(0,  N+1,0  )] = third*( x[index(1,N+1,  0)] + x[index(0  ,N,  0)] + x[index(0,  N+1,1)] );
-    x[index(0,  0,  N+1)] = third*( x[index(1,  0,N+1)] + x[index(0  ,1,N+1)] + x[index(0,  0,  N)] );
-    
-    x[index(0  ,N+1,N+1)] = third*( x[index(1,N+1,N+1)] + x[index(0,  N,N+1)] + x[index(0,  N+1,N)] );
-    x[index(N+1,0,  N+1)] = third*( x[index(N,0,  N+1)] + x[index(N+1,0,N+1)] + x[index(N+1,0,  N)] );
-    x[index(N+1,N+1,0  )] = third*( x[index(N,N+1,  0)] + x[index(N+1,N,  0)] + x[index(N+1,N+1,1)] );
-    
-    x[index(N+1,N+1,N+1)] = third*( x[index(N,N+1,N+1)] + x[index(N+1,N,N+1)] + x[index(N+1,N+1,N)] );
-}
-
-
-void 
-spark::Fluid
-::stepVelocity( float dt )
-{
-    computeVorticityConfinment();
-    // update vel{UVW} with sources, including external and internal forces
-    addVelocitySources(dt);
-    
-    swapVelocityField();
-    // now the "current" velocity is in _prev, compute the 
-    // new vel from diffusion and put it in velU,velV,velW
-    diffuse( 1, m_velU, m_velU_prev, m_visc, dt );
-    diffuse( 2, m_velV, m_velV_prev, m_visc, dt );
-    diffuse( 3, m_velW, m_velW_prev, m_visc, dt );
-    
-    // project updates the m_vel field to enforce divergence free property on m_velUVW
-    project();
-    
-    swapVelocityField(); 
-    // now the "current" velocity is in _prev, compute the 
-    // new vel and put it in velU,velV,velW
-    advect( 1, m_velU, m_velU_prev,   m_velU_prev, m_velV_prev, m_velW_prev, dt );
-    advect( 2, m_velV, m_velV_prev,   m_velU_prev, m_velV_prev, m_velW_prev, dt );
-    advect( 3, m_velW, m_velW_prev,   m_velU_prev, m_velV_prev, m_velW_prev, dt );
-    // m_vel holds the new velocity
-    
-    // project updates the m_vel field to enforce divergence free property on m_velUVW
-    project();
-}
-
-void
-spark::Fluid
-::stepDensity( float dt )
-{
-    addDensitySources(dt);
-    
-    swapAdvectedFields(); // now m_density is ready for writing; density data in m_density_prev
-    diffuse( 0, m_density, m_density_prev, m_diff, dt );
-    // diffused density is now in m_density
-    
-    swapAdvectedFields(); // now m_density is ready for writing
-    advect( 0, m_density, m_density_prev, m_velU, m_velV, m_velW, dt );
-    // now m_density has the advected density
-}
-
-void 
-spark::Fluid
-::update( double dt )
-{
-    stepVelocity( dt * 0.05 );
-    stepDensity( dt * 0.05 );
-}
-
-void
-spark::Fluid
-::addSourceAtLocation( float x, float y, float deltaDensity, float maxDensity )
-{
-    //std::cerr << "Smoke source = " << x << ", " << y << "\n";
-    const float lenOfCell = 1.0f / (m_N+2);
-    int rx = (int)( (x/lenOfCell) + ( (float)(m_N+2)/2.0f ) );//+ 0.5f ) );
-    int ry = (int)( (y/lenOfCell) + ( (float)(m_N+2)/2.0f ) );//+ 0.5f ) );
-    
-    size_t i = index( rx, ry, m_N );
-    m_density[ i ] = std::min( m_density[i] + deltaDensity/(m_N+2), maxDensity );
-    //m_temp[ i ] = m_ambientTemp + 50.0;
-    //m_temp_prev[ i ] = m_ambientTemp + 50.0;
-
-
-
-    //m_density_prev[ i ] = 0.4;
-    //m_temp[ i ] = 150.0;
-    //m_temp_prev[ i ] = m_ambientTemp + 50.0;
-
-    //m_density[ index( rx, ry, 2) ] = 1;
-    //m_density_prev[ index( rx, ry, 2 ) ] = 1;
-    //m_density[ index( rx, ry, 3) ] = 1;
-    //m_density_prev[ index( rx, ry, 3 ) ] = 1;
-
-
-    //m_density[ index( 1, 1, 1) ] = 1;
-    //m_density_prev[ index( 1, 1, 1 ) ] = 1;
-
-    //m_density[ index( 1, m_N, 1) ] = 1;
-    //m_density_prev[ index( 1, m_N, 1 ) ] = 1;
-
-    //m_density[ index( m_N, 1, 1) ] = 1;
-    //m_density_prev[ index( m_N, 1, 1 ) ] = 1;
-
-    //m_density[ index(x+1,y+1,1) ] = 0.5f;
-    //m_density[ index(x+1,y-1,1) ] = 0.5f;
-    //m_density[ index(x-1,y+1,1) ] = 0.5f;
-    //m_density[ index(x-1,y-1,1) ] = 0.5f;
-
-    //m_density[ index(x,y,2) ] = 0.5f;
-    //m_density[ index(x+1,y+1,2) ] = 0.5f;
-    //m_density[ index(x+1,y-1,2) ] = 0.5f;
-    //m_density[ index(x-1,y+1,2) ] = 0.5f;
-    //m_density[ index(x-1,y-1,2) ] = 0.5f;
-
-    //m_density_source[ index(x,y,1) ] = 0.5f;
-    //m_temp[ index(x,y,1) ] = m_ambientTemp + 50.0f;
+#include "Fluid.hpp"
+#include "FluidRecorder.hpp"
+
+#include "Utilities.hpp" //< for getTime() only
+#include "Exceptions.hpp"
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+#include <boost/cstdint.hpp>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#elif defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+namespace
+{
+    /// Alignment of each field in the slab, a cache line.
+    const size_t fieldAlignment = 64;
+
+    /// Smallest grid side, in cells including the boundary.
+    const int minSize = 8;
+
+    /// Uninitialized memory for the fields, aligned to fieldAlignment.
+    /// With isHugePages, asks for transparent huge pages where supported
+    /// (Linux); elsewhere it is ignored.  Returns NULL on failure.
+    void* allocateSlab( size_t bytes, bool isHugePages )
+    {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if( isHugePages )
+        {
+            void* slab = mmap( NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+            if( slab == MAP_FAILED )
+            {
+                return NULL;
+            }
+            madvise( slab, bytes, MADV_HUGEPAGE );
+            return slab;
+        }
+#endif
+#if defined(_WIN32)
+        return _aligned_malloc( bytes, fieldAlignment );
+#else
+        void* slab = NULL;
+        return posix_memalign( &slab, fieldAlignment, bytes ) == 0 ? slab : NULL;
+#endif
+    }
+
+    /// Release a slab from allocateSlab( bytes, isHugePages ).
+    void freeSlab( void* slab, size_t bytes, bool isHugePages )
+    {
+        if( !slab )
+        {
+            return;
+        }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        if( isHugePages )
+        {
+            munmap( slab, bytes );
+            return;
+        }
+#endif
+#if defined(_WIN32)
+        _aligned_free( slab );
+#else
+        free( slab );
+#endif
+    }
+}
+
+std::ostream&
+spark::Fluid
+::writeYDensitySliceToPythonStream(std::ostream& out,
+                                   const std::string& varName,
+                                   unsigned int frame,
+                                   size_t j ) const
+{
+    out << varName << "[" << frame << "] = array( [";
+    for( size_t i=0; i < m_Nx+2; ++i )
+    {
+        out << "[";
+        for( size_t k=0; k < m_Nz+2; ++k )
+        {
+            out << m_density[index(i, j, k)];
+            if( k != (m_Nz+1) ) out << ", ";
+        }
+        out << "]";
+        if( i != (m_Nx+1) ) out << ", \n"; //new line optional
+    }
+    out << "], dtype=float32 )\n\n";
+    return out;
+}
+
+std::ostream&
+spark::Fluid
+::writeYVelocitySliceToPythonStream(std::ostream& out,
+                                    const std::string& varName,
+                                    unsigned int frame,
+                                    size_t j,
+                                    float dt ) const
+{
+    out << varName << "[" << frame <<"] = array( [";
+    const float dt0 = dt / m_cellSize;
+    for( size_t i=0; i < m_Nx+2; ++i )
+    {
+        out << "[";
+        for( size_t k=0; k < m_Nz+2; ++k )
+        {
+            out << "["
+                << dt0 * m_velU[index(i, j, k)] << ", "
+                << dt0 * m_velV[index(i, j, k)] << ", "
+                << dt0 * m_velW[index(i, j, k)] << "] ";
+            if( k != (m_Nz+1) ) out << ", ";
+        }
+        out << "]";
+        if( i != (m_Nx+1) ) out << ", \n"; //new line optional
+    }
+    out << "], dtype=float32 )\n\n";
+    return out;
+}
+
+spark::Fluid
+::Fluid( int sizeX, int sizeY, int sizeZ, float cellSize ) 
+    :
+    m_Nx( 0 ), m_Ny( 0 ), m_Nz( 0 ),
+    m_cellSize( cellSize ),
+    m_density( NULL ), m_density_prev( NULL ),
+    m_velU( NULL ), m_velV( NULL ), m_velW( NULL ),
+    m_temp( NULL ), m_temp_prev( NULL ),
+    m_vorticityU( NULL ), m_vorticityV( NULL ), m_vorticityW( NULL ),
+    m_vorticityMagnitude( NULL ),
+    m_vorticityForceU( NULL ), m_vorticityForceV( NULL ), m_vorticityForceW( NULL ),
+    m_velU_prev( NULL ), m_velV_prev( NULL ), m_velW_prev( NULL ),
+    m_solverIterations( 20 ),
+    m_size( 0 ),
+    m_visc( 0.0000 ),
+    m_diff( 0.000 ), // ????
+    m_div( NULL ), m_pressure( NULL ),
+    m_ambientTemp( 20.0f ),
+    m_tempFactor( 1.0f ), 
+    m_vorticityConfinementFactor( sizeX * 60.0f ),
+    m_absorption( 1.0 ),
+    m_threadPool( new ThreadPool() ),
+    m_threadCount( m_threadPool->threadCount() ),
+    m_kernels( &fluidKernels() ),
+    m_pressureSolver( GaussSeidelPressureSolver ),
+    m_gaussSeidelTolerance( 0.0f ),
+    m_multigridTolerance( 1e-3f ),
+    m_pressureIterations( 0 ),
+    m_pressureResidual( 0 ),
+    m_pressureResidualMax( 0 ),
+    m_pressureResidualInterval( 4 ),
+    m_isPressureWarmStart( true ),
+    m_isBrickSkipping( false ),
+    m_brickThreshold( 1e-5f ),
+    m_bricksX( 0 ), m_bricksY( 0 ), m_bricksZ( 0 ),
+    m_activeBrickCount( 0 ),
+    m_isVorticityOutput( false ),
+    m_targetCFL( 4.0f ),
+    m_maxSubsteps( 8 ),
+    m_updateBudget( 0 ),
+    m_pendingTime( 0 ),
+    m_substepCount( 0 ),
+    m_updateMilliseconds( 0 ),
+    m_cfl( 0 ),
+    m_slab( NULL ),
+    m_slabBytes( 0 ),
+    m_isSlabHugePages( false ),
+    m_isHugePages( false ),
+    m_isHalfFloatSnapshots( false ),
+    m_isClearingSources( false ),
+    m_isResetPending( false )
+{
+    m_gravityFactor[0] = 0;
+    m_gravityFactor[1] = 0;
+    m_gravityFactor[2] = 0.3f;
+    setDimensions( sizeX, sizeY, sizeZ, cellSize );
+    reallocate();
+    init();
+}
+
+void 
+spark::Fluid
+::reallocate( void )
+{
+    deleteData();
+
+    // All fields share one slab, each starting on a cache line.  Nothing
+    // is touched here; zeroData() does the first touch.
+    float** const fields[] =
+    {
+        &m_density, &m_density_prev,
+        &m_temp, &m_temp_prev,
+        &m_velU, &m_velU_prev,
+        &m_velV, &m_velV_prev,
+        &m_velW, &m_velW_prev,
+        &m_vorticityU, &m_vorticityV, &m_vorticityW,
+        &m_vorticityMagnitude,
+        &m_vorticityForceU, &m_vorticityForceV, &m_vorticityForceW,
+        &m_pressure, &m_div
+    };
+    const size_t fieldCount = sizeof( fields ) / sizeof( fields[0] );
+    const size_t fieldStride = ( m_size*sizeof( float ) + fieldAlignment - 1 ) / fieldAlignment * fieldAlignment;
+    m_slabBytes = fieldCount * fieldStride;
+    m_isSlabHugePages = m_isHugePages;
+    m_slab = (char*)allocateSlab( m_slabBytes, m_isSlabHugePages );
+    if( !m_slab )
+    {
+        throw SparkRunTimeException( "Fluid failed to allocate its fields" );
+    }
+    for( size_t f = 0; f < fieldCount; ++f )
+    {
+        *fields[f] = (float*)( m_slab + f * fieldStride );
+    }
+
+    m_multigrid.reset();
+
+    // Active sources hold flat indices into the old grid.  Queued ones
+    // are still world positions, rasterized at the next update().
+    m_sources.clear();
+    m_acquiredSources.clear();
+
+    m_bricksX = ( m_Nx + brickSize - 1 ) / brickSize;
+    m_bricksY = ( m_Ny + brickSize - 1 ) / brickSize;
+    m_bricksZ = ( m_Nz + brickSize - 1 ) / brickSize;
+    const size_t brickCount = m_bricksX * m_bricksY * m_bricksZ;
+    // everything starts active, so the first update zeroes the empty bricks
+    m_brickActive.assign( brickCount, 1 );
+    m_brickOccupied.assign( brickCount, 0 );
+    m_activeBrickCount = brickCount;
+
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        m_densitySnapshots.getBuffer( i ).assign( m_size, 0.0f );
+        m_halfDensitySnapshots.getBuffer( i ).assign( m_isHalfFloatSnapshots ? m_size : 0, 0 );
+    }
+}
+
+void
+spark::Fluid
+::deleteData( void )
+{
+    // Fields loaded from a checkpoint point into m_checkpoint instead
+    freeSlab( m_slab, m_slabBytes, m_isSlabHugePages );
+    m_slab = NULL;
+    m_slabBytes = 0;
+    m_checkpoint.reset();
+}
+
+spark::Fluid
+::~Fluid()
+{
+    deleteData();
+}
+
+void 
+spark::Fluid
+::init( void )
+{
+    zeroData();
+    publishDensitySnapshot();
+}
+
+void
+spark::Fluid
+::reset( void )
+{
+    m_isResetPending = true;
+    clearSources();
+}
+
+void
+spark::Fluid
+::setSize( int size )
+{
+    setSize( size, size, size, 0 );
+}
+
+void
+spark::Fluid
+::setSize( int sizeX, int sizeY, int sizeZ, float cellSize )
+{
+    setDimensions( sizeX, sizeY, sizeZ, cellSize );
+    reallocate();
+    init();
+}
+
+void
+spark::Fluid
+::setDimensions( int sizeX, int sizeY, int sizeZ, float cellSize )
+{
+    if( !sizeY ) sizeY = sizeX;
+    if( !sizeZ ) sizeZ = sizeX;
+    // enforce a minimum size
+    m_Nx = ( sizeX < minSize ) ? minSize : sizeX - 2;
+    m_Ny = ( sizeY < minSize ) ? minSize : sizeY - 2;
+    m_Nz = ( sizeZ < minSize ) ? minSize : sizeZ - 2;
+    m_size = (m_Nx+2)*(m_Ny+2)*(m_Nz+2);
+    // By default the longest side has unit length, as with the original cube
+    m_cellSize = cellSize > 0 ? cellSize 
+                              : 1.0f / std::max( m_Nx, std::max( m_Ny, m_Nz ) );
+}
+
+int
+spark::Fluid
+::getSize( void )
+{
+    return (int)m_Nx + 2;
+}
+
+void
+spark::Fluid
+::setThreadCount( unsigned int threadCount )
+{
+    m_threadCount = threadCount ? threadCount : ThreadPool::hardwareThreadCount();
+}
+
+void
+spark::Fluid
+::setBrickSkipping( bool isBrickSkipping )
+{
+    m_isBrickSkipping = isBrickSkipping;
+    // Bricks skipped until now were zeroed and stay valid, so just mark
+    // everything active; when skipping starts the next update recomputes.
+    std::fill( m_brickActive.begin(), m_brickActive.end(), 1 );
+    m_activeBrickCount = m_brickActive.size();
+}
+
+void
+spark::Fluid
+::updateActiveBricks( void )
+{
+    const float threshold = m_brickThreshold;
+    // Find bricks with content
+    m_threadPool->parallelFor( 0, m_bricksZ, [&]( size_t bzBegin, size_t bzEnd )
+    {
+        for( size_t bz = bzBegin; bz < bzEnd; ++bz )
+        {
+            const size_t kBegin = 1 + bz*brickSize;
+            const size_t kEnd = std::min( kBegin + brickSize, m_Nz + 1 );
+            for( size_t by = 0; by < m_bricksY; ++by )
+            {
+                const size_t jBegin = 1 + by*brickSize;
+                const size_t jEnd = std::min( jBegin + brickSize, m_Ny + 1 );
+                for( size_t bx = 0; bx < m_bricksX; ++bx )
+                {
+                    const size_t iBegin = 1 + bx*brickSize;
+                    const size_t iEnd = std::min( iBegin + brickSize, m_Nx + 1 );
+                    bool isOccupied = false;
+                    for( size_t k = kBegin; k < kEnd && !isOccupied; ++k )
+                    {
+                        for( size_t j = jBegin; j < jEnd && !isOccupied; ++j )
+                        {
+                            const size_t ind0 = index( 0, j, k );
+                            for( size_t i = iBegin; i < iEnd; ++i )
+                            {
+                                const size_t ind = ind0 + i;
+                                if( std::abs( m_density[ind] ) > threshold
+                                    || std::abs( m_velU[ind] ) > threshold
+                                    || std::abs( m_velV[ind] ) > threshold
+                                    || std::abs( m_velW[ind] ) > threshold
+                                    || std::abs( m_temp[ind] - m_ambientTemp ) > threshold )
+                                {
+                                    isOccupied = true;
+                                    break;
+                                }
+                            }
+                        }
+                    }
+                    m_brickOccupied[bx + m_bricksX*(by + m_bricksY*bz)] = isOccupied;
+                }
+            }
+        }
+    } );
+
+    // as are the bricks holding sources
+    for( size_t s = 0; s < m_sources.size(); ++s )
+    {
+        const ActiveSource& source = m_sources[s];
+        for( size_t bz = ( source.lo[2]-1 )/brickSize; bz <= ( source.hi[2]-1 )/brickSize; ++bz )
+        {
+            for( size_t by = ( source.lo[1]-1 )/brickSize; by <= ( source.hi[1]-1 )/brickSize; ++by )
+            {
+                for( size_t bx = ( source.lo[0]-1 )/brickSize; bx <= ( source.hi[0]-1 )/brickSize; ++bx )
+                {
+                    m_brickOccupied[bx + m_bricksX*(by + m_bricksY*bz)] = 1;
+                }
+            }
+        }
+    }
+
+    // Active bricks are occupied bricks plus a one-brick halo, so content
+    // can flow up to a brick width per step before it reaches a skipped brick.
+    m_activeBrickCount = 0;
+    for( size_t bz = 0; bz < m_bricksZ; ++bz )
+    {
+        for( size_t by = 0; by < m_bricksY; ++by )
+        {
+            for( size_t bx = 0; bx < m_bricksX; ++bx )
+            {
+                bool isActive = false;
+                for( size_t z = (bz ? bz-1 : 0); z <= std::min( bz+1, m_bricksZ-1 ) && !isActive; ++z )
+                {
+                    for( size_t y = (by ? by-1 : 0); y <= std::min( by+1, m_bricksY-1 ) && !isActive; ++y )
+                    {
+                        for( size_t x = (bx ? bx-1 : 0); x <= std::min( bx+1, m_bricksX-1 ); ++x )
+                        {
+                            if( m_brickOccupied[x + m_bricksX*(y + m_bricksY*z)] )
+                            {
+                                isActive = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+                unsigned char& active = m_brickActive[bx + m_bricksX*(by + m_bricksY*bz)];
+                if( active && !isActive )
+                {
+                    clearBrick( bx, by, bz );
+                }
+                active = isActive;
+                m_activeBrickCount += isActive;
+            }
+        }
+    }
+}
+
+void
+spark::Fluid
+::clearBrick( size_t bx, size_t by, size_t bz )
+{
+    // Sources are already zero, or the brick would be occupied.
+    float* const zeroFields[] = 
+    {
+        m_density, m_density_prev,
+        m_velU, m_velV, m_velW, m_velU_prev, m_velV_prev, m_velW_prev,
+        m_vorticityU, m_vorticityV, m_vorticityW, m_vorticityMagnitude,
+        m_vorticityForceU, m_vorticityForceV, m_vorticityForceW,
+        m_div, m_pressure
+    };
+    const size_t iBegin = 1 + bx*brickSize;
+    const size_t count = std::min( brickSize, m_Nx + 1 - iBegin );
+    const size_t jBegin = 1 + by*brickSize;
+    const size_t jEnd = std::min( jBegin + brickSize, m_Ny + 1 );
+    const size_t kBegin = 1 + bz*brickSize;
+    const size_t kEnd = std::min( kBegin + brickSize, m_Nz + 1 );
+    for( size_t k = kBegin; k < kEnd; ++k )
+    {
+        for( size_t j = jBegin; j < jEnd; ++j )
+        {
+            const size_t ind0 = index( iBegin, j, k );
+            for( size_t f = 0; f < sizeof( zeroFields ) / sizeof( zeroFields[0] ); ++f )
+            {
+                std::fill( zeroFields[f] + ind0, zeroFields[f] + ind0 + count, 0.0f );
+            }
+            std::fill( m_temp + ind0, m_temp + ind0 + count, m_ambientTemp );
+            std::fill( m_temp_prev + ind0, m_temp_prev + ind0 + count, m_ambientTemp );
+        }
+    }
+}
+
+void
+spark::Fluid
+::zeroData( void )
+{
+    float* const zeroFields[] =
+    {
+        m_density, m_density_prev,
+        m_velU, m_velU_prev,
+        m_velV, m_velV_prev,
+        m_velW, m_velW_prev,
+        m_vorticityU, m_vorticityV, m_vorticityW,
+        m_vorticityMagnitude,
+        m_vorticityForceU, m_vorticityForceV, m_vorticityForceW,
+        m_pressure, m_div
+    };
+    fillFields( zeroFields, sizeof( zeroFields ) / sizeof( zeroFields[0] ), 0.0f );
+    float* const tempFields[] = { m_temp, m_temp_prev };
+    fillFields( tempFields, 2, m_ambientTemp );
+}
+
+void
+spark::Fluid
+::fillFields( float* const fields[], size_t fieldCount, float value )
+{
+    m_threadPool->parallelFor( 1, m_Nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        // the first and last slabs also take the boundary slices
+        const size_t begin = index( 0, 0, kBegin == 1 ? 0 : kBegin );
+        const size_t end = index( 0, 0, kEnd == m_Nz+1 ? m_Nz+2 : kEnd );
+        for( size_t f = 0; f < fieldCount; ++f )
+        {
+            std::fill( fields[f] + begin, fields[f] + end, value );
+        }
+    } );
+}
+
+/// Create a 4x4x1 area at the bottom with high temp and source
+void
+spark::Fluid
+::addBottomSource( void )
+{
+    int cx  = m_Nx/2;
+    int cy  = 0;//m_Ny/4;
+    int cz  = m_Nz/2;
+    float r = (float)m_Nx/12.0f;
+
+    for( int x=1; x<(int)m_Nx; ++x )
+    {
+        for( int y=1; y<(int)m_Ny; ++y )
+        {
+            for( int z=1; z<(int)m_Nz; ++z )
+            {
+                float d = std::sqrt( 
+                    (x-(float)cx)*(x-(float)cx)
+                    + (y-(float)cy)*(y-(float)cy)
+                    + (z-(float)cz)*(z-(float)cz)
+                    );
+                if( d <= r )
+                {
+                    int i = index(x,y,z);
+                    m_density[i] = 0.5f;
+                    //m_density_source[i] = 10.0;
+                    //m_temp[i] = 4.2f * m_ambientTemp;
+                    //m_temp_source[i] = 1.8f * m_ambientTemp;
+                }
+            }
+        }
+    }
+}
+
+
+void
+spark::Fluid
+::addBoom( void )
+{
+    const float vu = 100;
+    const float vv = 100;
+    const float vw = 100;
+    const float d = 10.5;
+
+    const size_t cx = m_Nx/2;
+    const size_t cy = m_Ny/2;
+    const size_t cz = m_Nz/4;
+
+    // Initialize middle
+    m_velU[index(cx, cy, cz)] =   vu;
+    m_velU[index(cx-1, cy, cz)] = vu;
+    m_velU[index(cx+1, cy, cz)] = vu;
+    m_velU[index(cx, cy-1, cz)] = vu;
+    m_velU[index(cx, cy+1, cz)] = vu;
+    m_velU[index(cx, cy, cz-1)] = vu;
+    m_velU[index(cx, cy, cz+1)] = vu;
+
+    m_velV[index(cx, cy, cz)] =   vv;
+    m_velV[index(cx-1, cy, cz)] = vv;
+    m_velV[index(cx+1, cy, cz)] = vv;
+    m_velV[index(cx, cy-1, cz)] = vv;
+    m_velV[index(cx, cy+1, cz)] = vv;
+    m_velV[index(cx, cy, cz-1)] = vv;
+    m_velV[index(cx, cy, cz+1)] = vv;
+
+    m_velW[index(cx, cy, cz)] =   vw;
+    m_velW[index(cx-1, cy, cz)] = vw;
+    m_velW[index(cx+1, cy, cz)] = vw;
+    m_velW[index(cx, cy-1, cz)] = vw;
+    m_velW[index(cx, cy+1, cz)] = vw;
+    m_velW[index(cx, cy, cz-1)] = vw;
+    m_velW[index(cx, cy, cz+1)] = vw;
+
+    //// for starters, but a little density at the middle
+    m_density[index(m_Nx/2,     m_Ny/2,     m_Nz/2)] = d;
+    m_density[index(m_Nx/2 + 1, m_Ny/2 + 1, m_Nz/2)] = d;
+    m_density[index(m_Nx/2 + 1, m_Ny/2 - 1, m_Nz/2)] = d;
+    m_density[index(m_Nx/2 - 1, m_Ny/2 + 1, m_Nz/2)] = d;
+    m_density[index(m_Nx/2 - 1, m_Ny/2 - 1, m_Nz/2)] = d;
+    m_density[index(m_Nx/2, m_Ny/2, m_Nz/2+1)] = d;
+    m_density[index(m_Nx/2, m_Ny/2, m_Nz/2-1)] = d;
+
+    m_temp[index(m_Nx/2,     m_Ny/2,     m_Nz/2)] = 1.8f * m_ambientTemp;
+    m_temp[index(m_Nx/2 + 1, m_Ny/2 + 1, m_Nz/2)] = 1.8f * m_ambientTemp;
+    m_temp[index(m_Nx/2 + 1, m_Ny/2 - 1, m_Nz/2)] = 1.8f * m_ambientTemp;
+    m_temp[index(m_Nx/2 - 1, m_Ny/2 + 1, m_Nz/2)] = 1.8f * m_ambientTemp;
+    m_temp[index(m_Nx/2 - 1, m_Ny/2 - 1, m_Nz/2)] = 1.8f * m_ambientTemp;
+    m_temp[index(m_Nx/2, m_Ny/2, m_Nz/2+1)] = 1.8f * m_ambientTemp;
+    m_temp[index(m_Nx/2, m_Ny/2, m_Nz/2-1)] = 1.8f * m_ambientTemp;
+}
+
+void
+spark::Fluid
+::saveToFile( const char* filename )
+{
+    using namespace std;
+    ofstream out( filename, std::ios::ate );
+    out.precision( numeric_limits< double >::max_digits10 );
+    out << m_Nx << " " << m_Ny << " " << m_Nz << " " << m_cellSize << "\n";
+    assert( m_size == dimX()*dimY()*dimZ() );
+    // '\n' rather than endl, which would flush every value
+    for( size_t i = 0; i < m_size; ++i )
+    {
+        out << scientific << m_density[i] << "\n";
+    }
+}
+
+namespace
+{
+    /// Binary checkpoint of a Fluid, in native byte order.  The header is
+    /// followed by fieldCount fields of (Nx+2)(Ny+2)(Nz+2) floats, the
+    /// first at fieldOffset and each fieldStride bytes after the last.
+    /// Offsets are multiples of checkpointAlignment, so mapped fields are
+    /// as aligned as allocated ones.
+    struct CheckpointHeader
+    {
+        char magic[8];               //< checkpointMagic
+        boost::uint32_t version;     //< checkpointVersion when written
+        boost::uint32_t byteOrder;   //< checkpointByteOrder, as written by this machine
+        boost::uint32_t nx, ny, nz;  //< interior cells
+        float cellSize;
+        float visc, diff;
+        float ambientTemp, tempFactor;
+        float gravityFactor[3];
+        float vorticityConfinementFactor;
+        float absorption;
+        boost::uint32_t fieldCount;
+        boost::uint64_t fieldOffset;
+        boost::uint64_t fieldStride;
+    };
+    const char checkpointMagic[8] = { 'S', 'P', 'K', 'F', 'L', 'U', 'I', 'D' };
+    // Bump when the header changes.  Fields may be appended to
+    // getCheckpointFields() without a new version, as fieldCount says
+    // how many a file holds.
+    const boost::uint32_t checkpointVersion = 2;
+    // Version 1 also held five dense source fields, after the others
+    const boost::uint32_t checkpointSourceFieldsVersion = 1;
+    const size_t checkpointSourceFieldCount = 5;
+    const boost::uint32_t checkpointByteOrder = 0x01020304;
+    const boost::uint64_t checkpointAlignment = 64;
+    const size_t maxCheckpointFields = 16;
+
+    boost::uint64_t alignCheckpointOffset( boost::uint64_t offset )
+    {
+        return ( offset + checkpointAlignment - 1 ) / checkpointAlignment * checkpointAlignment;
+    }
+
+    /// Cells in each field of a checkpoint, boundary included, or 0 if
+    /// its sides are ones setDimensions() would change or the count
+    /// exceeds maxCells.  Never overflows.
+    boost::uint64_t checkpointCellCount( const CheckpointHeader& header, boost::uint64_t maxCells )
+    {
+        const boost::uint32_t sides[3] = { header.nx, header.ny, header.nz };
+        boost::uint64_t cells = 1;
+        for( size_t a = 0; a < 3; ++a )
+        {
+            const boost::uint64_t side = (boost::uint64_t)sides[a] + 2;
+            if( side < (boost::uint64_t)minSize
+                || side > (boost::uint64_t)std::numeric_limits< int >::max()
+                || side > maxCells / cells )
+            {
+                return 0;
+            }
+            cells *= side;
+        }
+        return cells;
+    }
+}
+
+size_t
+spark::Fluid
+::getCheckpointFields( float** fields[] ) const
+{
+    float** const checkpointFields[] = 
+    {
+        const_cast< float** >( &m_density ), 
+        const_cast< float** >( &m_temp ),
+        const_cast< float** >( &m_velU ), 
+        const_cast< float** >( &m_velV ), 
+        const_cast< float** >( &m_velW ),
+        const_cast< float** >( &m_pressure )
+    };
+    const size_t count = sizeof( checkpointFields ) / sizeof( checkpointFields[0] );
+    if( fields )
+    {
+        std::copy( checkpointFields, checkpointFields + count, fields );
+    }
+    return count;
+}
+
+void
+spark::Fluid
+::saveCheckpoint( const char* filename ) const
+{
+    float** fields[maxCheckpointFields];
+    CheckpointHeader header;
+    std::memset( &header, 0, sizeof( header ) );
+    std::copy( checkpointMagic, checkpointMagic + 8, header.magic );
+    header.version = checkpointVersion;
+    header.byteOrder = checkpointByteOrder;
+    header.nx = (boost::uint32_t)m_Nx;
+    header.ny = (boost::uint32_t)m_Ny;
+    header.nz = (boost::uint32_t)m_Nz;
+    header.cellSize = m_cellSize;
+    header.visc = m_visc;
+    header.diff = m_diff;
+    header.ambientTemp = m_ambientTemp;
+    header.tempFactor = m_tempFactor;
+    std::copy( m_gravityFactor, m_gravityFactor + 3, header.gravityFactor );
+    header.vorticityConfinementFactor = m_vorticityConfinementFactor;
+    header.absorption = m_absorption;
+    header.fieldCount = (boost::uint32_t)getCheckpointFields( fields );
+    header.fieldOffset = alignCheckpointOffset( sizeof( header ) );
+    header.fieldStride = alignCheckpointOffset( m_size * sizeof( float ) );
+
+    std::ofstream out( filename, std::ios::binary | std::ios::trunc );
+    const char padding[checkpointAlignment] = { 0 };
+    out.write( (const char*)&header, sizeof( header ) );
+    out.write( padding, header.fieldOffset - sizeof( header ) );
+    for( size_t f = 0; f < header.fieldCount; ++f )
+    {
+        out.write( (const char*)*fields[f], m_size * sizeof( float ) );
+        out.write( padding, header.fieldStride - m_size * sizeof( float ) );
+    }
+    if( !out )
+    {
+        throw SparkRunTimeException( std::string( "Failed to write Fluid checkpoint " ) + filename );
+    }
+}
+
+void
+spark::Fluid
+::loadCheckpoint( const char* filename )
+{
+    using namespace boost::interprocess;
+    const std::string name( filename );
+    spark::shared_ptr< mapped_region > region;
+    try
+    {
+        // Private pages: the solver may write the fields, never the file
+        const file_mapping file( filename, read_only );
+        region.reset( new mapped_region( file, copy_on_write ) );
+    }
+    catch( interprocess_exception& e )
+    {
+        throw SparkRunTimeException( "Failed to map Fluid checkpoint " + name + ": " + e.what() );
+    }
+    const char* data = (const char*)region->get_address();
+    const size_t fileSize = region->get_size();
+
+    CheckpointHeader header;
+    if( fileSize < sizeof( header ) )
+    {
+        throw SparkRunTimeException( "Fluid checkpoint " + name + " is truncated" );
+    }
+    std::memcpy( &header, data, sizeof( header ) );
+    if( !std::equal( checkpointMagic, checkpointMagic + 8, header.magic ) )
+    {
+        throw SparkRunTimeException( name + " is not a Fluid checkpoint" );
+    }
+    if( header.byteOrder != checkpointByteOrder )
+    {
+        throw SparkRunTimeException( "Fluid checkpoint " + name + " was written with another byte order" );
+    }
+    const size_t knownFieldCount = getCheckpointFields( NULL )
+        + ( header.version <= checkpointSourceFieldsVersion ? checkpointSourceFieldCount : 0 );
+    if( header.version > checkpointVersion || header.fieldCount > knownFieldCount )
+    {
+        throw SparkRunTimeException( "Fluid checkpoint " + name + " is from a newer version" );
+    }
+
+    // Check the whole layout before changing anything, so a bad file
+    // leaves this fluid as it was.  The field end is compared by division,
+    // which can't overflow as fieldOffset + fieldCount*fieldStride could.
+    const boost::uint64_t cellCount = checkpointCellCount( header, header.fieldStride / sizeof( float ) );
+    if( header.fieldOffset % checkpointAlignment != 0 
+        || header.fieldStride % checkpointAlignment != 0
+        || cellCount == 0
+        || header.fieldOffset > fileSize
+        || ( header.fieldCount != 0
+             && header.fieldStride > ( fileSize - header.fieldOffset ) / header.fieldCount ) )
+    {
+        throw SparkRunTimeException( "Fluid checkpoint " + name + " is truncated or corrupt" );
+    }
+    setDimensions( header.nx+2, header.ny+2, header.nz+2, header.cellSize );
+    assert( m_size == cellCount );
+    m_visc = header.visc;
+    m_diff = header.diff;
+    m_ambientTemp = header.ambientTemp;
+    m_tempFactor = header.tempFactor;
+    std::copy( header.gravityFactor, header.gravityFactor + 3, m_gravityFactor );
+    m_vorticityConfinementFactor = header.vorticityConfinementFactor;
+    m_absorption = header.absorption;
+
+    // Swap in the mapped fields, then clear the rest without touching
+    // the mapping, which would copy its pages.  The slab pages the mapped
+    // fields replace are never touched, so they cost no memory.  Sources
+    // aren't saved; the dense ones of old files are ignored.
+    reallocate();
+    float** fields[maxCheckpointFields];
+    const size_t fieldCount = getCheckpointFields( fields );
+    const size_t mappedFieldCount = std::min( fieldCount, (size_t)header.fieldCount );
+    for( size_t f = 0; f < mappedFieldCount; ++f )
+    {
+        *fields[f] = (float*)( data + header.fieldOffset + f * header.fieldStride );
+    }
+    float* scratchFields[maxCheckpointFields + 12] =
+    {
+        m_density_prev, m_velU_prev, m_velV_prev, m_velW_prev,
+        m_vorticityU, m_vorticityV, m_vorticityW, m_vorticityMagnitude,
+        m_vorticityForceU, m_vorticityForceV, m_vorticityForceW,
+        m_div
+    };
+    size_t scratchCount = 12;
+    for( size_t f = mappedFieldCount; f < fieldCount; ++f )
+    {
+        scratchFields[scratchCount++] = *fields[f];
+    }
+    fillFields( scratchFields, scratchCount, 0.0f );
+    fillFields( &m_temp_prev, 1, m_ambientTemp );
+    m_checkpoint = region;
+    m_pendingTime = 0;
+    publishDensitySnapshot();
+    LOG_DEBUG(g_log) << "Mapped checkpoint with N=" << m_Nx << "x" << m_Ny << "x" << m_Nz
+                     << ", " << header.fieldCount << " fields\n";
+}
+
+void
+spark::Fluid
+::loadFromFile( const char* filename )
+{
+    using namespace std;
+    ifstream infile( filename );
+    // Header is "Nx Ny Nz cellSize"; older files hold only N for a cube.
+    string header;
+    getline( infile, header );
+    istringstream headerStream( header );
+    int n[3] = { 0, 0, 0 };
+    float cellSize = 0;
+    headerStream >> n[0] >> n[1] >> n[2] >> cellSize;
+    if( !n[1] || !n[2] )
+    {
+        n[1] = n[2] = n[0];
+    }
+    setDimensions( n[0]+2, n[1]+2, n[2]+2, cellSize );
+    reallocate();
+    init();
+    for( size_t i = 0; i < m_size; ++i )
+    {
+        infile >> m_density[i];
+        m_density_prev[i] = m_density[i];
+    }
+    publishDensitySnapshot();
+    LOG_DEBUG(g_log) << "Finished loading file with N=" << m_Nx << "x" << m_Ny << "x" << m_Nz
+                     << " and size=" << m_size << "\n";
+}
+
+void
+spark::Fluid
+::addDensitySources( float dt )
+{
+    for( size_t s = 0; s < m_sources.size(); ++s )
+    {
+        const ActiveSource& source = m_sources[s];
+        const float scale = std::min( dt, source.remaining ) / source.cells.size();
+        const float density = scale * source.source.density;
+        const float temperature = scale * source.source.temperature;
+        for( size_t c = 0; c < source.cells.size(); ++c )
+        {
+            const size_t ind = source.cells[c];
+            if( density != 0 )
+            {
+                m_density[ind] = std::min( m_density[ind] + density, source.source.maxDensity );
+            }
+            m_temp[ind] += temperature;
+        }
+    }
+}
+
+void
+spark::Fluid
+::addVelocitySources( float dt )
+{
+    for( size_t s = 0; s < m_sources.size(); ++s )
+    {
+        const ActiveSource& source = m_sources[s];
+        const float scale = std::min( dt, source.remaining ) / source.cells.size();
+        for( size_t c = 0; c < source.cells.size(); ++c )
+        {
+            const size_t ind = source.cells[c];
+            m_velU[ind] += scale * source.source.velocity[0];
+            m_velV[ind] += scale * source.source.velocity[1];
+            m_velW[ind] += scale * source.source.velocity[2];
+        }
+    }
+
+    forEachActiveRow( 1, m_Nz+1, [&]( size_t i, size_t j, size_t k, size_t count )
+    {
+        const size_t ind0 = index(i,j,k);
+        for( size_t ind = ind0; ind < ind0 + count; ++ind )
+        {
+            // Buoyancy force
+            // assume z = 0,0,1 so only affect w
+            m_velW[ind]    += dt * m_tempFactor * ( m_temp[ind] - m_ambientTemp );
+
+            // Gravity force
+            // assume z = 0,0,1
+            m_velU[ind]    -= dt * m_density[ind] * m_gravityFactor[0];
+            m_velV[ind]    -= dt * m_density[ind] * m_gravityFactor[1];
+            m_velW[ind]    -= dt * m_density[ind] * m_gravityFactor[2];
+
+            // Vorticity confinement term
+            m_velU[ind]    += dt * m_vorticityForceU[ind];
+            m_velV[ind]    += dt * m_vorticityForceV[ind];
+            m_velW[ind]    += dt * m_vorticityForceW[ind];
+        }
+    } );
+}
+
+void
+spark::Fluid
+::project( void )
+{
+    // compute divergence of velocity field
+    float* div = m_div;//m_velV_prev;  
+    float* p   = m_pressure; //m_velU_prev;  
+    float* vx  = m_velU;
+    float* vy  = m_velV;
+    float* vz  = m_velW;
+    float  a   = -0.5f*m_cellSize;
+    m_threadPool->parallelFor( 1, m_Nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        forEachActiveRow( kBegin, kEnd, [&]( size_t iBegin, size_t j, size_t k, size_t count )
+        {
+            for( size_t i = iBegin; i < iBegin + count; i++ )
+            {
+                div[index(i, j, k)] = 
+                    a * (  vx[index(i+1, j,   k  )] - vx[index(i-1,j,  k  )]
+                         + vy[index(i,   j+1, k  )] - vy[index(i,  j-1,k  )]
+                         + vz[index(i,   j,   k+1)] - vz[index(i,  j,  k-1)] );
+            }
+            if( !m_isPressureWarmStart )
+            {
+                std::fill( p + index(iBegin, j, k), p + index(iBegin, j, k) + count, 0.0f );
+            }
+        } );
+    } );
+
+    enforceConcentrationBoundary( 0, div );
+    enforceConcentrationBoundary( 0, p );
+
+    if( m_pressureSolver == MultigridPressureSolver )
+    {
+        if( !m_multigrid )
+        {
+            m_multigrid.reset( new MultigridSolver( m_Nx, m_Ny, m_Nz ) );
+        }
+        m_pressureIterations = m_multigrid->solve( p, div, 
+                                                   m_multigridTolerance, m_solverIterations,
+                                                   *m_threadPool, *m_kernels );
+        enforceConcentrationBoundary( 0, p );
+        // Measured the same way for both solvers, after the boundary is set.
+        linearResidual( p, div, 1, 6, m_pressureResidual, m_pressureResidualMax );
+    }
+    else
+    {
+        // Gauss-Seidel solver of the pressure field
+        m_pressureIterations = linearSolve( 0, p, div, 1, 6, m_gaussSeidelTolerance,
+                                            &m_pressureResidual, &m_pressureResidualMax );
+    }
+    const PressureSolveStats stats = { m_pressureIterations, m_pressureResidual, m_pressureResidualMax };
+    m_pressureSolveStats.push_back( stats );
+
+    // subtract the gradient of pressure field from velocity
+    const float g = 0.5f / m_cellSize;
+    m_threadPool->parallelFor( 1, m_Nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        forEachActiveRow( kBegin, kEnd, [&]( size_t iBegin, size_t j, size_t k, size_t count )
+        {
+            for( size_t i = iBegin; i < iBegin + count; i++ )
+            {
+                vx[index(i,j,k)] -= g*( p[index(i+1, j,   k  )] - p[index(i-1, j,   k  )] );
+                vy[index(i,j,k)] -= g*( p[index(i,   j+1, k  )] - p[index(i,   j-1, k  )] );
+                vz[index(i,j,k)] -= g*( p[index(i,   j,   k+1)] - p[index(i,   j,   k-1)] );
+            }
+        } );
+    } );
+    enforceConcentrationBoundary( 1, vx );
+    enforceConcentrationBoundary( 2, vy );
+    enforceConcentrationBoundary( 3, vz );
+}
+
+void 
+spark::Fluid
+::diffuse( int boundaryCondition, 
+           float* x, float* x_prev, 
+           float diff, float dt )
+{
+    float a = dt * diff / ( m_cellSize * m_cellSize * m_cellSize );
+    linearSolve( boundaryCondition, x, x_prev, a, 1+6*a );
+}
+
+void
+spark::Fluid
+::linearSolveSlow( int boundaryCondition, 
+                   float* x, float* x_prev, 
+                   float a, float c )
+{
+    const float invC = 1.0 / c;
+    //LOG_DEBUG(g_log) << "PRE linear Solve a=" << a << ", invc=" << invC << ",  middle voxel = " << x[index(m_Nx/2, m_Ny/2, m_Nz/2)] << " prev=" << x_prev[index(m_Nx/2, m_Ny/2, m_Nz/2)] << "\n";
+    for ( size_t iter = 0 ; iter < m_solverIterations; ++iter ) 
+    {
+        for( size_t k = 1; k <= m_Nz; k++ )
+        {
+            for( size_t j = 1; j <= m_Ny; j++ )
+            {
+                for( size_t i = 1; i <= m_Nx; i++ )
+                {
+                    x[index(i, j, k)] = invC * ( x_prev[index(i, j, k)] 
+                    + a*( x[index(i-1, j,   k  )] 
+                        + x[index(i+1, j,   k  )] 
+                        + x[index(i,   j-1, k  )]
+                        + x[index(i,   j+1, k  )]
+                        + x[index(i,   j,   k-1)] 
+                        + x[index(i,   j,   k+1)] 
+                      )
+                    );
+                }
+            }
+        }
+        // Each iteration, enforce boundary
+        enforceConcentrationBoundary( boundaryCondition, x );
+    }
+    //LOG_DEBUG(g_log) << "POST linear Solve a=" << a << ", invc=" << invC << ",  middle voxel = " << x[index(m_Nx/2, m_Ny/2, m_Nz/2)] << " prev=" << x_prev[index(m_Nx/2, m_Ny/2, m_Nz/2)] << "\n";
+}
+
+unsigned int
+spark::Fluid
+::linearSolve( int boundaryCondition, 
+               float* x, float* x_prev, 
+               float a, float c, 
+               float tolerance,
+               float* outResidual, float* outResidualMax )
+{
+    const float invC = 1.0 / c;
+    unsigned int iter = 0;
+    float residual = 0, residualMax = 0;
+    bool isResidualCurrent = false;
+    while( iter < m_solverIterations )
+    {
+        if( tolerance > 0 && iter % m_pressureResidualInterval == 0 )
+        {
+            linearResidual( x, x_prev, a, c, residual, residualMax );
+            if( residual <= tolerance )
+            {
+                isResidualCurrent = true;
+                break;
+            }
+        }
+        ++iter;
+        // Red cells only depend on black cells and vice versa,
+        // so each half-sweep is split into independent z-slabs.
+        for( int color = 0; color < 2; ++color )
+        {
+            m_threadPool->parallelFor( 1, m_Nz+1, [&]( size_t kBegin, size_t kEnd )
+            {
+                relaxRedBlackSlab( color, x, x_prev, a, invC, kBegin, kEnd );
+            } );
+        }
+        // Each iteration, enforce boundary
+        enforceConcentrationBoundary( boundaryCondition, x );
+    }
+    if( outResidual && outResidualMax )
+    {
+        if( !isResidualCurrent )
+        {
+            linearResidual( x, x_prev, a, c, residual, residualMax );
+        }
+        *outResidual = residual;
+        *outResidualMax = residualMax;
+    }
+    return iter;
+}
+
+void
+spark::Fluid
+::linearResidual( const float* x, const float* x_prev, 
+                  float a, float c, 
+                  float& outResidual, float& outResidualMax ) const
+{
+    // Per z-slice sums and maxima, so slabs can be measured concurrently
+    // and the totals don't depend on the thread count.
+    std::vector< double > residualSum( m_Nz+2, 0.0 ), rhsSum( m_Nz+2, 0.0 );
+    std::vector< float > residualMax( m_Nz+2, 0.0f ), rhsMax( m_Nz+2, 0.0f );
+    const size_t dim = dimX();
+    const size_t dim2 = dimX()*dimY();
+    m_threadPool->parallelFor( 1, m_Nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        forEachActiveRow( kBegin, kEnd, [&]( size_t iBegin, size_t j, size_t k, size_t count )
+        {
+            const size_t rowBegin = index( iBegin, j, k );
+            for( size_t ind = rowBegin; ind < rowBegin + count; ind++ )
+            {
+                const float r = x_prev[ind] - c*x[ind]
+                    + a*( x[ind-1] + x[ind+1] + x[ind-dim] + x[ind+dim] + x[ind-dim2] + x[ind+dim2] );
+                residualSum[k] += r*r;
+                rhsSum[k] += x_prev[ind]*x_prev[ind];
+                residualMax[k] = std::max( residualMax[k], std::fabs( r ) );
+                rhsMax[k] = std::max( rhsMax[k], std::fabs( x_prev[ind] ) );
+            }
+        } );
+    } );
+    double residualNorm = 0, rhsNorm = 0;
+    for( size_t k = 1; k <= m_Nz; k++ )
+    {
+        residualNorm += residualSum[k];
+        rhsNorm += rhsSum[k];
+    }
+    const float rhsMaxNorm = *std::max_element( rhsMax.begin(), rhsMax.end() );
+    // x = 0 solves a zero right-hand side exactly
+    outResidual = rhsNorm > 0 ? (float)std::sqrt( residualNorm / rhsNorm ) : 0.0f;
+    outResidualMax = rhsMaxNorm > 0 
+        ? *std::max_element( residualMax.begin(), residualMax.end() ) / rhsMaxNorm : 0.0f;
+}
+
+void
+spark::Fluid
+::relaxRedBlackSlab( int color, 
+                     float* x, const float* x_prev, 
+                     float a, float invC, 
+                     size_t kBegin, size_t kEnd )
+{
+    const ptrdiff_t dim = dimX();
+    const ptrdiff_t dim2 = dimX()*dimY();
+    forEachActiveRow( kBegin, kEnd, [&]( size_t i, size_t j, size_t k, size_t count )
+    {
+        // first cell in this run with (i+j+k)%2 == color is i + first
+        const size_t first = (i + j + k + color) & 1;
+        m_kernels->relaxRow( x, x_prev, index(i, j, k), count, first, 
+                             dim, dim2, a, invC );
+    } );
+}
+
+void 
+spark::Fluid
+::computeVorticityConfinment( void )
+{
+    if( m_vorticityConfinementFactor == 0.0 )
+    {
+        return;
+    }
+    const float h = 2.0f*m_cellSize; // width of two voxels
+    // With the default cell size this is 1/(N+2) of the longest side,
+    // the scale the default factor and existing scenes were tuned for.
+    const size_t longest = std::max( m_Nx, std::max( m_Ny, m_Nz ) );
+    const float f = m_vorticityConfinementFactor * m_cellSize * longest / ( longest + 2 );
+    const size_t sliceSize = dimX()*dimY();
+    const ptrdiff_t dy = dimX();
+    const ptrdiff_t dz = sliceSize;
+
+    // \omega = \nabla \cross u, the vorticity
+    // \eta = \nabla | \omega |  -- gradient of the scalar field that is the magnitude of the vorticity
+    // N = \frac{\eta}{|\eta|}, the force is N \cross \omega  (FSJ)
+    // The force at slice k needs | \omega | of slices k-1 to k+1, so each
+    // slab keeps \omega and | \omega | of the last three slices it computed
+    // and the slices either side of the slab are computed by both neighbors.
+    m_threadPool->parallelFor( 1, m_Nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        // window slot s holds slice k with k%3 == s, as vorticity U,V,W and magnitude
+        std::vector< float > window( 3*4*sliceSize, 0.0f );
+        float* slot[3][4];
+        for( size_t s = 0; s < 3; ++s )
+        {
+            for( size_t c = 0; c < 4; ++c )
+            {
+                slot[s][c] = &window[(4*s + c)*sliceSize];
+            }
+        }
+        for( size_t k = kBegin - 1; k <= kEnd; ++k )
+        {
+            float* const* w = slot[k%3];
+            // the magnitude is read around each cell, so cells not computed
+            // below (boundary slices, skipped bricks) must be zero
+            if( k == 0 || k > m_Nz || m_isBrickSkipping )
+            {
+                std::fill( w[3], w[3] + sliceSize, 0.0f );
+            }
+            if( k >= 1 && k <= m_Nz )
+            {
+                const bool isOutput = m_isVorticityOutput && k >= kBegin && k < kEnd;
+                // velocity is offset to slice k, so that ind0 indexes the slice
+                const size_t offset = k*sliceSize;
+                forEachActiveRow( k, k+1, [&]( size_t i, size_t j, size_t, size_t count )
+                {
+                    const size_t ind0 = index(i,j,0);
+                    m_kernels->vorticityRow( w[0], w[1], w[2], w[3],
+                                             m_velU + offset, m_velV + offset, m_velW + offset,
+                                             ind0, count, dy, dz, h );
+                    if( isOutput )
+                    {
+                        float* const outputs[] = { m_vorticityU, m_vorticityV, m_vorticityW, m_vorticityMagnitude };
+                        for( size_t c = 0; c < 4; ++c )
+                        {
+                            std::copy( w[c] + ind0, w[c] + ind0 + count, outputs[c] + offset + ind0 );
+                        }
+                    }
+                } );
+            }
+            if( k > kBegin )
+            {
+                // slices k-2 to k are in the window, so finish slice k-1
+                const size_t kc = k - 1;
+                float* const* below = slot[(kc-1)%3];
+                float* const* center = slot[kc%3];
+                float* const* above = slot[k%3];
+                const size_t offset = kc*sliceSize;
+                forEachActiveRow( kc, kc+1, [&]( size_t i, size_t j, size_t, size_t count )
+                {
+                    m_kernels->confinementRow( m_vorticityForceU + offset,
+                                               m_vorticityForceV + offset,
+                                               m_vorticityForceW + offset,
+                                               below[3], center[3], above[3],
+                                               center[0], center[1], center[2],
+                                               index(i,j,0), count, dy, h, f );
+                } );
+            }
+        }
+    } );
+}
+
+/// Compute the scalar field d by back-projecting d_prev by velocity field vx,vy,vz
+void
+spark::Fluid
+::advect( int boundaryCondition, 
+          float* d, float* d_prev, 
+          float* vx, float* vy, float* vz, 
+          float dt )
+{
+    const float dt0 = dt / m_cellSize;
+    const ptrdiff_t dy = index(0,1,0) - index(0,0,0);
+    const ptrdiff_t dz = index(0,0,1) - index(0,0,0);
+
+    // d is only written at i,j,k and d_prev is only read, so slabs are independent
+    m_threadPool->parallelFor( 1, m_Nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        forEachActiveRow( kBegin, kEnd, [&]( size_t i, size_t j, size_t k, size_t count )
+        {
+            // reverse projection -- add up all the densities that would have 
+            // gotten to i,j,k
+            // scaled by the normalized distance from the xyz back-traced position
+            m_kernels->advectRow( d, d_prev, vx, vy, vz, 
+                                  index(i,j,k), count, 
+                                  (float)i, (float)j, (float)k,
+                                  dy, dz, dt0,
+                                  m_Nx+0.5f, m_Ny+0.5f, m_Nz+0.5f );
+        } );
+    } );
+    enforceConcentrationBoundary( boundaryCondition, d );
+}
+
+void
+spark::Fluid
+::enforceBoundary( int dim, float* x )
+{
+    const size_t X = m_Nx;
+    const size_t Y = m_Ny;
+    const size_t Z = m_Nz;
+
+    // 6 walls
+    for( size_t k = 1; k <= Z; k++ )
+    {
+        for( size_t j = 1; j <= Y; j++ )
+        {
+            x[index(0,  j,k)] = dim==1 ? -x[index(1,j,k)] : x[index(1,j,k)];
+            x[index(X+1,j,k)] = dim==1 ? -x[index(X,j,k)] : x[index(X,j,k)];
+        }
+        for( size_t i = 1; i <= X; i++ )
+        {
+            x[index(i,0,  k)] = dim==2 ? -x[index(i,1,k)] : x[index(i,1,k)];
+            x[index(i,Y+1,k)] = dim==2 ? -x[index(i,Y,k)] : x[index(i,Y,k)];
+        }
+    }
+    for( size_t j = 1; j <= Y; j++ )
+    {
+        for( size_t i = 1; i <= X; i++ )
+        {
+            x[index(i,j,  0)] = dim==3 ? -x[index(i,j,1)] : x[index(i,j,1)];
+            x[index(i,j,Z+1)] = dim==3 ? -x[index(i,j,Z)] : x[index(i,j,Z)];
+        }
+    }
+
+    // 12 edges
+    for( size_t a = 1; a <= X; ++a )
+    {
+        // x varies
+        x[index(a,0,0)] = 0.5*( x[index(a,1,0)] + x[index(a,0,1)] );
+        x[index(a,Y+1,0)] = 0.5*( x[index(a,Y,0)] + x[index(a,Y+1,1)] );
+        x[index(a,0,Z+1)] = 0.5*( x[index(a,1,Z+1)] + x[index(a,0,Z)] );
+        x[index(a,Y+1,Z+1)] = 0.5*( x[index(a,Y,Z+1)] + x[index(a,Y+1,Z)] );
+    }
+    for( size_t a = 1; a <= Y; ++a )
+    {
+        // y varies
+        x[index(0,a,0)] = 0.5*( x[index(1,a,0)] + x[index(0,a,1)] );
+        x[index(X+1,a,0)] = 0.5*( x[index(X,a,0)] + x[index(X+1,a,1)] );
+        x[index(0,a,Z+1)] = 0.5*( x[index(1,a,Z+1)] + x[index(0,a,Z)] );
+        x[index(X+1,a,Z+1)] = 0.5*( x[index(X,a,Z+1)] + x[index(X+1,a,Z)] );
+    }
+    for( size_t a = 1; a <= Z; ++a )
+    {
+        // z varies
+        x[index(0,0,a)] = 0.5*( x[index(1,0,a)] + x[index(0,1,a)] );
+        x[index(X+1,0,a)] = 0.5*( x[index(X,0,a)] + x[index(X+1,1,a)] );
+        x[index(0,Y+1,a)] = 0.5*( x[index(1,Y+1,a)] + x[index(0,Y,a)] );
+        x[index(X+1,Y+1,a)] = 0.5*( x[index(X,Y+1,a)] + x[index(X+1,Y,a)] );
+    }
+
+    // 8 corners
+    const float third = 1.0f/3.0f;
+    x[index(0,  0,  0  )] = third*( x[index(1,  0,  0)] + x[index(0,  1,  0)] + x[index(0,  0,  1)] );
+
+    x[index(X+1,0,  0  )] = third*( x[index(X,  0,  0)] + x[index(X+1,1,  0)] + x[index(X+1,0,  1)] );
+    x[index(0,  Y+1,0  )] = third*( x[index(1,Y+1,  0)] + x[index(0  ,Y,  0)] + x[index(0,  Y+1,1)] );
+    x[index(0,  0,  Z+1)] = third*( x[index(1,  0,Z+1)] + x[index(0  ,1,Z+1)] + x[index(0,  0,  Z)] );
+
+    x[index(0  ,Y+1,Z+1)] = third*( x[index(1,Y+1,Z+1)] + x[index(0,  Y,Z+1)] + x[index(0,  Y+1,Z)] );
+    x[index(X+1,0,  Z+1)] = third*( x[index(X,0,  Z+1)] + x[index(X+1,0,Z+1)] + x[index(X+1,0,  Z)] );
+    x[index(X+1,Y+1,0  )] = third*( x[index(X,Y+1,  0)] + x[index(X+1,Y,  0)] + x[index(X+1,Y+1,1)] );
+
+    x[index(X+1,Y+1,Z+1)] = third*( x[index(X,Y+1,Z+1)] + x[index(X+1,Y,Z+1)] + x[index(X+1,Y+1,Z)] );
+}
+
+void
+spark::Fluid
+::enforceConcentrationBoundary( int dim, float* x )
+{
+    const size_t X = m_Nx;
+    const size_t Y = m_Ny;
+    const size_t Z = m_Nz;
+    
+    // 6 walls
+    for( size_t k = 1; k <= Z; k++ )
+    {
+        for( size_t j = 1; j <= Y; j++ )
+        {
+            x[index(0,  j,k)] = 0;
+            x[index(X+1,j,k)] = 0;
+        }
+        for( size_t i = 1; i <= X; i++ )
+        {
+            x[index(i,0,  k)] = dim==2 ? -x[index(i,1,k)] : x[index(i,1,k)];
+            x[index(i,Y+1,k)] = 0;
+        }
+    }
+    for( size_t j = 1; j <= Y; j++ )
+    {
+        for( size_t i = 1; i <= X; i++ )
+        {
+            x[index(i,j,  0)] = 0;
+            x[index(i,j,Z+1)] = 0;
+        }
+    }
+
+    // 12 edges
+    for( size_t a = 1; a <= X; ++a )
+    {
+        // x varies
+        x[index(a,0,0)] = 0;
+        x[index(a,Y+1,0)] = 0;
+        x[index(a,0,Z+1)] = 0;
+        x[index(a,Y+1,Z+1)] = 0;
+    }
+    for( size_t a = 1; a <= Y; ++a )
+    {
+        // y varies
+        x[index(0,a,0)] = 0;
+        x[index(X+1,a,0)] = 0;
+        x[index(0,a,Z+1)] = 0;
+        x[index(X+1,a,Z+1)] = 0;
+    }
+    for( size_t a = 1; a <= Z; ++a )
+    {
+        // z varies
+        x[index(0,0,a)] = 0;
+        x[index(X+1,0,a)] = 0;
+        x[index(0,Y+1,a)] = 0;
+        x[index(X+1,Y+1,a)] = 0;
+    }
+    
+    // 8 corners
+    const float third = 1.0f/3.0f;
+    x[index(0,  0,  0  )] = third*( x[index(1,  0,  0)] + x[index(0,  1,  0)] + x[index(0,  0,  1)] );
+    
+    x[index(X+1,0,  0  )] = third*( x[index(X,  0,  0)] + x[index(X+1,1,  0)] + x[index(X+1,0,  1)] );
+    x[index(0,  Y+1,0  )] = third*( x[index(1,Y+1,  0)] + x[index(0  ,Y,  0)] + x[index(0,  Y+1,1)] );
+    x[index(0,  0,  Z+1)] = third*( x[index(1,  0,Z+1)] + x[index(0  ,1,Z+1)] + x[index(0,  0,  Z)] );
+    
+    x[index(0  ,Y+1,Z+1)] = third*( x[index(1,Y+1,Z+1)] + x[index(0,  Y,Z+1)] + x[index(0,  Y+1,Z)] );
+    x[index(X+1,0,  Z+1)] = third*( x[index(X,0,  Z+1)] + x[index(X+1,0,Z+1)] + x[index(X+1,0,  Z)] );
+    x[index(X+1,Y+1,0  )] = third*( x[index(X,Y+1,  0)] + x[index(X+1,Y,  0)] + x[index(X+1,Y+1,1)] );
+    
+    x[index(X+1,Y+1,Z+1)] = third*( x[index(X,Y+1,Z+1)] + x[index(X+1,Y,Z+1)] + x[index(X+1,Y+1,Z)] );
+}
+
+
+void 
+spark::Fluid
+::stepVelocity( float dt )
+{
+    computeVorticityConfinment();
+    // update vel{UVW} with sources, including external and internal forces
+    addVelocitySources(dt);
+    
+    swapVelocityField();
+    // now the "current" velocity is in _prev, compute the 
+    // new vel from diffusion and put it in velU,velV,velW
+    diffuse( 1, m_velU, m_velU_prev, m_visc, dt );
+    diffuse( 2, m_velV, m_velV_prev, m_visc, dt );
+    diffuse( 3, m_velW, m_velW_prev, m_visc, dt );
+    
+    // project updates the m_vel field to enforce divergence free property on m_velUVW
+    project();
+    
+    swapVelocityField(); 
+    // now the "current" velocity is in _prev, compute the 
+    // new vel and put it in velU,velV,velW
+    advect( 1, m_velU, m_velU_prev,   m_velU_prev, m_velV_prev, m_velW_prev, dt );
+    advect( 2, m_velV, m_velV_prev,   m_velU_prev, m_velV_prev, m_velW_prev, dt );
+    advect( 3, m_velW, m_velW_prev,   m_velU_prev, m_velV_prev, m_velW_prev, dt );
+    // m_vel holds the new velocity
+    
+    // project updates the m_vel field to enforce divergence free property on m_velUVW
+    project();
+}
+
+void
+spark::Fluid
+::stepDensity( float dt )
+{
+    addDensitySources(dt);
+    
+    swapAdvectedFields(); // now m_density is ready for writing; density data in m_density_prev
+    diffuse( 0, m_density, m_density_prev, m_diff, dt );
+    // diffused density is now in m_density
+    
+    swapAdvectedFields(); // now m_density is ready for writing
+    advect( 0, m_density, m_density_prev, m_velU, m_velV, m_velW, dt );
+    // now m_density has the advected density
+}
+
+void 
+spark::Fluid
+::update( double dt )
+{
+    const double startTime = getTime();
+    if( m_threadCount != m_threadPool->threadCount() )
+    {
+        m_threadPool.reset( new ThreadPool( m_threadCount ) );
+    }
+    if( m_isResetPending.exchange( false ) )
+    {
+        init();
+        m_pendingTime = 0;
+    }
+    const float frameTime = dt * 0.05;
+    m_pendingTime += frameTime;
+    m_substepCount = 0;
+    m_pressureSolveStats.clear();
+    acquireSources();
+    m_cfl = maxVelocity() * m_pendingTime / m_cellSize;
+    float cfl = m_cfl;
+    while( m_pendingTime > 0 )
+    {
+        // Split what remains into equal substeps under the target CFL,
+        // rather than full-size substeps followed by a sliver.
+        const float substeps = std::ceil( cfl / m_targetCFL );
+        const bool isLast = !( substeps > 1 );
+        const float stepTime = isLast ? m_pendingTime : m_pendingTime / substeps;
+
+        if( m_isBrickSkipping )
+        {
+            updateActiveBricks();
+        }
+        stepVelocity( stepTime );
+        stepDensity( stepTime );
+        ageSources( stepTime );
+        m_pendingTime = isLast ? 0 : m_pendingTime - stepTime;
+        ++m_substepCount;
+
+        if( m_substepCount >= m_maxSubsteps
+            || ( m_updateBudget > 0 && 1000*(getTime() - startTime) >= m_updateBudget ) )
+        {
+            break;
+        }
+        cfl = maxVelocity() * m_pendingTime / m_cellSize;
+    }
+    // Time left over is merged into the next update, but at most one
+    // update's worth; past that the fluid runs slower than real time.
+    m_pendingTime = std::min( m_pendingTime, frameTime );
+    publishDensitySnapshot();
+    if( m_recorder )
+    {
+        m_recorder->capture( *this );
+    }
+    m_updateMilliseconds = float( 1000*(getTime() - startTime) );
+}
+
+float
+spark::Fluid
+::maxVelocity( void ) const
+{
+    // One maximum per z-slice, so slabs can be scanned concurrently.
+    std::vector< float > sliceMax( m_Nz+2, 0.0f );
+    m_threadPool->parallelFor( 1, m_Nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        forEachActiveRow( kBegin, kEnd, [&]( size_t iBegin, size_t j, size_t k, size_t count )
+        {
+            const size_t rowBegin = index( iBegin, j, k );
+            float m = sliceMax[k];
+            for( size_t ind = rowBegin; ind < rowBegin + count; ind++ )
+            {
+                m = std::max( m, std::max( std::fabs( m_velU[ind] ),
+                                 std::max( std::fabs( m_velV[ind] ), std::fabs( m_velW[ind] ) ) ) );
+            }
+            sliceMax[k] = m;
+        } );
+    } );
+    return *std::max_element( sliceMax.begin(), sliceMax.end() );
+}
+
+void
+spark::Fluid
+::publishDensitySnapshot( void )
+{
+    std::vector< float >& snapshot = m_densitySnapshots.getBack();
+    std::copy( m_density, m_density + m_size, snapshot.begin() );
+    m_densitySnapshots.publish();
+    if( m_isHalfFloatSnapshots )
+    {
+        std::vector< unsigned short >& halfSnapshot = m_halfDensitySnapshots.getBack();
+        m_kernels->floatToHalf( &halfSnapshot[0], m_density, m_size );
+        m_halfDensitySnapshots.publish();
+    }
+}
+
+void
+spark::Fluid
+::setHalfFloatSnapshots( bool isHalfFloatSnapshots )
+{
+    m_isHalfFloatSnapshots = isHalfFloatSnapshots;
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        std::vector< unsigned short >& buffer = m_halfDensitySnapshots.getBuffer( i );
+        if( m_isHalfFloatSnapshots )
+        {
+            buffer.assign( m_size, 0 );
+        }
+        else
+        {
+            std::vector< unsigned short >().swap( buffer );
+        }
+    }
+    if( m_isHalfFloatSnapshots )
+    {
+        publishDensitySnapshot();
+    }
+}
+
+const unsigned short* const
+spark::Fluid
+::getHalfDensitySnapshot( void )
+{
+    if( !m_isHalfFloatSnapshots )
+    {
+        return NULL;
+    }
+    m_halfDensitySnapshots.acquire();
+    return &m_halfDensitySnapshots.getFront()[0];
+}
+
+const float* const
+spark::Fluid
+::getDensitySnapshot( void )
+{
+    m_densitySnapshots.acquire();
+    return &m_densitySnapshots.getFront()[0];
+}
+
+Eigen::Vector3f
+spark::Fluid
+::velocityAtPosition( const Eigen::Vector3f& pos )
+{
+    Eigen::Vector3f velocity;
+    velocityAtPositions( pos.data(), 1, velocity.data() );
+    return velocity;
+}
+
+void
+spark::Fluid
+::velocityAtPositions( const float* xyz, size_t n, float* outVelocity )
+{
+    // grid coordinates of the origin, the center of the interior
+    m_kernels->sampleVelocity( outVelocity, xyz, n,
+                               m_velU, m_velV, m_velW,
+                               index(0,1,0) - index(0,0,0), index(0,0,1) - index(0,0,0),
+                               1.0f / m_cellSize,
+                               0.5f*(m_Nx+1), 0.5f*(m_Ny+1), 0.5f*(m_Nz+1),
+                               m_Nx+0.5f, m_Ny+0.5f, m_Nz+0.5f );
+}
+
+void
+spark::Fluid
+::addSourceAtLocation( float x, float y, float deltaDensity, float maxDensity )
+{
+    //std::cerr << "Smoke source = " << x << ", " << y << "\n";
+    const float lenOfCellX = 1.0f / dimX();
+    const float lenOfCellY = 1.0f / dimY();
+    int rx = (int)( (x/lenOfCellX) + ( (float)dimX()/2.0f ) );//+ 0.5f ) );
+    int ry = (int)( (y/lenOfCellY) + ( (float)dimY()/2.0f ) );//+ 0.5f ) );
+    
+    Source source;
+    source.density = deltaDensity/dimZ();
+    source.maxDensity = maxDensity;
+    addSourceAtCell( std::max( rx, 0 ), std::max( ry, 0 ), m_Nz, source );
+    //m_temp[ i ] = m_ambientTemp + 50.0;
+    //m_temp_prev[ i ] = m_ambientTemp + 50.0;
+
+
+
+    //m_density_prev[ i ] = 0.4;
+    //m_temp[ i ] = 150.0;
+    //m_temp_prev[ i ] = m_ambientTemp + 50.0;
+
+    //m_density[ index( rx, ry, 2) ] = 1;
+    //m_density_prev[ index( rx, ry, 2 ) ] = 1;
+    //m_density[ index( rx, ry, 3) ] = 1;
+    //m_density_prev[ index( rx, ry, 3 ) ] = 1;
+
+
+    //m_density[ index( 1, 1, 1) ] = 1;
+    //m_density_prev[ index( 1, 1, 1 ) ] = 1;
+
+    //m_density[ index( 1, m_Ny, 1) ] = 1;
+    //m_density_prev[ index( 1, m_Ny, 1 ) ] = 1;
+
+    //m_density[ index( m_Nx, 1, 1) ] = 1;
+    //m_density_prev[ index( m_Nx, 1, 1 ) ] = 1;
+
+    //m_density[ index(x+1,y+1,1) ] = 0.5f;
+    //m_density[ index(x+1,y-1,1) ] = 0.5f;
+    //m_density[ index(x-1,y+1,1) ] = 0.5f;
+    //m_density[ index(x-1,y-1,1) ] = 0.5f;
+
+    //m_density[ index(x,y,2) ] = 0.5f;
+    //m_density[ index(x+1,y+1,2) ] = 0.5f;
+    //m_density[ index(x+1,y-1,2) ] = 0.5f;
+    //m_density[ index(x-1,y+1,2) ] = 0.5f;
+    //m_density[ index(x-1,y-1,2) ] = 0.5f;
+
+    //m_temp[ index(x,y,1) ] = m_ambientTemp + 50.0f;
+}
+
+void
+spark::Fluid
+::addSource( const Source& source )
+{
+    boost::lock_guard<boost::mutex> lock( m_sourceMutex );
+    m_queuedSources.push_back( source );
+}
+
+void
+spark::Fluid
+::addSourceAtCell( size_t i, size_t j, size_t k, Source source )
+{
+    i = std::min( std::max( i, (size_t)1 ), m_Nx );
+    j = std::min( std::max( j, (size_t)1 ), m_Ny );
+    k = std::min( std::max( k, (size_t)1 ), m_Nz );
+    source.position[0] = m_cellSize * ( i - 0.5f*(m_Nx+1) );
+    source.position[1] = m_cellSize * ( j - 0.5f*(m_Ny+1) );
+    source.position[2] = m_cellSize * ( k - 0.5f*(m_Nz+1) );
+    addSource( source );
+}
+
+void
+spark::Fluid
+::clearSources( void )
+{
+    boost::lock_guard<boost::mutex> lock( m_sourceMutex );
+    m_queuedSources.clear();
+    m_isClearingSources = true;
+}
+
+void
+spark::Fluid
+::acquireSources( void )
+{
+    {
+        boost::lock_guard<boost::mutex> lock( m_sourceMutex );
+        if( m_isClearingSources )
+        {
+            m_sources.clear();
+            m_isClearingSources = false;
+        }
+        // keeps both vectors' capacity, so adding rarely allocates
+        m_acquiredSources.swap( m_queuedSources );
+    }
+    for( size_t s = 0; s < m_acquiredSources.size(); ++s )
+    {
+        ActiveSource active;
+        active.source = m_acquiredSources[s];
+        rasterizeSource( active );
+        if( active.source.lifetime > 0 )
+        {
+            active.remaining = active.source.lifetime;
+            m_sources.push_back( active );
+            continue;
+        }
+        // Impulses are added whole, before this update's first step
+        const Source& impulse = active.source;
+        const float scale = 1.0f / active.cells.size();
+        for( size_t c = 0; c < active.cells.size(); ++c )
+        {
+            const size_t ind = active.cells[c];
+            if( impulse.density != 0 )
+            {
+                m_density[ind] = std::min( m_density[ind] + scale * impulse.density, impulse.maxDensity );
+            }
+            m_temp[ind] += scale * impulse.temperature;
+            m_velU[ind] += scale * impulse.velocity[0];
+            m_velV[ind] += scale * impulse.velocity[1];
+            m_velW[ind] += scale * impulse.velocity[2];
+        }
+    }
+    m_acquiredSources.clear();
+}
+
+void
+spark::Fluid
+::rasterizeSource( ActiveSource& active ) const
+{
+    const Source& source = active.source;
+    const size_t N[3] = { m_Nx, m_Ny, m_Nz };
+    const float r = source.radius / m_cellSize;
+    float center[3];
+    size_t nearest[3]; //< the interior cell nearest to the center
+    for( int a = 0; a < 3; ++a )
+    {
+        // grid coordinates, cell i is centered on i
+        center[a] = source.position[a] / m_cellSize + 0.5f*(N[a]+1);
+        nearest[a] = (size_t)std::min( std::max( std::floor( center[a] + 0.5f ), 1.0f ), (float)N[a] );
+        active.lo[a] = std::min( nearest[a], (size_t)std::min( std::max( std::ceil( center[a] - r ), 1.0f ), (float)N[a] ) );
+        active.hi[a] = std::max( nearest[a], (size_t)std::max( std::min( std::floor( center[a] + r ), (float)N[a] ), 1.0f ) );
+    }
+    active.cells.clear();
+    for( size_t k = active.lo[2]; k <= active.hi[2]; ++k )
+    {
+        for( size_t j = active.lo[1]; j <= active.hi[1]; ++j )
+        {
+            for( size_t i = active.lo[0]; i <= active.hi[0]; ++i )
+            {
+                const float dx = i - center[0], dy = j - center[1], dz = k - center[2];
+                if( dx*dx + dy*dy + dz*dz <= r*r )
+                {
+                    active.cells.push_back( index( i, j, k ) );
+                }
+            }
+        }
+    }
+    if( active.cells.empty() )
+    {
+        // smaller than a cell, or outside the grid
+        for( int a = 0; a < 3; ++a )
+        {
+            active.lo[a] = active.hi[a] = nearest[a];
+        }
+        active.cells.push_back( index( nearest[0], nearest[1], nearest[2] ) );
+    }
+}
+
+void
+spark::Fluid
+::ageSources( float dt )
+{
+    size_t kept = 0;
+    for( size_t s = 0; s < m_sources.size(); ++s )
+    {
+        m_sources[s].remaining -= dt;
+        if( m_sources[s].remaining > 0 )
+        {
+            if( kept != s )
+            {
+                std::swap( m_sources[kept], m_sources[s] );
+            }
+            ++kept;
+        }
+    }
+    m_sources.resize( kept );
 }
\ No newline at end of file
@@ -0,0 +1,265 @@
+#include "FluidKernels.hpp"
+#include "Spark.hpp"
+
+#include <boost/cstdint.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Scalar kernels are the original Fluid inner loops, one row at a time.
+
+    void relaxRowScalar( float* x, const float* x_prev,
+                         size_t ind0, size_t n, size_t first,
+                         ptrdiff_t dy, ptrdiff_t dz,
+                         float a, float invC )
+    {
+        for( size_t o = first; o < n; o += 2 )
+        {
+            const size_t ind = ind0 + o;
+            x[ind] = invC * ( x_prev[ind]
+            + a*( x[ind-1]  //index(i-1, j, k)
+            + x[ind+1] // index(i+1, j,   k  )]
+            + x[ind-dy]//index(i,   j-1, k  )]
+            + x[ind+dy]//index(i,   j+1, k  )]
+            + x[ind-dz]// index(i,   j,   k-1)]
+            + x[ind+dz]//index(i,   j,   k+1)]
+            )
+                );
+        }
+    }
+
+    void advectRowScalar( float* d, const float* d_prev,
+                          const float* vx, const float* vy, const float* vz,
+                          size_t ind0, size_t n,
+                          float iFirst, float j, float k,
+                          ptrdiff_t dy, ptrdiff_t dz,
+                          float dt0,
+                          float maxX, float maxY, float maxZ )
+    {
+        float x, y, z;  // back-traced position
+        int i0, i1, j0, j1, k0, k1;  // index of grid points around the back-traced position xyz
+        float s0, s1, t0, t1, u0, u1; // distance between grid points and xyz
+        for( size_t o = 0; o < n; ++o )
+        {
+            const size_t ind = ind0 + o;
+            // back-project the velocities to find x,y,z that landed here at i,j,k
+            x = (iFirst + o) - dt0 * vx[ind];
+            y = j - dt0 * vy[ind];
+            z = k - dt0 * vz[ind];
+
+            // bound x,y,z to the grid  (so pulling from the outside of the grid gives
+            // you the clamped edge)
+            x = std::max( 0.5f, x ); x = std::min( maxX, x );
+            y = std::max( 0.5f, y ); y = std::min( maxY, y );
+            z = std::max( 0.5f, z ); z = std::min( maxZ, z );
+            // note that the truncated xyz coord becomes i0,j0,z0
+            i0 = (int)x; i1 = i0+1;
+            j0 = (int)y; j1 = j0+1;
+            k0 = (int)z; k1 = k0+1;
+
+            // the distance of the xyz point from the ijk vertex
+            s1 = x - i0;  s0 = 1.0f - s1;
+            t1 = y - j0;  t0 = 1.0f - t1;
+            u1 = z - k0;  u0 = 1.0f - u1;
+
+            const float* p00 = d_prev + j0*dy + k0*dz;
+            const float* p01 = d_prev + j0*dy + k1*dz;
+            const float* p10 = d_prev + j1*dy + k0*dz;
+            const float* p11 = d_prev + j1*dy + k1*dz;
+            d[ind]
+            =  s0*(
+                  t0*(u0*p00[i0] + u1*p01[i0])
+                +(t1*(u0*p10[i0] + u1*p11[i0]))
+              )
+             + s1*(
+                  t0*(u0*p00[i1] + u1*p01[i1])
+                +(t1*(u0*p10[i1] + u1*p11[i1]))
+              );
+        }
+    }
+
+    void vorticityRowScalar( float* wx, float* wy, float* wz, float* mag,
+                             const float* u, const float* v, const float* w,
+                             size_t ind0, size_t n,
+                             ptrdiff_t dy, ptrdiff_t dz,
+                             float h )
+    {
+        for( size_t ind = ind0; ind < ind0 + n; ++ind )
+        {
+            const float x = h * ( w[ind+dy] - v[ind+dz] );
+            const float y = h * ( u[ind+dz] - w[ind+1] );
+            const float z = h * ( v[ind+1]  - u[ind+dy] );
+            wx[ind] = x;
+            wy[ind] = y;
+            wz[ind] = z;
+            mag[ind] = std::sqrt( x*x + y*y + z*z );
+        }
+    }
+
+    void confinementRowScalar( float* fx, float* fy, float* fz,
+                               const float* magBelow, const float* mag, const float* magAbove,
+                               const float* wx, const float* wy, const float* wz,
+                               size_t ind0, size_t n,
+                               ptrdiff_t dy,
+                               float h, float f )
+    {
+        const float epsilon = 1e-10f;
+        for( size_t ind = ind0; ind < ind0 + n; ++ind )
+        {
+            // gradient of the vorticity magnitude
+            float nU = h * ( mag[ind+1]  - mag[ind-1] );
+            float nV = h * ( mag[ind+dy] - mag[ind-dy] );
+            float nW = h * ( magAbove[ind] - magBelow[ind] );
+
+            // normalized
+            float len = std::sqrt( nU*nU + nV*nV + nW*nW );
+            float invlen = 0;
+            if( len > epsilon )
+            {
+                invlen = 1.0f / len;
+            }
+            nU *= invlen;
+            nV *= invlen;
+            nW *= invlen;
+
+            // crossed with the vorticity
+            fx[ind] = f * ( nV * wz[ind] - nW * wy[ind] );
+            fy[ind] = f * ( nW * wx[ind] - nU * wz[ind] );
+            fz[ind] = f * ( nU * wy[ind] - nV * wx[ind] );
+        }
+    }
+
+    void sampleVelocityScalar( float* out, const float* xyz, size_t n,
+                               const float* vx, const float* vy, const float* vz,
+                               ptrdiff_t dy, ptrdiff_t dz,
+                               float scale,
+                               float offsetX, float offsetY, float offsetZ,
+                               float maxX, float maxY, float maxZ )
+    {
+        for( size_t p = 0; p < n; ++p )
+        {
+            const float x = std::min( maxX, std::max( 0.5f, xyz[3*p]   * scale + offsetX ) );
+            const float y = std::min( maxY, std::max( 0.5f, xyz[3*p+1] * scale + offsetY ) );
+            const float z = std::min( maxZ, std::max( 0.5f, xyz[3*p+2] * scale + offsetZ ) );
+            const int i0 = (int)x;
+            const int j0 = (int)y;
+            const int k0 = (int)z;
+            const float s1 = x - i0;  const float s0 = 1.0f - s1;
+            const float t1 = y - j0;  const float t0 = 1.0f - t1;
+            const float u1 = z - k0;  const float u0 = 1.0f - u1;
+
+            // the same weights for all three components
+            const size_t ind = i0 + j0*dy + k0*dz;
+            const float* const fields[] = { vx, vy, vz };
+            for( int a = 0; a < 3; ++a )
+            {
+                const float* f = fields[a] + ind;
+                out[3*p+a] 
+                =  s0*(
+                      t0*(u0*f[0]  + u1*f[dz])
+                    + t1*(u0*f[dy] + u1*f[dy+dz])
+                  )
+                 + s1*(
+                      t0*(u0*f[1]    + u1*f[1+dz])
+                    + t1*(u0*f[1+dy] + u1*f[1+dy+dz])
+                  );
+            }
+        }
+    }
+
+    unsigned short floatToHalfScalar( float value )
+    {
+        boost::uint32_t f;
+        std::memcpy( &f, &value, sizeof( f ) );
+        const unsigned short sign = (unsigned short)( ( f >> 16 ) & 0x8000 );
+        f &= 0x7fffffff;
+        if( f >= 0x7f800000 )
+        {
+            // infinity stays infinity, NaN stays a (quiet) NaN
+            return sign | 0x7c00 | ( f > 0x7f800000 ? 0x200 : 0 );
+        }
+        if( f >= 0x477ff000 )
+        {
+            // at least 65520, which rounds past the largest half
+            return sign | 0x7c00;
+        }
+        if( f < 0x38800000 )
+        {
+            // below the smallest normal half, 2^-14
+            if( f < 0x33000000 )
+            {
+                return sign;
+            }
+            const boost::uint32_t shift = 126 - ( f >> 23 );
+            const boost::uint32_t mantissa = ( f & 0x7fffff ) | 0x800000;
+            boost::uint32_t half = mantissa >> shift;
+            const boost::uint32_t rest = mantissa & ( ( 1u << shift ) - 1 );
+            const boost::uint32_t halfway = 1u << ( shift - 1 );
+            if( rest > halfway || ( rest == halfway && ( half & 1 ) ) )
+            {
+                ++half;
+            }
+            return sign | (unsigned short)half;
+        }
+        // rebias the exponent from 127 to 15; a carry out of the
+        // mantissa while rounding correctly bumps the exponent
+        boost::uint32_t half = ( f - 0x38000000 ) >> 13;
+        const boost::uint32_t rest = f & 0x1fff;
+        if( rest > 0x1000 || ( rest == 0x1000 && ( half & 1 ) ) )
+        {
+            ++half;
+        }
+        return sign | (unsigned short)half;
+    }
+
+    void floatToHalfScalar( unsigned short* out, const float* in, size_t n )
+    {
+        for( size_t i = 0; i < n; ++i )
+        {
+            out[i] = floatToHalfScalar( in[i] );
+        }
+    }
+
+    const spark::FluidKernels* selectFluidKernels( void )
+    {
+        const spark::FluidKernels* kernels = spark::avx2FluidKernels();
+        if( !kernels )
+        {
+            kernels = spark::sseFluidKernels();
+        }
+        if( !kernels )
+        {
+            kernels = &spark::scalarFluidKernels();
+        }
+        LOG_INFO(g_log) << "Fluid kernels using " << kernels->name;
+        return kernels;
+    }
+} // end anonymous namespace
+
+const spark::FluidKernels&
+spark
+::scalarFluidKernels( void )
+{
+    static const FluidKernels kernels =
+    {
+        "scalar",
+        relaxRowScalar,
+        advectRowScalar,
+        vorticityRowScalar,
+        confinementRowScalar,
+        sampleVelocityScalar,
+        floatToHalfScalar
+    };
+    return kernels;
+}
+
+const spark::FluidKernels&
+spark
+::fluidKernels( void )
+{
+    static const FluidKernels* best = selectFluidKernels();
+    return *best;
+}
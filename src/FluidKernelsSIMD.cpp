@@ -0,0 +1,661 @@
+// SSE2 and AVX2 implementations of FluidKernels.
+// See SIMDTarget.hpp for how the instruction sets are targeted.
+
+#include "FluidKernels.hpp"
+#include "SIMDTarget.hpp"
+
+#ifdef SPARK_SIMD_X86
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    /// Cells relaxed per batch before writing back, see relaxRowSSE
+    const size_t relaxChunk = 64;
+
+    ////////////////////////////////////////////////////////////////////////
+    // SSE2
+
+    SPARK_TARGET_SSE2
+    void relaxRowSSE( float* x, const float* x_prev,
+                      size_t ind0, size_t n, size_t first,
+                      ptrdiff_t dy, ptrdiff_t dz,
+                      float a, float invC )
+    {
+        const __m128 va = _mm_set1_ps( a );
+        const __m128 vinvC = _mm_set1_ps( invC );
+        // lanes of the color being relaxed; all others keep their value
+        const __m128 mask = first ? _mm_castsi128_ps( _mm_setr_epi32( 0, -1, 0, -1 ) )
+                                  : _mm_castsi128_ps( _mm_setr_epi32( -1, 0, -1, 0 ) );
+        // Results are staged in r and written back per chunk: storing each
+        // vector right away would make the next vector's x[ind-1] load
+        // straddle that store and defeat store-to-load forwarding.
+        __m128 r[relaxChunk/4];
+        size_t o = 0;
+        while( o + 4 <= n )
+        {
+            const size_t chunkBegin = o;
+            size_t v = 0;
+            for( ; v < relaxChunk/4 && o + 4 <= n; ++v, o += 4 )
+            {
+                const float* p = x + ind0 + o;
+                __m128 sum = _mm_add_ps( _mm_loadu_ps( p - 1 ), _mm_loadu_ps( p + 1 ) );
+                sum = _mm_add_ps( sum, _mm_loadu_ps( p - dy ) );
+                sum = _mm_add_ps( sum, _mm_loadu_ps( p + dy ) );
+                sum = _mm_add_ps( sum, _mm_loadu_ps( p - dz ) );
+                sum = _mm_add_ps( sum, _mm_loadu_ps( p + dz ) );
+                r[v] = _mm_mul_ps( vinvC,
+                    _mm_add_ps( _mm_loadu_ps( x_prev + ind0 + o ), _mm_mul_ps( va, sum ) ) );
+            }
+            for( size_t u = 0; u < v; ++u )
+            {
+                float* p = x + ind0 + chunkBegin + 4*u;
+                const __m128 old = _mm_loadu_ps( p );
+                _mm_storeu_ps( p, _mm_or_ps( _mm_and_ps( mask, r[u] ), _mm_andnot_ps( mask, old ) ) );
+            }
+        }
+        for( o += first; o < n; o += 2 )
+        {
+            const size_t ind = ind0 + o;
+            x[ind] = invC * ( x_prev[ind] + a*( x[ind-1] + x[ind+1]
+                                              + x[ind-dy] + x[ind+dy]
+                                              + x[ind-dz] + x[ind+dz] ) );
+        }
+    }
+
+    SPARK_TARGET_SSE2
+    void advectRowSSE( float* d, const float* d_prev,
+                       const float* vx, const float* vy, const float* vz,
+                       size_t ind0, size_t n,
+                       float iFirst, float j, float k,
+                       ptrdiff_t dy, ptrdiff_t dz,
+                       float dt0,
+                       float maxX, float maxY, float maxZ )
+    {
+        const __m128 vdt0 = _mm_set1_ps( dt0 );
+        const __m128 half = _mm_set1_ps( 0.5f );
+        const __m128 one = _mm_set1_ps( 1.0f );
+        const __m128 vmaxX = _mm_set1_ps( maxX );
+        const __m128 vmaxY = _mm_set1_ps( maxY );
+        const __m128 vmaxZ = _mm_set1_ps( maxZ );
+        const __m128 vj = _mm_set1_ps( j );
+        const __m128 vk = _mm_set1_ps( k );
+        __m128 vi = _mm_setr_ps( iFirst, iFirst + 1, iFirst + 2, iFirst + 3 );
+        const __m128 four = _mm_set1_ps( 4.0f );
+
+        size_t o = 0;
+        for( ; o + 4 <= n; o += 4 )
+        {
+            const size_t ind = ind0 + o;
+            __m128 x = _mm_sub_ps( vi, _mm_mul_ps( vdt0, _mm_loadu_ps( vx + ind ) ) );
+            __m128 y = _mm_sub_ps( vj, _mm_mul_ps( vdt0, _mm_loadu_ps( vy + ind ) ) );
+            __m128 z = _mm_sub_ps( vk, _mm_mul_ps( vdt0, _mm_loadu_ps( vz + ind ) ) );
+            vi = _mm_add_ps( vi, four );
+            x = _mm_min_ps( vmaxX, _mm_max_ps( half, x ) );
+            y = _mm_min_ps( vmaxY, _mm_max_ps( half, y ) );
+            z = _mm_min_ps( vmaxZ, _mm_max_ps( half, z ) );
+            // positions are >= 0.5, so truncation is floor
+            const __m128i xi = _mm_cvttps_epi32( x );
+            const __m128i yi = _mm_cvttps_epi32( y );
+            const __m128i zi = _mm_cvttps_epi32( z );
+            const __m128 s1 = _mm_sub_ps( x, _mm_cvtepi32_ps( xi ) );
+            const __m128 t1 = _mm_sub_ps( y, _mm_cvtepi32_ps( yi ) );
+            const __m128 u1 = _mm_sub_ps( z, _mm_cvtepi32_ps( zi ) );
+            const __m128 s0 = _mm_sub_ps( one, s1 );
+            const __m128 t0 = _mm_sub_ps( one, t1 );
+            const __m128 u0 = _mm_sub_ps( one, u1 );
+
+            // SSE2 has neither 32-bit multiply nor gather, so fetch the
+            // eight corners of each lane with scalar loads.
+            int ii[4], jj[4], kk[4];
+            _mm_storeu_si128( (__m128i*)ii, xi );
+            _mm_storeu_si128( (__m128i*)jj, yi );
+            _mm_storeu_si128( (__m128i*)kk, zi );
+            float c000[4], c001[4], c010[4], c011[4], c100[4], c101[4], c110[4], c111[4];
+            for( int l = 0; l < 4; ++l )
+            {
+                const float* p = d_prev + ii[l] + jj[l]*dy + kk[l]*dz;
+                c000[l] = p[0];      c001[l] = p[dz];
+                c010[l] = p[dy];     c011[l] = p[dy+dz];
+                c100[l] = p[1];      c101[l] = p[1+dz];
+                c110[l] = p[1+dy];   c111[l] = p[1+dy+dz];
+            }
+            const __m128 lo = _mm_mul_ps( s0, _mm_add_ps(
+                _mm_mul_ps( t0, _mm_add_ps( _mm_mul_ps( u0, _mm_loadu_ps( c000 ) ),
+                                            _mm_mul_ps( u1, _mm_loadu_ps( c001 ) ) ) ),
+                _mm_mul_ps( t1, _mm_add_ps( _mm_mul_ps( u0, _mm_loadu_ps( c010 ) ),
+                                            _mm_mul_ps( u1, _mm_loadu_ps( c011 ) ) ) ) ) );
+            const __m128 hi = _mm_mul_ps( s1, _mm_add_ps(
+                _mm_mul_ps( t0, _mm_add_ps( _mm_mul_ps( u0, _mm_loadu_ps( c100 ) ),
+                                            _mm_mul_ps( u1, _mm_loadu_ps( c101 ) ) ) ),
+                _mm_mul_ps( t1, _mm_add_ps( _mm_mul_ps( u0, _mm_loadu_ps( c110 ) ),
+                                            _mm_mul_ps( u1, _mm_loadu_ps( c111 ) ) ) ) ) );
+            _mm_storeu_ps( d + ind, _mm_add_ps( lo, hi ) );
+        }
+        if( o < n )
+        {
+            spark::scalarFluidKernels().advectRow( d, d_prev, vx, vy, vz,
+                                                   ind0 + o, n - o,
+                                                   iFirst + o, j, k,
+                                                   dy, dz, dt0,
+                                                   maxX, maxY, maxZ );
+        }
+    }
+
+    SPARK_TARGET_SSE2
+    void vorticityRowSSE( float* wx, float* wy, float* wz, float* mag,
+                          const float* u, const float* v, const float* w,
+                          size_t ind0, size_t n,
+                          ptrdiff_t dy, ptrdiff_t dz,
+                          float h )
+    {
+        const __m128 vh = _mm_set1_ps( h );
+        size_t ind = ind0;
+        for( ; ind + 4 <= ind0 + n; ind += 4 )
+        {
+            const __m128 x = _mm_mul_ps( vh, _mm_sub_ps( _mm_loadu_ps( w + ind + dy ), _mm_loadu_ps( v + ind + dz ) ) );
+            const __m128 y = _mm_mul_ps( vh, _mm_sub_ps( _mm_loadu_ps( u + ind + dz ), _mm_loadu_ps( w + ind + 1 ) ) );
+            const __m128 z = _mm_mul_ps( vh, _mm_sub_ps( _mm_loadu_ps( v + ind + 1 ),  _mm_loadu_ps( u + ind + dy ) ) );
+            _mm_storeu_ps( wx + ind, x );
+            _mm_storeu_ps( wy + ind, y );
+            _mm_storeu_ps( wz + ind, z );
+            const __m128 sq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+                                          _mm_mul_ps( z, z ) );
+            _mm_storeu_ps( mag + ind, _mm_sqrt_ps( sq ) );
+        }
+        if( ind < ind0 + n )
+        {
+            spark::scalarFluidKernels().vorticityRow( wx, wy, wz, mag, u, v, w,
+                                                      ind, ind0 + n - ind, dy, dz, h );
+        }
+    }
+
+    SPARK_TARGET_SSE2
+    void confinementRowSSE( float* fx, float* fy, float* fz,
+                            const float* magBelow, const float* mag, const float* magAbove,
+                            const float* wx, const float* wy, const float* wz,
+                            size_t ind0, size_t n,
+                            ptrdiff_t dy,
+                            float h, float f )
+    {
+        const __m128 vh = _mm_set1_ps( h );
+        const __m128 vf = _mm_set1_ps( f );
+        const __m128 epsilon = _mm_set1_ps( 1e-10f );
+        const __m128 one = _mm_set1_ps( 1.0f );
+        size_t ind = ind0;
+        for( ; ind + 4 <= ind0 + n; ind += 4 )
+        {
+            const float* p = mag + ind;
+            __m128 nU = _mm_mul_ps( vh, _mm_sub_ps( _mm_loadu_ps( p + 1 ),  _mm_loadu_ps( p - 1 ) ) );
+            __m128 nV = _mm_mul_ps( vh, _mm_sub_ps( _mm_loadu_ps( p + dy ), _mm_loadu_ps( p - dy ) ) );
+            __m128 nW = _mm_mul_ps( vh, _mm_sub_ps( _mm_loadu_ps( magAbove + ind ), _mm_loadu_ps( magBelow + ind ) ) );
+            const __m128 len = _mm_sqrt_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( nU, nU ), _mm_mul_ps( nV, nV ) ),
+                                                        _mm_mul_ps( nW, nW ) ) );
+            // 1/0 lanes are masked out, leaving zero vectors
+            const __m128 invlen = _mm_and_ps( _mm_cmpgt_ps( len, epsilon ), _mm_div_ps( one, len ) );
+            nU = _mm_mul_ps( nU, invlen );
+            nV = _mm_mul_ps( nV, invlen );
+            nW = _mm_mul_ps( nW, invlen );
+            const __m128 wU = _mm_loadu_ps( wx + ind );
+            const __m128 wV = _mm_loadu_ps( wy + ind );
+            const __m128 wW = _mm_loadu_ps( wz + ind );
+            _mm_storeu_ps( fx + ind, _mm_mul_ps( vf, _mm_sub_ps( _mm_mul_ps( nV, wW ), _mm_mul_ps( nW, wV ) ) ) );
+            _mm_storeu_ps( fy + ind, _mm_mul_ps( vf, _mm_sub_ps( _mm_mul_ps( nW, wU ), _mm_mul_ps( nU, wW ) ) ) );
+            _mm_storeu_ps( fz + ind, _mm_mul_ps( vf, _mm_sub_ps( _mm_mul_ps( nU, wV ), _mm_mul_ps( nV, wU ) ) ) );
+        }
+        if( ind < ind0 + n )
+        {
+            spark::scalarFluidKernels().confinementRow( fx, fy, fz, magBelow, mag, magAbove,
+                                                        wx, wy, wz, ind, ind0 + n - ind, dy, h, f );
+        }
+    }
+
+    SPARK_TARGET_SSE2
+    void sampleVelocitySSE( float* out, const float* xyz, size_t n,
+                            const float* vx, const float* vy, const float* vz,
+                            ptrdiff_t dy, ptrdiff_t dz,
+                            float scale,
+                            float offsetX, float offsetY, float offsetZ,
+                            float maxX, float maxY, float maxZ )
+    {
+        const __m128 vscale = _mm_set1_ps( scale );
+        const __m128 half = _mm_set1_ps( 0.5f );
+        const __m128 one = _mm_set1_ps( 1.0f );
+        size_t p = 0;
+        for( ; p + 4 <= n; p += 4 )
+        {
+            const float* q = xyz + 3*p;
+            __m128 x = _mm_add_ps( _mm_mul_ps( vscale, _mm_setr_ps( q[0], q[3], q[6], q[9] ) ),  _mm_set1_ps( offsetX ) );
+            __m128 y = _mm_add_ps( _mm_mul_ps( vscale, _mm_setr_ps( q[1], q[4], q[7], q[10] ) ), _mm_set1_ps( offsetY ) );
+            __m128 z = _mm_add_ps( _mm_mul_ps( vscale, _mm_setr_ps( q[2], q[5], q[8], q[11] ) ), _mm_set1_ps( offsetZ ) );
+            x = _mm_min_ps( _mm_set1_ps( maxX ), _mm_max_ps( half, x ) );
+            y = _mm_min_ps( _mm_set1_ps( maxY ), _mm_max_ps( half, y ) );
+            z = _mm_min_ps( _mm_set1_ps( maxZ ), _mm_max_ps( half, z ) );
+            // positions are >= 0.5, so truncation is floor
+            const __m128i xi = _mm_cvttps_epi32( x );
+            const __m128i yi = _mm_cvttps_epi32( y );
+            const __m128i zi = _mm_cvttps_epi32( z );
+            const __m128 s1 = _mm_sub_ps( x, _mm_cvtepi32_ps( xi ) );
+            const __m128 t1 = _mm_sub_ps( y, _mm_cvtepi32_ps( yi ) );
+            const __m128 u1 = _mm_sub_ps( z, _mm_cvtepi32_ps( zi ) );
+            const __m128 s0 = _mm_sub_ps( one, s1 );
+            const __m128 t0 = _mm_sub_ps( one, t1 );
+            const __m128 u0 = _mm_sub_ps( one, u1 );
+
+            int ii[4], jj[4], kk[4];
+            _mm_storeu_si128( (__m128i*)ii, xi );
+            _mm_storeu_si128( (__m128i*)jj, yi );
+            _mm_storeu_si128( (__m128i*)kk, zi );
+            const float* const fields[] = { vx, vy, vz };
+            float result[3][4];
+            for( int a = 0; a < 3; ++a )
+            {
+                // scalar corner loads, as in advectRowSSE
+                float c000[4], c001[4], c010[4], c011[4], c100[4], c101[4], c110[4], c111[4];
+                for( int l = 0; l < 4; ++l )
+                {
+                    const float* f = fields[a] + ii[l] + jj[l]*dy + kk[l]*dz;
+                    c000[l] = f[0];      c001[l] = f[dz];
+                    c010[l] = f[dy];     c011[l] = f[dy+dz];
+                    c100[l] = f[1];      c101[l] = f[1+dz];
+                    c110[l] = f[1+dy];   c111[l] = f[1+dy+dz];
+                }
+                const __m128 lo = _mm_mul_ps( s0, _mm_add_ps(
+                    _mm_mul_ps( t0, _mm_add_ps( _mm_mul_ps( u0, _mm_loadu_ps( c000 ) ),
+                                                _mm_mul_ps( u1, _mm_loadu_ps( c001 ) ) ) ),
+                    _mm_mul_ps( t1, _mm_add_ps( _mm_mul_ps( u0, _mm_loadu_ps( c010 ) ),
+                                                _mm_mul_ps( u1, _mm_loadu_ps( c011 ) ) ) ) ) );
+                const __m128 hi = _mm_mul_ps( s1, _mm_add_ps(
+                    _mm_mul_ps( t0, _mm_add_ps( _mm_mul_ps( u0, _mm_loadu_ps( c100 ) ),
+                                                _mm_mul_ps( u1, _mm_loadu_ps( c101 ) ) ) ),
+                    _mm_mul_ps( t1, _mm_add_ps( _mm_mul_ps( u0, _mm_loadu_ps( c110 ) ),
+                                                _mm_mul_ps( u1, _mm_loadu_ps( c111 ) ) ) ) ) );
+                _mm_storeu_ps( result[a], _mm_add_ps( lo, hi ) );
+            }
+            for( int l = 0; l < 4; ++l )
+            {
+                out[3*(p+l)]   = result[0][l];
+                out[3*(p+l)+1] = result[1][l];
+                out[3*(p+l)+2] = result[2][l];
+            }
+        }
+        if( p < n )
+        {
+            spark::scalarFluidKernels().sampleVelocity( out + 3*p, xyz + 3*p, n - p,
+                                                        vx, vy, vz, dy, dz, scale,
+                                                        offsetX, offsetY, offsetZ,
+                                                        maxX, maxY, maxZ );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////
+    // AVX2 + FMA (+ F16C)
+
+    SPARK_TARGET_AVX2
+    void relaxRowAVX2( float* x, const float* x_prev,
+                       size_t ind0, size_t n, size_t first,
+                       ptrdiff_t dy, ptrdiff_t dz,
+                       float a, float invC )
+    {
+        const __m256 va = _mm256_set1_ps( a );
+        const __m256 vinvC = _mm256_set1_ps( invC );
+        const __m256 mask = first ? _mm256_castsi256_ps( _mm256_setr_epi32( 0, -1, 0, -1, 0, -1, 0, -1 ) )
+                                  : _mm256_castsi256_ps( _mm256_setr_epi32( -1, 0, -1, 0, -1, 0, -1, 0 ) );
+        // staged per chunk, see relaxRowSSE
+        __m256 r[relaxChunk/8];
+        size_t o = 0;
+        while( o + 8 <= n )
+        {
+            const size_t chunkBegin = o;
+            size_t v = 0;
+            for( ; v < relaxChunk/8 && o + 8 <= n; ++v, o += 8 )
+            {
+                const float* p = x + ind0 + o;
+                __m256 sum = _mm256_add_ps( _mm256_loadu_ps( p - 1 ), _mm256_loadu_ps( p + 1 ) );
+                sum = _mm256_add_ps( sum, _mm256_loadu_ps( p - dy ) );
+                sum = _mm256_add_ps( sum, _mm256_loadu_ps( p + dy ) );
+                sum = _mm256_add_ps( sum, _mm256_loadu_ps( p - dz ) );
+                sum = _mm256_add_ps( sum, _mm256_loadu_ps( p + dz ) );
+                r[v] = _mm256_mul_ps( vinvC,
+                    _mm256_fmadd_ps( va, sum, _mm256_loadu_ps( x_prev + ind0 + o ) ) );
+            }
+            for( size_t u = 0; u < v; ++u )
+            {
+                float* p = x + ind0 + chunkBegin + 8*u;
+                _mm256_storeu_ps( p, _mm256_blendv_ps( _mm256_loadu_ps( p ), r[u], mask ) );
+            }
+        }
+        if( o < n )
+        {
+            relaxRowSSE( x, x_prev, ind0 + o, n - o, first, dy, dz, a, invC );
+        }
+    }
+
+    SPARK_TARGET_AVX2
+    void advectRowAVX2( float* d, const float* d_prev,
+                        const float* vx, const float* vy, const float* vz,
+                        size_t ind0, size_t n,
+                        float iFirst, float j, float k,
+                        ptrdiff_t dy, ptrdiff_t dz,
+                        float dt0,
+                        float maxX, float maxY, float maxZ )
+    {
+        const __m256 vdt0 = _mm256_set1_ps( dt0 );
+        const __m256 half = _mm256_set1_ps( 0.5f );
+        const __m256 one = _mm256_set1_ps( 1.0f );
+        const __m256 vmaxX = _mm256_set1_ps( maxX );
+        const __m256 vmaxY = _mm256_set1_ps( maxY );
+        const __m256 vmaxZ = _mm256_set1_ps( maxZ );
+        const __m256 vj = _mm256_set1_ps( j );
+        const __m256 vk = _mm256_set1_ps( k );
+        const __m256 eight = _mm256_set1_ps( 8.0f );
+        __m256 vi = _mm256_add_ps( _mm256_set1_ps( iFirst ),
+                                   _mm256_setr_ps( 0, 1, 2, 3, 4, 5, 6, 7 ) );
+        const __m256i vdy = _mm256_set1_epi32( (int)dy );
+        const __m256i vdz = _mm256_set1_epi32( (int)dz );
+        const __m256i vone = _mm256_set1_epi32( 1 );
+
+        size_t o = 0;
+        for( ; o + 8 <= n; o += 8 )
+        {
+            const size_t ind = ind0 + o;
+            __m256 x = _mm256_fnmadd_ps( vdt0, _mm256_loadu_ps( vx + ind ), vi );
+            __m256 y = _mm256_fnmadd_ps( vdt0, _mm256_loadu_ps( vy + ind ), vj );
+            __m256 z = _mm256_fnmadd_ps( vdt0, _mm256_loadu_ps( vz + ind ), vk );
+            vi = _mm256_add_ps( vi, eight );
+            x = _mm256_min_ps( vmaxX, _mm256_max_ps( half, x ) );
+            y = _mm256_min_ps( vmaxY, _mm256_max_ps( half, y ) );
+            z = _mm256_min_ps( vmaxZ, _mm256_max_ps( half, z ) );
+            // positions are >= 0.5, so truncation is floor
+            const __m256i xi = _mm256_cvttps_epi32( x );
+            const __m256i yi = _mm256_cvttps_epi32( y );
+            const __m256i zi = _mm256_cvttps_epi32( z );
+            const __m256 s1 = _mm256_sub_ps( x, _mm256_cvtepi32_ps( xi ) );
+            const __m256 t1 = _mm256_sub_ps( y, _mm256_cvtepi32_ps( yi ) );
+            const __m256 u1 = _mm256_sub_ps( z, _mm256_cvtepi32_ps( zi ) );
+            const __m256 s0 = _mm256_sub_ps( one, s1 );
+            const __m256 t0 = _mm256_sub_ps( one, t1 );
+            const __m256 u0 = _mm256_sub_ps( one, u1 );
+
+            const __m256i i000 = _mm256_add_epi32( xi,
+                _mm256_add_epi32( _mm256_mullo_epi32( yi, vdy ), _mm256_mullo_epi32( zi, vdz ) ) );
+            const __m256i i001 = _mm256_add_epi32( i000, vdz );
+            const __m256i i010 = _mm256_add_epi32( i000, vdy );
+            const __m256i i011 = _mm256_add_epi32( i010, vdz );
+            const __m256 c000 = _mm256_i32gather_ps( d_prev, i000, 4 );
+            const __m256 c001 = _mm256_i32gather_ps( d_prev, i001, 4 );
+            const __m256 c010 = _mm256_i32gather_ps( d_prev, i010, 4 );
+            const __m256 c011 = _mm256_i32gather_ps( d_prev, i011, 4 );
+            const __m256 c100 = _mm256_i32gather_ps( d_prev, _mm256_add_epi32( i000, vone ), 4 );
+            const __m256 c101 = _mm256_i32gather_ps( d_prev, _mm256_add_epi32( i001, vone ), 4 );
+            const __m256 c110 = _mm256_i32gather_ps( d_prev, _mm256_add_epi32( i010, vone ), 4 );
+            const __m256 c111 = _mm256_i32gather_ps( d_prev, _mm256_add_epi32( i011, vone ), 4 );
+
+            const __m256 lo = _mm256_mul_ps( s0, _mm256_fmadd_ps( t0,
+                _mm256_fmadd_ps( u0, c000, _mm256_mul_ps( u1, c001 ) ),
+                _mm256_mul_ps( t1, _mm256_fmadd_ps( u0, c010, _mm256_mul_ps( u1, c011 ) ) ) ) );
+            const __m256 r = _mm256_fmadd_ps( s1, _mm256_fmadd_ps( t0,
+                _mm256_fmadd_ps( u0, c100, _mm256_mul_ps( u1, c101 ) ),
+                _mm256_mul_ps( t1, _mm256_fmadd_ps( u0, c110, _mm256_mul_ps( u1, c111 ) ) ) ), lo );
+            _mm256_storeu_ps( d + ind, r );
+        }
+        if( o < n )
+        {
+            advectRowSSE( d, d_prev, vx, vy, vz, ind0 + o, n - o,
+                          iFirst + o, j, k, dy, dz, dt0, maxX, maxY, maxZ );
+        }
+    }
+
+    SPARK_TARGET_AVX2
+    void vorticityRowAVX2( float* wx, float* wy, float* wz, float* mag,
+                           const float* u, const float* v, const float* w,
+                           size_t ind0, size_t n,
+                           ptrdiff_t dy, ptrdiff_t dz,
+                           float h )
+    {
+        const __m256 vh = _mm256_set1_ps( h );
+        size_t ind = ind0;
+        for( ; ind + 8 <= ind0 + n; ind += 8 )
+        {
+            const __m256 x = _mm256_mul_ps( vh, _mm256_sub_ps( _mm256_loadu_ps( w + ind + dy ), _mm256_loadu_ps( v + ind + dz ) ) );
+            const __m256 y = _mm256_mul_ps( vh, _mm256_sub_ps( _mm256_loadu_ps( u + ind + dz ), _mm256_loadu_ps( w + ind + 1 ) ) );
+            const __m256 z = _mm256_mul_ps( vh, _mm256_sub_ps( _mm256_loadu_ps( v + ind + 1 ),  _mm256_loadu_ps( u + ind + dy ) ) );
+            _mm256_storeu_ps( wx + ind, x );
+            _mm256_storeu_ps( wy + ind, y );
+            _mm256_storeu_ps( wz + ind, z );
+            const __m256 sq = _mm256_fmadd_ps( z, z, _mm256_fmadd_ps( y, y, _mm256_mul_ps( x, x ) ) );
+            _mm256_storeu_ps( mag + ind, _mm256_sqrt_ps( sq ) );
+        }
+        if( ind < ind0 + n )
+        {
+            vorticityRowSSE( wx, wy, wz, mag, u, v, w, ind, ind0 + n - ind, dy, dz, h );
+        }
+    }
+
+    SPARK_TARGET_AVX2
+    void confinementRowAVX2( float* fx, float* fy, float* fz,
+                             const float* magBelow, const float* mag, const float* magAbove,
+                             const float* wx, const float* wy, const float* wz,
+                             size_t ind0, size_t n,
+                             ptrdiff_t dy,
+                             float h, float f )
+    {
+        const __m256 vh = _mm256_set1_ps( h );
+        const __m256 vf = _mm256_set1_ps( f );
+        const __m256 epsilon = _mm256_set1_ps( 1e-10f );
+        const __m256 one = _mm256_set1_ps( 1.0f );
+        size_t ind = ind0;
+        for( ; ind + 8 <= ind0 + n; ind += 8 )
+        {
+            const float* p = mag + ind;
+            __m256 nU = _mm256_mul_ps( vh, _mm256_sub_ps( _mm256_loadu_ps( p + 1 ),  _mm256_loadu_ps( p - 1 ) ) );
+            __m256 nV = _mm256_mul_ps( vh, _mm256_sub_ps( _mm256_loadu_ps( p + dy ), _mm256_loadu_ps( p - dy ) ) );
+            __m256 nW = _mm256_mul_ps( vh, _mm256_sub_ps( _mm256_loadu_ps( magAbove + ind ), _mm256_loadu_ps( magBelow + ind ) ) );
+            const __m256 len = _mm256_sqrt_ps(
+                _mm256_fmadd_ps( nW, nW, _mm256_fmadd_ps( nV, nV, _mm256_mul_ps( nU, nU ) ) ) );
+            const __m256 invlen = _mm256_and_ps( _mm256_cmp_ps( len, epsilon, _CMP_GT_OQ ),
+                                                 _mm256_div_ps( one, len ) );
+            nU = _mm256_mul_ps( nU, invlen );
+            nV = _mm256_mul_ps( nV, invlen );
+            nW = _mm256_mul_ps( nW, invlen );
+            const __m256 wU = _mm256_loadu_ps( wx + ind );
+            const __m256 wV = _mm256_loadu_ps( wy + ind );
+            const __m256 wW = _mm256_loadu_ps( wz + ind );
+            _mm256_storeu_ps( fx + ind, _mm256_mul_ps( vf, _mm256_fmsub_ps( nV, wW, _mm256_mul_ps( nW, wV ) ) ) );
+            _mm256_storeu_ps( fy + ind, _mm256_mul_ps( vf, _mm256_fmsub_ps( nW, wU, _mm256_mul_ps( nU, wW ) ) ) );
+            _mm256_storeu_ps( fz + ind, _mm256_mul_ps( vf, _mm256_fmsub_ps( nU, wV, _mm256_mul_ps( nV, wU ) ) ) );
+        }
+        if( ind < ind0 + n )
+        {
+            confinementRowSSE( fx, fy, fz, magBelow, mag, magAbove,
+                               wx, wy, wz, ind, ind0 + n - ind, dy, h, f );
+        }
+    }
+
+    SPARK_TARGET_AVX2
+    void sampleVelocityAVX2( float* out, const float* xyz, size_t n,
+                             const float* vx, const float* vy, const float* vz,
+                             ptrdiff_t dy, ptrdiff_t dz,
+                             float scale,
+                             float offsetX, float offsetY, float offsetZ,
+                             float maxX, float maxY, float maxZ )
+    {
+        const __m256 vscale = _mm256_set1_ps( scale );
+        const __m256 half = _mm256_set1_ps( 0.5f );
+        const __m256 one = _mm256_set1_ps( 1.0f );
+        const __m256i stride = _mm256_setr_epi32( 0, 3, 6, 9, 12, 15, 18, 21 );
+        const __m256i vdy = _mm256_set1_epi32( (int)dy );
+        const __m256i vdz = _mm256_set1_epi32( (int)dz );
+        const __m256i vone = _mm256_set1_epi32( 1 );
+        size_t p = 0;
+        for( ; p + 8 <= n; p += 8 )
+        {
+            // deinterleave x, y and z of eight points
+            const float* q = xyz + 3*p;
+            __m256 x = _mm256_fmadd_ps( vscale, _mm256_i32gather_ps( q,     stride, 4 ), _mm256_set1_ps( offsetX ) );
+            __m256 y = _mm256_fmadd_ps( vscale, _mm256_i32gather_ps( q + 1, stride, 4 ), _mm256_set1_ps( offsetY ) );
+            __m256 z = _mm256_fmadd_ps( vscale, _mm256_i32gather_ps( q + 2, stride, 4 ), _mm256_set1_ps( offsetZ ) );
+            x = _mm256_min_ps( _mm256_set1_ps( maxX ), _mm256_max_ps( half, x ) );
+            y = _mm256_min_ps( _mm256_set1_ps( maxY ), _mm256_max_ps( half, y ) );
+            z = _mm256_min_ps( _mm256_set1_ps( maxZ ), _mm256_max_ps( half, z ) );
+            // positions are >= 0.5, so truncation is floor
+            const __m256i xi = _mm256_cvttps_epi32( x );
+            const __m256i yi = _mm256_cvttps_epi32( y );
+            const __m256i zi = _mm256_cvttps_epi32( z );
+            const __m256 s1 = _mm256_sub_ps( x, _mm256_cvtepi32_ps( xi ) );
+            const __m256 t1 = _mm256_sub_ps( y, _mm256_cvtepi32_ps( yi ) );
+            const __m256 u1 = _mm256_sub_ps( z, _mm256_cvtepi32_ps( zi ) );
+            const __m256 s0 = _mm256_sub_ps( one, s1 );
+            const __m256 t0 = _mm256_sub_ps( one, t1 );
+            const __m256 u0 = _mm256_sub_ps( one, u1 );
+
+            // the same corners and weights for all three components
+            const __m256i i000 = _mm256_add_epi32( xi,
+                _mm256_add_epi32( _mm256_mullo_epi32( yi, vdy ), _mm256_mullo_epi32( zi, vdz ) ) );
+            const __m256i i001 = _mm256_add_epi32( i000, vdz );
+            const __m256i i010 = _mm256_add_epi32( i000, vdy );
+            const __m256i i011 = _mm256_add_epi32( i010, vdz );
+            const __m256i i100 = _mm256_add_epi32( i000, vone );
+            const __m256i i101 = _mm256_add_epi32( i001, vone );
+            const __m256i i110 = _mm256_add_epi32( i010, vone );
+            const __m256i i111 = _mm256_add_epi32( i011, vone );
+            const float* const fields[] = { vx, vy, vz };
+            float result[3][8];
+            for( int a = 0; a < 3; ++a )
+            {
+                const float* f = fields[a];
+                const __m256 lo = _mm256_mul_ps( s0, _mm256_fmadd_ps( t0,
+                    _mm256_fmadd_ps( u0, _mm256_i32gather_ps( f, i000, 4 ), _mm256_mul_ps( u1, _mm256_i32gather_ps( f, i001, 4 ) ) ),
+                    _mm256_mul_ps( t1, _mm256_fmadd_ps( u0, _mm256_i32gather_ps( f, i010, 4 ), _mm256_mul_ps( u1, _mm256_i32gather_ps( f, i011, 4 ) ) ) ) ) );
+                const __m256 r = _mm256_fmadd_ps( s1, _mm256_fmadd_ps( t0,
+                    _mm256_fmadd_ps( u0, _mm256_i32gather_ps( f, i100, 4 ), _mm256_mul_ps( u1, _mm256_i32gather_ps( f, i101, 4 ) ) ),
+                    _mm256_mul_ps( t1, _mm256_fmadd_ps( u0, _mm256_i32gather_ps( f, i110, 4 ), _mm256_mul_ps( u1, _mm256_i32gather_ps( f, i111, 4 ) ) ) ) ), lo );
+                _mm256_storeu_ps( result[a], r );
+            }
+            for( int l = 0; l < 8; ++l )
+            {
+                out[3*(p+l)]   = result[0][l];
+                out[3*(p+l)+1] = result[1][l];
+                out[3*(p+l)+2] = result[2][l];
+            }
+        }
+        if( p < n )
+        {
+            sampleVelocitySSE( out + 3*p, xyz + 3*p, n - p,
+                               vx, vy, vz, dy, dz, scale,
+                               offsetX, offsetY, offsetZ,
+                               maxX, maxY, maxZ );
+        }
+    }
+
+    SPARK_TARGET_AVX2
+    void floatToHalfAVX2( unsigned short* out, const float* in, size_t n )
+    {
+        size_t i = 0;
+        for( ; i + 8 <= n; i += 8 )
+        {
+            const __m128i half = _mm256_cvtps_ph( _mm256_loadu_ps( in + i ), _MM_FROUND_TO_NEAREST_INT );
+            _mm_storeu_si128( (__m128i*)( out + i ), half );
+        }
+        if( i < n )
+        {
+            spark::scalarFluidKernels().floatToHalf( out + i, in + i, n - i );
+        }
+    }
+} // end anonymous namespace
+
+bool
+spark
+::cpuSupportsAVX2( void )
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid( info, 0 );
+    if( info[0] < 7 )
+    {
+        return false;
+    }
+    __cpuid( info, 1 );
+    const bool hasFMA     = ( info[2] & ( 1 << 12 ) ) != 0;
+    const bool hasOSXSAVE = ( info[2] & ( 1 << 27 ) ) != 0;
+    const bool hasAVX     = ( info[2] & ( 1 << 28 ) ) != 0;
+    const bool hasF16C    = ( info[2] & ( 1 << 29 ) ) != 0;
+    if( !( hasFMA && hasOSXSAVE && hasAVX && hasF16C ) )
+    {
+        return false;
+    }
+    if( ( _xgetbv( 0 ) & 0x6 ) != 0x6 )
+    {
+        return false;
+    }
+    __cpuidex( info, 7, 0 );
+    return ( info[1] & ( 1 << 5 ) ) != 0;
+#elif defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" ) && __builtin_cpu_supports( "fma" )
+        && __builtin_cpu_supports( "f16c" );
+#else
+    return false;
+#endif
+}
+
+const spark::FluidKernels*
+spark
+::sseFluidKernels( void )
+{
+    static const FluidKernels kernels =
+    {
+        "SSE2",
+        relaxRowSSE,
+        advectRowSSE,
+        vorticityRowSSE,
+        confinementRowSSE,
+        sampleVelocitySSE,
+        scalarFluidKernels().floatToHalf // F16C came after AVX
+    };
+    return &kernels;
+}
+
+const spark::FluidKernels*
+spark
+::avx2FluidKernels( void )
+{
+    static const FluidKernels kernels =
+    {
+        "AVX2",
+        relaxRowAVX2,
+        advectRowAVX2,
+        vorticityRowAVX2,
+        confinementRowAVX2,
+        sampleVelocityAVX2,
+        floatToHalfAVX2
+    };
+    static const bool isSupported = cpuSupportsAVX2();
+    return isSupported ? &kernels : NULL;
+}
+
+#else // !SPARK_SIMD_X86
+
+const spark::FluidKernels*
+spark
+::sseFluidKernels( void )
+{
+    return NULL;
+}
+
+const spark::FluidKernels*
+spark
+::avx2FluidKernels( void )
+{
+    return NULL;
+}
+
+bool
+spark
+::cpuSupportsAVX2( void )
+{
+    return false;
+}
+
+#endif
@@ -0,0 +1,215 @@
+#include "FluidRecorder.hpp"
+#include "Fluid.hpp"
+#include "Exceptions.hpp"
+
+#include <boost/thread/locks.hpp>
+
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    /// Header of an NPY (version 1.0) array of the given dtype and shape,
+    /// padded to a multiple of 64 bytes as numpy writes them.
+    std::string npyHeader( const char* descr, const std::vector< size_t >& shape )
+    {
+        std::ostringstream dict;
+        dict << "{'descr': '" << descr << "', 'fortran_order': False, 'shape': (";
+        for( size_t i = 0; i < shape.size(); ++i )
+        {
+            dict << shape[i] << ", ";
+        }
+        dict << "), }";
+        std::string header = dict.str();
+        // magic, version and length take 10 bytes; the header ends in '\n'
+        const size_t unpadded = 10 + header.size() + 1;
+        header.append( ( 64 - unpadded % 64 ) % 64, ' ' );
+        header += '\n';
+        std::string npy( "\x93NUMPY\x01\x00", 8 );
+        npy += (char)( header.size() & 0xff );
+        npy += (char)( header.size() >> 8 );
+        return npy + header;
+    }
+}
+
+spark::FluidRecorder
+::FluidRecorder( const std::string& filename,
+                 const Fluid& fluid,
+                 int fields,
+                 unsigned int interval,
+                 const std::vector< size_t >& ySlices,
+                 size_t ringSize )
+: m_out( filename.c_str(), std::ios::binary | std::ios::trunc ),
+  m_fields( fields ),
+  m_interval( std::max( 1u, interval ) ),
+  m_ySlices( ySlices ),
+  m_dimX( fluid.dimX() ),
+  m_dimY( fluid.dimY() ),
+  m_dimZ( fluid.dimZ() ),
+  m_ring( std::max( (size_t)1, ringSize ) ),
+  m_head( 0 ),
+  m_tail( 0 ),
+  m_updateCount( 0 ),
+  m_frameCount( 0 ),
+  m_droppedFrameCount( 0 ),
+  m_writtenFrameCount( 0 ),
+  m_isStopping( false )
+{
+    if( !m_out )
+    {
+        throw SparkRunTimeException( "FluidRecorder failed to open " + filename );
+    }
+    size_t fieldCount = 0;
+    if( m_fields & DensityField ) fieldCount += 1;
+    if( m_fields & TemperatureField ) fieldCount += 1;
+    if( m_fields & VelocityField ) fieldCount += 3;
+    for( size_t s = 0; s < m_ySlices.size(); ++s )
+    {
+        m_ySlices[s] = std::min( m_ySlices[s], m_dimY - 1 );
+    }
+
+    std::vector< size_t > shape( 1, 2 );
+    m_indexHeader = npyHeader( "<i8", shape );
+    shape.assign( 1, fieldCount );
+    if( m_ySlices.empty() )
+    {
+        shape.push_back( m_dimZ );
+        shape.push_back( m_dimY );
+    }
+    else
+    {
+        shape.push_back( m_ySlices.size() );
+        shape.push_back( m_dimZ );
+    }
+    shape.push_back( m_dimX );
+    m_dataHeader = npyHeader( "<f4", shape );
+
+    // Allocated now, so capture() never allocates
+    const size_t frameSize = fieldCount * ( m_ySlices.empty() ? m_dimY : m_ySlices.size() )
+                             * m_dimZ * m_dimX;
+    for( size_t i = 0; i < m_ring.size(); ++i )
+    {
+        m_ring[i].data.assign( frameSize, 0.0f );
+    }
+    m_writer = boost::thread( &FluidRecorder::writerLoop, this );
+    LOG_INFO(g_log) << "FluidRecorder writing " << fieldCount << " fields every "
+                    << m_interval << " updates to " << filename;
+}
+
+spark::FluidRecorder
+::~FluidRecorder()
+{
+    {
+        boost::lock_guard<boost::mutex> lock( m_mutex );
+        m_isStopping = true;
+    }
+    m_frameReady.notify_one();
+    m_writer.join();
+    m_out.flush();
+    LOG_INFO(g_log) << "FluidRecorder wrote " << m_writtenFrameCount.load() << " frames, dropped "
+                    << m_droppedFrameCount;
+}
+
+void
+spark::FluidRecorder
+::capture( const Fluid& fluid )
+{
+    const size_t update = m_updateCount++;
+    if( update % m_interval != 0 )
+    {
+        return;
+    }
+    const size_t frameNumber = m_frameCount++;
+    const size_t head = m_head.load( boost::memory_order_relaxed );
+    if( head - m_tail.load( boost::memory_order_acquire ) == m_ring.size()
+        || fluid.dimX() != m_dimX || fluid.dimY() != m_dimY || fluid.dimZ() != m_dimZ )
+    {
+        ++m_droppedFrameCount;
+        return;
+    }
+    Frame& frame = m_ring[ head % m_ring.size() ];
+    frame.index[0] = (long long)frameNumber;
+    frame.index[1] = (long long)update;
+    copyFields( fluid, frame );
+    m_head.store( head + 1, boost::memory_order_release );
+    m_frameReady.notify_one();
+}
+
+void
+spark::FluidRecorder
+::copyFields( const Fluid& fluid, Frame& frame ) const
+{
+    const float* fields[5];
+    size_t fieldCount = 0;
+    if( m_fields & DensityField )
+    {
+        fields[fieldCount++] = fluid.getDensityData();
+    }
+    if( m_fields & TemperatureField )
+    {
+        fields[fieldCount++] = fluid.getTemperatureData();
+    }
+    if( m_fields & VelocityField )
+    {
+        fluid.getVelocityData( fields[fieldCount], fields[fieldCount+1], fields[fieldCount+2] );
+        fieldCount += 3;
+    }
+    float* out = &frame.data[0];
+    const size_t volume = m_dimX*m_dimY*m_dimZ;
+    for( size_t f = 0; f < fieldCount; ++f )
+    {
+        if( m_ySlices.empty() )
+        {
+            std::memcpy( out, fields[f], volume * sizeof( float ) );
+            out += volume;
+            continue;
+        }
+        for( size_t s = 0; s < m_ySlices.size(); ++s )
+        {
+            for( size_t k = 0; k < m_dimZ; ++k )
+            {
+                const float* row = fields[f] + m_dimX*( m_ySlices[s] + m_dimY*k );
+                std::memcpy( out, row, m_dimX * sizeof( float ) );
+                out += m_dimX;
+            }
+        }
+    }
+}
+
+void
+spark::FluidRecorder
+::writerLoop( void )
+{
+    boost::unique_lock<boost::mutex> lock( m_mutex );
+    while( true )
+    {
+        const bool isStopping = m_isStopping;
+        lock.unlock();
+        size_t tail = m_tail.load( boost::memory_order_relaxed );
+        while( tail != m_head.load( boost::memory_order_acquire ) )
+        {
+            writeFrame( m_ring[ tail % m_ring.size() ] );
+            m_tail.store( ++tail, boost::memory_order_release );
+            m_writtenFrameCount.store( m_writtenFrameCount.load() + 1, boost::memory_order_release );
+        }
+        lock.lock();
+        if( isStopping )
+        {
+            return;
+        }
+        // capture() notifies without the lock, so a wake-up can be
+        // missed; the timeout bounds how long a frame waits.
+        m_frameReady.timed_wait( lock, boost::posix_time::milliseconds( 10 ) );
+    }
+}
+
+void
+spark::FluidRecorder
+::writeFrame( const Frame& frame )
+{
+    m_out.write( m_indexHeader.data(), m_indexHeader.size() );
+    m_out.write( (const char*)frame.index, sizeof( frame.index ) );
+    m_out.write( m_dataHeader.data(), m_dataHeader.size() );
+    m_out.write( (const char*)&frame.data[0], frame.data.size() * sizeof( float ) );
+}
@@ -0,0 +1,243 @@
+#include "GridDBMSpark.hpp"
+#include "FluidKernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+spark::GridDBMSpark
+::GridDBMSpark( size_t Nx, size_t Ny, size_t Nz, float h )
+: m_Nx( Nx ),
+  m_Ny( Ny ),
+  m_Nz( Nz ),
+  m_h( h ),
+  m_eta( 3 ),
+  m_tolerance( 1e-3f ),
+  m_maxIterations( 50 ),
+  m_solverIterations( 0 ),
+  m_hasStruck( false ),
+  m_isSolved( false ),
+  m_isCandidateViewStale( true ),
+  m_solver( Nx, Ny, Nz ),
+  m_threadPool( new ThreadPool() ),
+  m_threadCount( m_threadPool->threadCount() )
+{
+    const size_t cellCount = ( Nx + 2 ) * ( Ny + 2 ) * ( Nz + 2 );
+    m_potential.assign( cellCount, 0.0f );
+    m_zero.assign( cellCount, 0.0f );
+    // Only interior cells above the ground row can join the aggregate
+    m_cellState.assign( cellCount, GroundCell );
+    for( size_t k = 1; k <= Nz; ++k )
+    {
+        for( size_t i = 1; i <= Nx; ++i )
+        {
+            m_solver.addFixedCell( index( i, 1, k ) );
+        }
+        for( size_t j = 2; j <= Ny; ++j )
+        {
+            std::fill( m_cellState.begin() + index( 1, j, k ),
+                       m_cellState.begin() + index( Nx + 1, j, k ),
+                       (unsigned char)FreeCell );
+        }
+    }
+}
+
+void
+spark::GridDBMSpark
+::addAggregateCell( size_t i, size_t j, size_t k )
+{
+    if( i < 1 || i > m_Nx || j < 2 || j > m_Ny || k < 1 || k > m_Nz )
+    {
+        LOG_ERROR(g_log) << "GridDBMSpark cell (" << i << ", " << j << ", " << k
+                         << ") is outside the grid, ignoring.";
+        return;
+    }
+    const size_t ind = index( i, j, k );
+    if( m_cellState[ind] == AggregateCell )
+    {
+        return;
+    }
+    if( m_cellState[ind] == CandidateCell )
+    {
+        m_candidates.erase( std::find( m_candidates.begin(), m_candidates.end(), ind ) );
+    }
+    addToAggregate( ind );
+}
+
+void
+spark::GridDBMSpark
+::update( double /*dt*/ )
+{
+    if( m_hasStruck || m_candidates.empty() )
+    {
+        return;
+    }
+    if( m_threadCount != m_threadPool->threadCount() )
+    {
+        m_threadPool.reset( new ThreadPool( m_threadCount ) );
+    }
+    if( !m_isSolved )
+    {
+        solve();
+    }
+    const size_t c = selectCandidate();
+    const size_t ind = m_candidates[c];
+    m_candidates[c] = m_candidates.back();
+    m_candidates.pop_back();
+    addToAggregate( ind );
+    solve();
+    LOG_DEBUG(g_log) << "GridDBMSpark::update(), agg: " << m_aggregate.size()
+                     << ", can: " << m_candidates.size()
+                     << ", solver iterations: " << m_solverIterations;
+}
+
+const spark::PointCharges&
+spark::GridDBMSpark
+::candidate( void ) const
+{
+    if( m_isCandidateViewStale )
+    {
+        m_candidateView.resize( m_candidates.size() );
+        for( size_t c = 0; c < m_candidates.size(); ++c )
+        {
+            const Eigen::Vector3f pos = cellPosition( m_candidates[c] );
+            m_candidateView[c] = PointCharge( pos[0], pos[1], pos[2] );
+            m_candidateView[c].phi = cellField( m_candidates[c] );
+        }
+        m_isCandidateViewStale = false;
+    }
+    return m_candidateView;
+}
+
+void
+spark::GridDBMSpark
+::setSolverTolerance( float tolerance, unsigned int maxIterations )
+{
+    m_tolerance = tolerance;
+    m_maxIterations = maxIterations;
+}
+
+void
+spark::GridDBMSpark
+::setThreadCount( unsigned int threadCount )
+{
+    m_threadCount = threadCount ? threadCount : ThreadPool::hardwareThreadCount();
+}
+
+void
+spark::GridDBMSpark
+::solve( void )
+{
+    m_solverIterations = m_solver.solve( &m_potential[0], &m_zero[0],
+                                         m_tolerance, m_maxIterations,
+                                         *m_threadPool, fluidKernels() );
+    m_isSolved = true;
+    m_isCandidateViewStale = true;
+}
+
+void
+spark::GridDBMSpark
+::addToAggregate( size_t ind )
+{
+    const Eigen::Vector3f pos = cellPosition( ind );
+    PointCharge charge( pos[0], pos[1], pos[2] );
+    charge.phi = cellField( ind );
+    m_aggregate.push_back( charge );
+
+    m_cellState[ind] = AggregateCell;
+    m_potential[ind] = 1.0f;
+    m_solver.addFixedCell( ind );
+    addNeighborCandidates( ind );
+    m_isSolved = false;
+    m_isCandidateViewStale = true;
+}
+
+void
+spark::GridDBMSpark
+::addNeighborCandidates( size_t ind )
+{
+    const ptrdiff_t dy = m_Nx + 2;
+    const ptrdiff_t dz = dy * ( m_Ny + 2 );
+    // Cells beside the boundary layer or the ground row touch a face
+    bool isTouchingFace = false;
+    for( ptrdiff_t dk = -1; dk <= 1; ++dk )
+    {
+        for( ptrdiff_t dj = -1; dj <= 1; ++dj )
+        {
+            for( ptrdiff_t di = -1; di <= 1; ++di )
+            {
+                const size_t n = ind + di + dy*dj + dz*dk;
+                if( m_cellState[n] == FreeCell )
+                {
+                    m_cellState[n] = CandidateCell;
+                    m_candidates.push_back( n );
+                }
+                else if( m_cellState[n] == GroundCell )
+                {
+                    isTouchingFace = true;
+                }
+            }
+        }
+    }
+    if( isTouchingFace && !m_hasStruck )
+    {
+        m_hasStruck = true;
+        LOG_INFO(g_log) << "GridDBMSpark reached a face after " << m_aggregate.size() << " cells";
+    }
+}
+
+size_t
+spark::GridDBMSpark
+::selectCandidate( void )
+{
+    m_weightSums.resize( m_candidates.size() );
+    double total = 0;
+    for( size_t c = 0; c < m_candidates.size(); ++c )
+    {
+        const float phi = std::max( 0.0f, 1.0f - m_potential[m_candidates[c]] );
+        total += std::pow( phi, m_eta );
+        m_weightSums[c] = total;
+    }
+    const double p = m_random.uniformDouble();
+    if( total <= 0.0 )
+    {
+        // every candidate at the aggregate's potential; all equally likely
+        return std::min( (size_t)( p * m_candidates.size() ), m_candidates.size() - 1 );
+    }
+    const size_t c = std::upper_bound( m_weightSums.begin(), m_weightSums.end(), p * total )
+                   - m_weightSums.begin();
+    return std::min( c, m_candidates.size() - 1 );
+}
+
+Eigen::Vector3f
+spark::GridDBMSpark
+::cellPosition( size_t ind ) const
+{
+    const size_t i = ind % ( m_Nx + 2 );
+    const size_t j = ( ind / ( m_Nx + 2 ) ) % ( m_Ny + 2 );
+    const size_t k = ind / ( ( m_Nx + 2 ) * ( m_Ny + 2 ) );
+    return Eigen::Vector3f( ( i - 0.5f - 0.5f*m_Nx ) * m_h,
+                            ( j - 0.5f - 0.5f*m_Ny ) * m_h,
+                            ( k - 0.5f - 0.5f*m_Nz ) * m_h );
+}
+
+Eigen::Vector3f
+spark::GridDBMSpark
+::cellField( size_t ind ) const
+{
+    const size_t dy = m_Nx + 2;
+    const size_t dz = dy * ( m_Ny + 2 );
+    const float* u = &m_potential[0];
+    const float scale = -0.5f / m_h;
+    return Eigen::Vector3f( scale * ( u[ind+1]  - u[ind-1] ),
+                            scale * ( u[ind+dy] - u[ind-dy] ),
+                            scale * ( u[ind+dz] - u[ind-dz] ) );
+}
+
+spark::GridDBMSparkPtr
+spark::buildGridSpark_pointInBox( size_t N, float halfWidth )
+{
+    GridDBMSparkPtr spark( new GridDBMSpark( N, N, N, 2.0f * halfWidth / N ) );
+    const size_t center = ( N + 1 ) / 2;
+    spark->addAggregateCell( center, center, center );
+    return spark;
+}
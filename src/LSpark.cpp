@@ -44,13 +44,6 @@ spark::LSpark
     // Noop
 }
 
-float
-spark::LSpark
-::unitRandom( void )
-{
-    return 1.0f - ( (rand()*2.0f) / RAND_MAX );
-}
-
 void
 spark::LSpark
 ::create( const Eigen::Vector3f& a_begin,
@@ -118,9 +111,23 @@ spark::LSpark
 ::advect( VelocityFieldInterfacePtr velocityField )
 {
     const float dt = 0.03;
-    for( size_t i = 2; i < m_segments.size(); ++i )
+    if( m_segments.size() <= 2 )
+    {
+        return;
+    }
+    // Sample every segment in one batch, endpoints excluded
+    const size_t n = m_segments.size() - 2;
+    std::vector< float > positions( 3*n );
+    std::vector< float > velocities( 3*n );
+    for( size_t i = 0; i < n; ++i )
+    {
+        Map< Vector3f > position( &positions[3*i] );
+        position = m_segments[i+2].m_pos;
+    }
+    velocityField->velocityAtPositions( &positions[0], n, &velocities[0] );
+    for( size_t i = 0; i < n; ++i )
     {
-        m_segments[i].m_pos += dt * velocityField->velocityAtPosition( m_segments[i].m_pos );
+        m_segments[i+2].m_pos += dt * Map< const Vector3f >( &velocities[3*i] );
     }
 }
 
@@ -145,7 +152,7 @@ spark::LSpark
     // Sometimes add an additional fork branch to either of the new segments
     // Don't split an end-point!
     if( (m_segments[a_index].m_parentIndex != -1)
-       && ((rand()*1.0f/RAND_MAX) < a_forkProb)
+       && (m_random.uniform() < a_forkProb)
        && !isTerminalSegment( a_index )
        )
     {
@@ -45,6 +45,39 @@ spark
     return 0;
 }
 
+void
+spark
+::TissueMesh_accumulateElectricalEnergyAt( TissueMesh* tissue,
+                                           const luabind::object& contacts,
+                                           float voltage,
+                                           float current,
+                                           float dutyCycle,
+                                           float radiusOfContact,
+                                           float dt )
+{
+    std::vector< glm::vec2 > points;
+    for( luabind::iterator i( contacts ), end; i != end; ++i )
+    {
+        points.push_back( luabind::object_cast< glm::vec2 >( *i ) );
+    }
+    tissue->accumulateElectricalEnergy( points, voltage, current, dutyCycle, radiusOfContact, dt );
+}
+
+void
+spark
+::Random_fillUniform( Random* random,
+                      const luabind::object& table,
+                      int n, float lo, float hi )
+{
+    if( n <= 0 ) return;
+    std::vector< float > values( n );
+    random->fillUniform( &values[0], n, lo, hi );
+    for( int i = 0; i < n; ++i )
+    {
+        table[i+1] = values[i];
+    }
+}
+
 void
 spark
 ::bindSceneFacade( lua_State* lua )
@@ -113,7 +146,15 @@ spark
     luabind::module( lua )
     [
      luabind::class_< TissueMesh, Renderable, TissueMeshPtr >( "TissueMesh" )
-     .def( "accumulateElectricalEnergy", &TissueMesh::accumulateElectricalEnergy )
+     .enum_( "ThermalSolverType" )
+     [
+         luabind::value( "ExplicitThermalSolver", TissueMesh::ExplicitThermalSolver ),
+         luabind::value( "ImplicitThermalSolver", TissueMesh::ImplicitThermalSolver )
+     ]
+     .def( "setThermalSolver", &TissueMesh::setThermalSolver )
+     .def( "setThreadCount", &TissueMesh::setThreadCount )
+     .def( "accumulateElectricalEnergy", (void (TissueMesh::*)( float, float, float, float, float, float, float ))&TissueMesh::accumulateElectricalEnergy )
+     .def( "accumulateElectricalEnergyAt", &TissueMesh_accumulateElectricalEnergyAt )
      .def( "getVaporizationDepthMapTextureName", &TissueMesh::getVaporizationDepthMapTextureName )
      .def( "getTempMapTextureName", &TissueMesh::getTempMapTextureName )
      .def( "getConditionMapTextureName", &TissueMesh::getConditionMapTextureName )
@@ -138,15 +179,54 @@ spark
     luabind::module( lua )
     [
         luabind::class_< Fluid, FluidPtr >( "Fluid" )
+        .enum_( "PressureSolverType" )
+        [
+            luabind::value( "GaussSeidelPressureSolver", Fluid::GaussSeidelPressureSolver ),
+            luabind::value( "MultigridPressureSolver", Fluid::MultigridPressureSolver )
+        ]
         .def( "setViscosity", &Fluid::setViscosity )
         .def( "setDiffusion", &Fluid::setDiffusion )
         .def( "setVorticity", &Fluid::setVorticity )
         .def( "setAbsorption", &Fluid::setAbsorption )
         .def( "setGravityFactor", &Fluid::setGravityFactor )
         .def( "setSolverIterations", &Fluid::setSolverIterations )
+        .def( "setThreadCount", &Fluid::setThreadCount )
+        .def( "setPressureSolver", &Fluid::setPressureSolver )
+        .def( "setPressureTolerance", &Fluid::setPressureTolerance )
+        .def( "getPressureIterations", &Fluid::getPressureIterations )
+        .def( "getPressureResidual", &Fluid::getPressureResidual )
+        .def( "getPressureResidualMax", &Fluid::getPressureResidualMax )
+        .def( "setPressureResidualInterval", &Fluid::setPressureResidualInterval )
+        .def( "setPressureWarmStart", &Fluid::setPressureWarmStart )
+        .def( "setBrickSkipping", &Fluid::setBrickSkipping )
+        .def( "setHugePages", &Fluid::setHugePages )
+        .def( "setHalfFloatSnapshots", &Fluid::setHalfFloatSnapshots )
+        .def( "setBrickThreshold", &Fluid::setBrickThreshold )
+        .def( "setTargetCFL", &Fluid::setTargetCFL )
+        .def( "setMaxSubsteps", &Fluid::setMaxSubsteps )
+        .def( "setUpdateBudget", &Fluid::setUpdateBudget )
+        .def( "getSubstepCount", &Fluid::getSubstepCount )
+        .def( "getUpdateMilliseconds", &Fluid::getUpdateMilliseconds )
+        .def( "getCFL", &Fluid::getCFL )
+        .def( "saveCheckpoint", &Fluid::saveCheckpoint )
+        .def( "loadCheckpoint", &Fluid::loadCheckpoint )
+        .def( "clearSources", &Fluid::clearSources )
+        .def( "getSourceCount", &Fluid::getSourceCount )
         .def( "reset", &Fluid::reset )
     ];
 
+    /////////////////////////////////////////////////////////// Random
+    luabind::module( lua )
+    [
+        luabind::class_< Random, RandomPtr >( "Random" )
+        .def( luabind::constructor<>() )
+        .def( luabind::constructor<unsigned int>() )
+        .def( "seed", &Random_seed )
+        .def( "uniform", (float (Random::*)(void)) &Random::uniform )
+        .def( "uniform", (float (Random::*)(float, float)) &Random::uniform )
+        .def( "fillUniform", &Random_fillUniform )
+    ];
+
     /////////////////////////////////////////////////////////// TexturedSparkRenderable/Spark
     luabind::module( lua )
     [
@@ -0,0 +1,439 @@
+#include "MultigridSolver.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+spark::MultigridSolver
+::MultigridSolver( size_t Nx, size_t Ny, size_t Nz )
+: m_preSmooth( 2 ),
+  m_postSmooth( 2 ),
+  m_coarsestIterations( 16 ),
+  m_residual( 0 ),
+  m_pool( NULL ),
+  m_kernels( NULL )
+{
+    // Coarsen every axis together, so cells stay cubes, until the
+    // shortest axis is small.  Longer axes are left with more cells than
+    // that, so the coarsest level gets enough sweeps to cross them.
+    const size_t coarsestSize = 4;
+    size_t nx = Nx, ny = Ny, nz = Nz;
+    while( true )
+    {
+        Level level;
+        level.nx = nx;
+        level.ny = ny;
+        level.nz = nz;
+        level.dimX = nx + 2;
+        level.dimY = ny + 2;
+        const size_t cellCount = level.dimX * level.dimY * (nz + 2);
+        level.x.resize( cellCount, 0.0f );
+        level.b.resize( cellCount, 0.0f );
+        level.r.resize( cellCount, 0.0f );
+        m_levels.push_back( level );
+        if( std::min( nx, std::min( ny, nz ) ) <= coarsestSize )
+        {
+            break;
+        }
+        nx = (nx + 1) / 2;
+        ny = (ny + 1) / 2;
+        nz = (nz + 1) / 2;
+    }
+    const size_t longest = std::max( nx, std::max( ny, nz ) );
+    m_coarsestIterations = std::max<unsigned int>( m_coarsestIterations, 2*longest );
+    m_coarsestIterations += m_coarsestIterations & 1;
+    const size_t cellCount = (Nx+2)*(Ny+2)*(Nz+2);
+    m_direction.resize( cellCount, 0.0f );
+    m_product.resize( cellCount, 0.0f );
+    m_slabSums.resize( Nz + 2, 0.0 );
+    LOG_DEBUG(g_log) << "MultigridSolver with " << m_levels.size()
+        << " levels for N=" << Nx << "x" << Ny << "x" << Nz
+        << ", coarsest N=" << nx << "x" << ny << "x" << nz;
+}
+
+void
+spark::MultigridSolver
+::addFixedCell( size_t ind )
+{
+    m_fixedCells.push_back( ind );
+}
+
+unsigned int
+spark::MultigridSolver
+::solve( float* x, const float* b,
+         float tolerance, unsigned int maxIterations,
+         ThreadPool& pool, const FluidKernels& kernels )
+{
+    m_pool = &pool;
+    m_kernels = &kernels;
+    const Level& finest = m_levels.front();
+    // The residual lives in the finest level's right-hand side, so each
+    // preconditioner V-cycle reads it in place and writes z to finest.x.
+    float* r = &m_levels.front().b[0];
+    float* z = &m_levels.front().x[0];
+    float* p = &m_direction[0];
+    float* q = &m_product[0];
+
+    double bNorm;
+    if( m_fixedCells.empty() )
+    {
+        bNorm = std::sqrt( dot( finest, b, b ) );
+    }
+    else
+    {
+        // The free cells' right-hand side is b less the fixed cells' part
+        // of Ax.  p keeps the fixed values in case x = 0 below.
+        std::fill( p, p + m_direction.size(), 0.0f );
+        for( size_t c = 0; c < m_fixedCells.size(); ++c )
+        {
+            p[m_fixedCells[c]] = x[m_fixedCells[c]];
+        }
+        enforceBoundary( finest, p );
+        applyOperator( finest, p, q );
+        axpy( finest, b, -1.0f, q, r, NULL, 0.0f, NULL );
+        zeroFixedCells( r );
+        bNorm = std::sqrt( dot( finest, r, r ) );
+    }
+    if( bNorm == 0.0 )
+    {
+        // x = 0 is the exact solution
+        std::fill( x, x + m_direction.size(), 0.0f );
+        for( size_t c = 0; c < m_fixedCells.size(); ++c )
+        {
+            x[m_fixedCells[c]] = p[m_fixedCells[c]];
+        }
+        m_residual = 0;
+        return 0;
+    }
+
+    enforceBoundary( finest, x );
+    applyOperator( finest, x, q );
+    double rNorm0 = axpy( finest, b, -1.0f, q, r, NULL, 0.0f, NULL );
+    if( !m_fixedCells.empty() )
+    {
+        zeroFixedCells( r );
+        rNorm0 = dot( finest, r, r );
+    }
+    double rNorm = std::sqrt( rNorm0 );
+    unsigned int iteration = 0;
+    if( rNorm > tolerance * bNorm )
+    {
+        precondition();
+        zeroFixedCells( z );
+        std::copy( z, z + m_direction.size(), p );
+        double rz = dot( finest, r, z );
+        while( iteration < maxIterations )
+        {
+            ++iteration;
+            enforceBoundary( finest, p );
+            applyOperator( finest, p, q );
+            // so r stays zero at the fixed cells, and x keeps them
+            zeroFixedCells( q );
+            const float alpha = (float)( rz / dot( finest, p, q ) );
+            rNorm = std::sqrt( axpy( finest, r, -alpha, q, r, p, alpha, x ) );
+            if( rNorm <= tolerance * bNorm )
+            {
+                break;
+            }
+            precondition();
+            zeroFixedCells( z );
+            const double rzNext = dot( finest, r, z );
+            const float beta = (float)( rzNext / rz );
+            rz = rzNext;
+            axpy( finest, z, beta, p, p, NULL, 0.0f, NULL );
+        }
+    }
+    enforceBoundary( finest, x );
+    m_residual = (float)( rNorm / bNorm );
+
+    m_pool = NULL;
+    m_kernels = NULL;
+    return iteration;
+}
+
+void
+spark::MultigridSolver
+::precondition( void )
+{
+    std::fill( m_levels.front().x.begin(), m_levels.front().x.end(), 0.0f );
+    vCycle( 0 );
+}
+
+void
+spark::MultigridSolver
+::vCycle( size_t l )
+{
+    Level& level = m_levels[l];
+    if( l + 1 == m_levels.size() )
+    {
+        // forward then reverse sweeps, so the coarse solve stays symmetric
+        relax( level, m_coarsestIterations/2, false );
+        relax( level, m_coarsestIterations/2, true );
+        return;
+    }
+    Level& coarse = m_levels[l+1];
+
+    relax( level, m_preSmooth, false );
+    applyOperator( level, &level.x[0], &level.r[0] );
+    axpy( level, &level.b[0], -1.0f, &level.r[0], &level.r[0], NULL, 0.0f, NULL );
+    restrictResidual( level, coarse );
+
+    // the coarse level solves for the correction, starting from zero
+    std::fill( coarse.x.begin(), coarse.x.end(), 0.0f );
+    vCycle( l + 1 );
+
+    prolongAndCorrect( coarse, level );
+    relax( level, m_postSmooth, true );
+}
+
+void
+spark::MultigridSolver
+::relax( Level& level, unsigned int iterations, bool isReversed )
+{
+    const ptrdiff_t dy = level.dimX;
+    const ptrdiff_t dz = level.dimX * level.dimY;
+    const float invC = 1.0f / 6.0f;
+    float* x = &level.x[0];
+    const float* b = &level.b[0];
+    for( unsigned int iter = 0; iter < iterations; ++iter )
+    {
+        for( int c = 0; c < 2; ++c )
+        {
+            const int color = isReversed ? 1 - c : c;
+            // boundary before each half-sweep keeps the y=0 face exact
+            enforceBoundary( level, x );
+            m_pool->parallelFor( 1, level.nz+1, [&]( size_t kBegin, size_t kEnd )
+            {
+                for( size_t k = kBegin; k < kEnd; ++k )
+                {
+                    for( size_t j = 1; j <= level.ny; ++j )
+                    {
+                        const size_t first = (1 + j + k + color) & 1;
+                        m_kernels->relaxRow( x, b, level.index( 1, j, k ), level.nx,
+                                             first, dy, dz, 1.0f, invC );
+                    }
+                }
+            } );
+        }
+    }
+    enforceBoundary( level, x );
+}
+
+void
+spark::MultigridSolver
+::applyOperator( const Level& level, const float* x, float* ax )
+{
+    const ptrdiff_t dy = level.dimX;
+    const ptrdiff_t dz = level.dimX * level.dimY;
+    m_pool->parallelFor( 1, level.nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        for( size_t k = kBegin; k < kEnd; ++k )
+        {
+            for( size_t j = 1; j <= level.ny; ++j )
+            {
+                size_t ind = level.index( 1, j, k );
+                for( size_t i = 1; i <= level.nx; ++i, ++ind )
+                {
+                    ax[ind] = 6.0f*x[ind]
+                        - ( x[ind-1] + x[ind+1] + x[ind-dy] + x[ind+dy] + x[ind-dz] + x[ind+dz] );
+                }
+            }
+        }
+    } );
+}
+
+double
+spark::MultigridSolver
+::axpy( const Level& level,
+        const float* a, float alpha, const float* b, float* out,
+        const float* c, float gamma, float* accumulate )
+{
+    std::fill( m_slabSums.begin(), m_slabSums.end(), 0.0 );
+    m_pool->parallelFor( 1, level.nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        for( size_t k = kBegin; k < kEnd; ++k )
+        {
+            double sum = 0;
+            for( size_t j = 1; j <= level.ny; ++j )
+            {
+                const size_t ind0 = level.index( 1, j, k );
+                if( accumulate )
+                {
+                    for( size_t ind = ind0; ind < ind0 + level.nx; ++ind )
+                    {
+                        accumulate[ind] += gamma * c[ind];
+                    }
+                }
+                for( size_t ind = ind0; ind < ind0 + level.nx; ++ind )
+                {
+                    const float v = a[ind] + alpha * b[ind];
+                    out[ind] = v;
+                    sum += v*v;
+                }
+            }
+            m_slabSums[k] = sum;
+        }
+    } );
+    // summed in slab order, so the result doesn't depend on the thread count
+    return std::accumulate( m_slabSums.begin(), m_slabSums.end(), 0.0 );
+}
+
+double
+spark::MultigridSolver
+::dot( const Level& level, const float* a, const float* b )
+{
+    std::fill( m_slabSums.begin(), m_slabSums.end(), 0.0 );
+    m_pool->parallelFor( 1, level.nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        for( size_t k = kBegin; k < kEnd; ++k )
+        {
+            double sum = 0;
+            for( size_t j = 1; j <= level.ny; ++j )
+            {
+                const size_t ind0 = level.index( 1, j, k );
+                for( size_t ind = ind0; ind < ind0 + level.nx; ++ind )
+                {
+                    sum += a[ind]*b[ind];
+                }
+            }
+            m_slabSums[k] = sum;
+        }
+    } );
+    return std::accumulate( m_slabSums.begin(), m_slabSums.end(), 0.0 );
+}
+
+void
+spark::MultigridSolver
+::restrictResidual( const Level& fine, Level& coarse )
+{
+    // Restriction is the transpose of prolongAndCorrect(), scaled by 1/2,
+    // which keeps the V-cycle symmetric as CG requires.  The 1/2 makes
+    // the unscaled coarse stencil match the Galerkin operator: cells are
+    // twice as wide (1/4) and each coarse cell gathers 8 fine cells (x8).
+    // The y=0 face copies the first row, so prolongation from the coarse
+    // boundary row is really from row 1, and row 1 gathers that weight too.
+    // Fine cells 2I-2 .. 2I+1 contribute to coarse cell I with 1D
+    // weights w; the fine boundary cells hold zero residual, so only
+    // cell n+2 past an odd-sized grid has to be skipped.
+    static const float w[4] = { 0.25f, 0.75f, 0.75f, 0.25f };
+    float* b = &coarse.b[0];
+    const float* r = &fine.r[0];
+    const size_t dy = fine.dimX;
+    const size_t dz = fine.dimX * fine.dimY;
+    m_pool->parallelFor( 1, coarse.nz+1, [&]( size_t KBegin, size_t KEnd )
+    {
+        for( size_t K = KBegin; K < KEnd; ++K )
+        {
+            const size_t k0 = 2*K - 2;
+            const size_t kCount = std::min<size_t>( 4, fine.nz + 2 - k0 );
+            for( size_t J = 1; J <= coarse.ny; ++J )
+            {
+                const size_t j0 = 2*J - 2;
+                const size_t jCount = std::min<size_t>( 4, fine.ny + 2 - j0 );
+                float wy[4] = { w[0], w[1], w[2], w[3] };
+                if( J == 1 )
+                {
+                    wy[1] += 0.25f;
+                }
+                for( size_t I = 1; I <= coarse.nx; ++I )
+                {
+                    const size_t i0 = 2*I - 2;
+                    const size_t iCount = std::min<size_t>( 4, fine.nx + 2 - i0 );
+                    float sum = 0;
+                    for( size_t ok = 0; ok < kCount; ++ok )
+                    {
+                        for( size_t oj = 0; oj < jCount; ++oj )
+                        {
+                            const float* row = r + i0 + dy*(j0 + oj) + dz*(k0 + ok);
+                            float rowSum = 0;
+                            for( size_t oi = 0; oi < iCount; ++oi )
+                            {
+                                rowSum += w[oi] * row[oi];
+                            }
+                            sum += w[ok] * wy[oj] * rowSum;
+                        }
+                    }
+                    b[coarse.index( I, J, K )] = 0.5f * sum;
+                }
+            }
+        }
+    } );
+}
+
+void
+spark::MultigridSolver
+::prolongAndCorrect( const Level& coarse, Level& fine )
+{
+    // Trilinear interpolation between cell centers: each fine cell gets
+    // 3/4 of its parent and 1/4 of the parent's neighbor on the side of
+    // the fine cell, per dimension.  Coarse boundary cells must be set.
+    const float* e = &coarse.x[0];
+    m_pool->parallelFor( 1, fine.nz+1, [&]( size_t kBegin, size_t kEnd )
+    {
+        for( size_t k = kBegin; k < kEnd; ++k )
+        {
+            const size_t K = (k + 1) / 2;
+            const size_t K2 = (k & 1) ? K - 1 : K + 1;
+            for( size_t j = 1; j <= fine.ny; ++j )
+            {
+                const size_t J = (j + 1) / 2;
+                const size_t J2 = (j & 1) ? J - 1 : J + 1;
+                const float* e00 = e + coarse.index( 0, J,  K  );
+                const float* e10 = e + coarse.index( 0, J2, K  );
+                const float* e01 = e + coarse.index( 0, J,  K2 );
+                const float* e11 = e + coarse.index( 0, J2, K2 );
+                float* x = &fine.x[fine.index( 0, j, k )];
+                for( size_t i = 1; i <= fine.nx; ++i )
+                {
+                    const size_t I = (i + 1) / 2;
+                    const size_t I2 = (i & 1) ? I - 1 : I + 1;
+                    const float near = 0.75f*( 0.75f*e00[I] + 0.25f*e10[I] )
+                                     + 0.25f*( 0.75f*e01[I] + 0.25f*e11[I] );
+                    const float far  = 0.75f*( 0.75f*e00[I2] + 0.25f*e10[I2] )
+                                     + 0.25f*( 0.75f*e01[I2] + 0.25f*e11[I2] );
+                    x[i] += 0.75f*near + 0.25f*far;
+                }
+            }
+        }
+    } );
+}
+
+void
+spark::MultigridSolver
+::enforceBoundary( const Level& level, float* x )
+{
+    const size_t nx = level.nx;
+    const size_t ny = level.ny;
+    const size_t nz = level.nz;
+    for( size_t k = 1; k <= nz; ++k )
+    {
+        for( size_t j = 1; j <= ny; ++j )
+        {
+            x[level.index( 0,    j, k )] = 0;
+            x[level.index( nx+1, j, k )] = 0;
+        }
+        for( size_t i = 1; i <= nx; ++i )
+        {
+            x[level.index( i, 0,    k )] = x[level.index( i, 1, k )];
+            x[level.index( i, ny+1, k )] = 0;
+        }
+    }
+    for( size_t j = 1; j <= ny; ++j )
+    {
+        for( size_t i = 1; i <= nx; ++i )
+        {
+            x[level.index( i, j, 0    )] = 0;
+            x[level.index( i, j, nz+1 )] = 0;
+        }
+    }
+}
+
+void
+spark::MultigridSolver
+::zeroFixedCells( float* v ) const
+{
+    for( size_t c = 0; c < m_fixedCells.size(); ++c )
+    {
+        v[m_fixedCells[c]] = 0.0f;
+    }
+}
@@ -12,7 +12,7 @@
 #include <Eigen/OpenGLSupport>
 
 spark::PointSparkRenderable
-::PointSparkRenderable( DBMSparkPtr spark,
+::PointSparkRenderable( DielectricBreakdownModelPtr spark,
                         TextureManagerPtr tm,
                         ShaderManagerPtr sm )
 : Renderable( "PointSparkRenderable" ),
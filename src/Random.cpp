@@ -0,0 +1,48 @@
+#include "Random.hpp"
+
+namespace
+{
+    /// splitmix64 step, spreads a seed over the whole state
+    boost::uint64_t splitMix64( boost::uint64_t& x )
+    {
+        boost::uint64_t z = ( x += 0x9e3779b97f4a7c15ULL );
+        z = ( z ^ ( z >> 30 ) ) * 0xbf58476d1ce4e5b9ULL;
+        z = ( z ^ ( z >> 27 ) ) * 0x94d049bb133111ebULL;
+        return z ^ ( z >> 31 );
+    }
+}
+
+spark::Random
+::Random( boost::uint64_t seed )
+{
+    this->seed( seed );
+}
+
+void
+spark::Random
+::seed( boost::uint64_t seed )
+{
+    // splitmix64 never gives an all-zero state, the one xoshiro can't leave
+    boost::uint64_t x = seed;
+    const boost::uint64_t a = splitMix64( x );
+    const boost::uint64_t b = splitMix64( x );
+    m_s[0] = (boost::uint32_t)a;
+    m_s[1] = (boost::uint32_t)( a >> 32 );
+    m_s[2] = (boost::uint32_t)b;
+    m_s[3] = (boost::uint32_t)( b >> 32 );
+}
+
+void
+spark::Random
+::fillUniform( float* out, size_t n, float lo, float hi )
+{
+    // Work on a local copy so the state stays in registers, not
+    // reloaded through this for every store to out
+    Random r( *this );
+    const float scale = ( hi - lo ) * ( 1.0f / 16777216.0f );
+    for( size_t i = 0; i < n; ++i )
+    {
+        out[i] = lo + scale * ( r.next() >> 8 );
+    }
+    *this = r;
+}
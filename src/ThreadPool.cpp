@@ -0,0 +1,116 @@
+#include "ThreadPool.hpp"
+
+#include <boost/thread/locks.hpp>
+
+spark::ThreadPool
+::ThreadPool( unsigned int threadCount )
+: m_threadCount( threadCount ? threadCount : hardwareThreadCount() ),
+  m_task( NULL ),
+  m_begin( 0 ),
+  m_end( 0 ),
+  m_generation( 0 ),
+  m_pendingWorkers( 0 ),
+  m_isStopping( false )
+{
+    // chunk 0 is always run by the thread calling parallelFor()
+    for( unsigned int c = 1; c < m_threadCount; ++c )
+    {
+        m_workers.add_thread( new boost::thread( &ThreadPool::workerLoop, this, c ) );
+    }
+    LOG_DEBUG(g_log) << "ThreadPool created with " << m_threadCount << " threads.";
+}
+
+spark::ThreadPool
+::~ThreadPool()
+{
+    {
+        boost::lock_guard<boost::mutex> lock( m_mutex );
+        m_isStopping = true;
+    }
+    m_workReady.notify_all();
+    m_workers.join_all();
+}
+
+unsigned int
+spark::ThreadPool
+::hardwareThreadCount( void )
+{
+    const unsigned int n = boost::thread::hardware_concurrency();
+    return n ? n : 1;
+}
+
+void
+spark::ThreadPool
+::parallelFor( size_t begin, size_t end, const RangeTask& task )
+{
+    if( end <= begin )
+    {
+        return;
+    }
+    if( m_threadCount == 1 )
+    {
+        task( begin, end );
+        return;
+    }
+    {
+        boost::lock_guard<boost::mutex> lock( m_mutex );
+        m_task = &task;
+        m_begin = begin;
+        m_end = end;
+        m_pendingWorkers = m_threadCount - 1;
+        ++m_generation;
+    }
+    m_workReady.notify_all();
+
+    task( chunkBegin( 0 ), chunkBegin( 1 ) );
+
+    boost::unique_lock<boost::mutex> lock( m_mutex );
+    while( m_pendingWorkers > 0 )
+    {
+        m_workDone.wait( lock );
+    }
+    m_task = NULL;
+}
+
+void
+spark::ThreadPool
+::workerLoop( unsigned int chunkIndex )
+{
+    unsigned long lastGeneration = 0;
+    while( true )
+    {
+        const RangeTask* task = NULL;
+        size_t chunkStart = 0;
+        size_t chunkEnd = 0;
+        {
+            boost::unique_lock<boost::mutex> lock( m_mutex );
+            while( !m_isStopping && m_generation == lastGeneration )
+            {
+                m_workReady.wait( lock );
+            }
+            if( m_isStopping )
+            {
+                return;
+            }
+            lastGeneration = m_generation;
+            task = m_task;
+            chunkStart = chunkBegin( chunkIndex );
+            chunkEnd = chunkBegin( chunkIndex + 1 );
+        }
+
+        if( chunkStart < chunkEnd )
+        {
+            (*task)( chunkStart, chunkEnd );
+        }
+
+        bool isLast = false;
+        {
+            boost::lock_guard<boost::mutex> lock( m_mutex );
+            isLast = ( --m_pendingWorkers == 0 );
+        }
+        if( isLast )
+        {
+            m_workDone.notify_one();
+        }
+    }
+}
@@ -1,9 +1,37 @@
 
 #include "TissueMesh.hpp"
 #include "TextureManager.hpp"
+#include "FluidKernels.hpp"
 
 #include <glm/glm.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    /// Interior cells per side of a tile, the unit of activity tracking
+    /// and of the diffusion sweeps.  A tile and its halo (two maps) stay
+    /// within L1.
+    const size_t tileSize = 32;
+    /// Substeps run on a tile per load; the halo is this wide.
+    const size_t diffusionTileIterations = 4;
+    /// Body temperature, the baseline tissue relaxes to.
+    const float baselineTemp = 273.15f + 37.0f;
+    /// A tile whose cells are all this close to baseline (Kelvin) is
+    /// reset to baseline and skipped until heated again.
+    const float baselineEpsilon = 1e-2f;
+    /// Scales current^2 * dt to the joules of electrical heating.
+    const float electricalUnitsFactor = 1e-10f;
+    /// Samples of the electrical falloff table per squared cell of
+    /// distance.  Interpolating linearly is within 2.5% per element (at
+    /// the half-cell clamp) and a fraction of a percent in total.
+    const float falloffSamplesPerCell2 = 16.0f;
+    /// Share of a contact's energy allowed beyond the falloff cutoff
+    const float falloffTailFraction = 0.01f;
+}
+
 spark::TissueMesh
 ::TissueMesh( const RenderableName& name,
               TextureManagerPtr tm,
@@ -15,17 +43,30 @@ spark::TissueMesh
   m_textureManager( tm ),
   m_N( heatDim + 2 ),
   m_voxelDimMeters( totalLengthMeters / (float)heatDim ),
+  m_tilesPerSide( ( heatDim + tileSize - 1 ) / tileSize ),
+  m_falloffRadius( -1.0f ),
+  m_falloffCutoff2( 0.0f ),
   m_diffusionIters( 100 ),
+  m_threadPool( new ThreadPool() ),
+  m_threadCount( m_threadPool->threadCount() ),
+  m_thermalSolver( ExplicitThermalSolver ),
   //m_SORovershoot( 1.00001 ),
   m_dessicationThresholdTemp( 273.15 + 37.0 + 20.0 ), //63.0 ),
   m_charThresholdTemp( 273.15 + 37.0 + 250.0 )
 {
     m_heatMap.resize( m_N * m_N, 0.0 );
     // body temp is 37C
-    m_tempMapA.resize( m_N * m_N, 273.15 + 37.0 );
-    m_tempMapB.resize( m_N * m_N, 273.15 + 37.0 );
+    m_tempMapA.resize( m_N * m_N, baselineTemp );
+    m_tempMapB.resize( m_N * m_N, baselineTemp );
     m_tissueCondition.resize( m_N * m_N, normalTissue );
     m_vaporizationDepthMap.resize( m_N * m_N );
+    m_isTileActive.resize( m_tilesPerSide * m_tilesPerSide, 0 );
+    m_isTileHeated.resize( m_tilesPerSide * m_tilesPerSide, 0 );
+    // Nothing is on the graphics card yet, so the first upload is in full
+    m_isConditionTileDirty.resize( m_tilesPerSide * m_tilesPerSide, 1 );
+    m_isDepthTileDirty.resize( m_tilesPerSide * m_tilesPerSide, 1 );
+    m_isTempTileDirty.resize( m_tilesPerSide * m_tilesPerSide, 1 );
+    m_tempHalfMap.resize( m_N * m_N );
 
     // Arbitrarily assign temp maps to current and next
     m_currTempMap = &m_tempMapA;
@@ -42,20 +83,34 @@ void
 spark::TissueMesh
 ::update( double dt )
 {
-    if( !m_textureManager ) return;
+    if( m_threadCount != m_threadPool->threadCount() )
+    {
+        m_threadPool.reset( new ThreadPool( m_threadCount ) );
+    }
+
+    // Only tiles that were heated or are away from baseline (and their
+    // neighbors, which they may heat) can change; elsewhere the tissue
+    // is normal, at baseline, and stays there.
+    gatherUpdateTiles();
+
     // Apply accumulated heat to change tissue temp
     // Q = c m dT
     // dT = Q/(cm)
-    for( size_t y = 1; y < m_N-1; ++y )
+    for( size_t t = 0; t < m_updateTiles.size(); ++t )
     {
-        for( size_t x = 1; x < m_N-1; ++x )
+        size_t x0, y0, x1, y1;
+        tileBounds( m_updateTiles[t], &x0, &y0, &x1, &y1 );
+        for( size_t y = y0; y < y1; ++y )
         {
-            const size_t i = index( x, y );
-            const double c = specificHeat( x, y );    // 3500 J/(kg K) for liver, approx
-            const double m = mass( x, y );
-            (*m_currTempMap)[i] += dt * m_heatMap[i] / ( c * m );
-            // zero heat map
-            m_heatMap[i] = 0.0;
+            for( size_t x = x0; x < x1; ++x )
+            {
+                const size_t i = index( x, y );
+                const double c = specificHeat( x, y );    // 3500 J/(kg K) for liver, approx
+                const double m = mass( x, y );
+                (*m_currTempMap)[i] += dt * m_heatMap[i] / ( c * m );
+                // zero heat map
+                m_heatMap[i] = 0.0;
+            }
         }
     }
 
@@ -63,197 +118,475 @@ spark::TissueMesh
     // Update tissue condition based on temperature
     const float vaporizationDepth = 0.002;
     size_t ind = 0;
-    for( size_t y = 1; y < m_N-1; ++y )
+    m_conditionEvents.clear();
+    for( size_t t = 0; t < m_updateTiles.size(); ++t )
     {
-        for( size_t x = 1; x < m_N-1; ++x )
+        const size_t tile = m_updateTiles[t];
+        // Diffusion and cooling may change any update tile's temperatures
+        m_isTempTileDirty[tile] = 1;
+        size_t x0, y0, x1, y1;
+        tileBounds( tile, &x0, &y0, &x1, &y1 );
+        for( size_t y = y0; y < y1; ++y )
         {
-            ind = index(x,y);
-            float tempKelvin = (*m_currTempMap)[ind];
-
-            // as the temp rises above 100, can start vaporizing
-            // the total energy (J) needed to complete the vaporization
-            // can be represented as a change in temp
-            float vapeHeatAsKelvin 
-                =   273.15f + 100.0f 
-                  + latentHeatOfVaporization(x,y) / specificHeat(x,y);
-            //  =   J/g / (J/(gK)) --> temp in kelvin
-            if(    (m_tissueCondition[ind] == normalTissue)
-                && (tempKelvin > vapeHeatAsKelvin) )
+            for( size_t x = x0; x < x1; ++x )
             {
-                // Vaporized tissue, from normalTissue
-                m_tissueCondition[ind] = vaporizingTissue;
-                m_tissueConditionUpdateBounds.addPoint( x, y );
-            }
-            else if( m_tissueCondition[ind] == vaporizingTissue )
-            {
-                // was vaporizing previously, now remove and set as gone
-                // TODO -- how long to vaporize?  Just one timestep seems
-                // arbitrary, especially if visualized
-                // still good to keep it discrete though for 
-                // efficiency moving to the graphics card.
-                // Possibly, introduce intermediate vaporizing states?
-                m_tissueCondition[ind] = vaporizedTissue;
-                m_tissueConditionUpdateBounds.addPoint( x, y );
-
-                /////////////////////////////////////////////////////////
-                //// TODO -------  
-                //// Depth must be limited by current tool depth!
-                //// HACK -------
-                //// depth limited by arbitrary constant!
-                //// see SimulationState.lua local passDepth in update() method
-                const float maxVaporizationDepth = 0.25;
-
-                m_vaporizationDepthMap[ind] = std::min( m_vaporizationDepthMap[ind] + vaporizationDepth,
-                                                        maxVaporizationDepth );
+                ind = index(x,y);
+                float tempKelvin = (*m_currTempMap)[ind];
+
+                // as the temp rises above 100, can start vaporizing
+                // the total energy (J) needed to complete the vaporization
+                // can be represented as a change in temp
+                float vapeHeatAsKelvin 
+                    =   273.15f + 100.0f 
+                      + latentHeatOfVaporization(x,y) / specificHeat(x,y);
+                //  =   J/g / (J/(gK)) --> temp in kelvin
+                if(    (m_tissueCondition[ind] == normalTissue)
+                    && (tempKelvin > vapeHeatAsKelvin) )
+                {
+                    // Vaporized tissue, from normalTissue
+                    setCondition( ind, tile, vaporizingTissue );
+                }
+                else if( m_tissueCondition[ind] == vaporizingTissue )
+                {
+                    // was vaporizing previously, now remove and set as gone
+                    // TODO -- how long to vaporize?  Just one timestep seems
+                    // arbitrary, especially if visualized
+                    // still good to keep it discrete though for 
+                    // efficiency moving to the graphics card.
+                    // Possibly, introduce intermediate vaporizing states?
+                    setCondition( ind, tile, vaporizedTissue );
+
+                    /////////////////////////////////////////////////////////
+                    //// TODO -------  
+                    //// Depth must be limited by current tool depth!
+                    //// HACK -------
+                    //// depth limited by arbitrary constant!
+                    //// see SimulationState.lua local passDepth in update() method
+                    const float maxVaporizationDepth = 0.25;
+
+                    m_vaporizationDepthMap[ind] = std::min( m_vaporizationDepthMap[ind] + vaporizationDepth,
+                                                            maxVaporizationDepth );
+                    m_isDepthTileDirty[tile] = 1;
                 
-                // For diffusion purposes, vaporized tissue
-                // is at a much reduced temperature-- it's not there anymore
-                // to diffuse heat from.
-                (*m_currTempMap)[ind] -= vapeHeatAsKelvin;
-                (*m_nextTempMap)[ind] -= vapeHeatAsKelvin;
-            }
-            else if( m_tissueCondition[ind] == vaporizedTissue )
-            {
-                // Depth has been altered, underlying tissue is normal
-               m_tissueCondition[ind] = normalTissue;
-               (*m_currTempMap)[ind] = 273.15f + 37.0f;
-               (*m_nextTempMap)[ind] = 273.15f + 37.0f;
-            }
+                    // For diffusion purposes, vaporized tissue
+                    // is at a much reduced temperature-- it's not there anymore
+                    // to diffuse heat from.
+                    (*m_currTempMap)[ind] -= vapeHeatAsKelvin;
+                    (*m_nextTempMap)[ind] -= vapeHeatAsKelvin;
+                }
+                else if( m_tissueCondition[ind] == vaporizedTissue )
+                {
+                    // Depth has been altered, underlying tissue is normal
+                   setCondition( ind, tile, normalTissue );
+                   (*m_currTempMap)[ind] = baselineTemp;
+                   (*m_nextTempMap)[ind] = baselineTemp;
+                }
             
-            // Dessication 
-            if(    (m_tissueCondition[ind] == normalTissue)
-                && (tempKelvin > m_dessicationThresholdTemp) )
-            {
-                m_tissueCondition[ind] = dessicatedTissue;
-                m_tissueConditionUpdateBounds.addPoint( x, y );
-            }
-            // Charring
-            if(    (m_tissueCondition[ind] == dessicatedTissue)
-                && (tempKelvin > m_charThresholdTemp) )
-            {
-                m_tissueCondition[ind] = charredTissue;
-                m_tissueConditionUpdateBounds.addPoint( x, y );
+                // Dessication 
+                if(    (m_tissueCondition[ind] == normalTissue)
+                    && (tempKelvin > m_dessicationThresholdTemp) )
+                {
+                    setCondition( ind, tile, dessicatedTissue );
+                }
+                // Charring
+                if(    (m_tissueCondition[ind] == dessicatedTissue)
+                    && (tempKelvin > m_charThresholdTemp) )
+                {
+                    setCondition( ind, tile, charredTissue );
+                }
             }
         }
     } // end condition update
 
-    // Request for condition to be pushed to graphics card
-    const bool useSubsetLoading = false;
-    if( useSubsetLoading )
-    {
-        m_textureManager->queueSubsetLoad2DByteTextureFromData( m_conditionTextureName,
-            m_tissueCondition,
-            m_N,
-            m_tissueConditionUpdateBounds.minX,
-            m_tissueConditionUpdateBounds.minY,
-            m_tissueConditionUpdateBounds.maxX,
-            m_tissueConditionUpdateBounds.maxY
-            );
-    }
-    else
-    {
-        m_textureManager->queueLoad2DByteTextureFromData( m_conditionTextureName, 
-                                                          m_tissueCondition, 
-                                                          m_N );
-    }
-    m_textureManager->queueLoad2DFloatTextureFromData( m_vaporizationDepthMapTextureName,
-        m_vaporizationDepthMap, 
-        m_N );
     ///////////////////////////////////////////////////////////////////////
     // Diffuse temperature by Fourier's law of thermal conduction
     // q = -k \nabla T
     const double a = 1e-8;//1e-5;//1e-7; // diffusion rate
     const double decayRate = 0.3;//1e-5f;//0.33f; // 1e-5f
     double k = dt * a / (m_diffusionIters * m_voxelDimMeters * m_voxelDimMeters );
-    if( k > 0.25 ) 
+    if( m_thermalSolver == ImplicitThermalSolver )
     {
-        LOG_WARN(g_log) << "Diffusion likely unstable";
-        k = 0.25;
+        // The 9-point stencil below, over 6 h^2, approximates the Laplacian,
+        // so its diffusivity is 6a.
+        diffuseTemperatureImplicit( (float)( 6.0 * k * m_diffusionIters ) );
     }
-    for( size_t iter = 0; iter < m_diffusionIters; ++iter )
+    else
     {
-        for( size_t y = 1; y < m_N-1; ++y )
+        if( k > 0.25 ) 
         {
-            for( size_t x = 1; x < m_N-1; ++x )
+            LOG_WARN(g_log) << "Diffusion likely unstable";
+            k = 0.25;
+        }
+        diffuseTemperature( m_diffusionIters, (float)k );
+    }
+    // and relax toward body temperature (perfusion), so untouched tissue
+    // rests at baseline.  Relaxing toward a uniform temperature commutes
+    // with diffusion, so one pass does as much as decaying every substep,
+    // and is large enough not to be lost to rounding.
+    const double decay = std::pow( 1.0 - decayRate * dt / m_diffusionIters, (double)m_diffusionIters );
+    coolUpdateTiles( (float)decay );
+
+    // Request for the changed tiles to be pushed to graphics card
+    // (no texture manager when running headless, e.g., in tests)
+    if( m_textureManager )
+    {
+        queueDirtyTileUploads();
+    }
+}
+
+void
+spark::TissueMesh
+::queueDirtyTileUploads( void )
+{
+    const std::vector< TextureTile > conditionTiles = takeDirtyTextureTiles( m_isConditionTileDirty );
+    m_textureManager->queueSubsetLoad2DByteTextureFromData( m_conditionTextureName,
+                                                            m_tissueCondition,
+                                                            m_N,
+                                                            conditionTiles );
+    const std::vector< TextureTile > depthTiles = takeDirtyTextureTiles( m_isDepthTileDirty );
+    m_textureManager->queueSubsetLoad2DFloatTextureFromData( m_vaporizationDepthMapTextureName,
+                                                             m_vaporizationDepthMap,
+                                                             m_N,
+                                                             depthTiles );
+    // Only the uploaded rows of the half float copy need be current
+    const std::vector< TextureTile > tempTiles = takeDirtyTextureTiles( m_isTempTileDirty );
+    const FluidKernels& kernels = fluidKernels();
+    for( size_t t = 0; t < tempTiles.size(); ++t )
+    {
+        const TextureTile& tile = tempTiles[t];
+        for( int y = tile.y; y < tile.y + tile.height; ++y )
+        {
+            const size_t i = index( tile.x, y );
+            kernels.floatToHalf( &m_tempHalfMap[i], &(*m_currTempMap)[i], tile.width );
+        }
+    }
+    m_textureManager->queueSubsetLoad2DHalfFloatTextureFromData( m_tempTextureName,
+                                                                 m_tempHalfMap,
+                                                                 m_N,
+                                                                 tempTiles );
+}
+
+std::vector< spark::TextureTile >
+spark::TissueMesh
+::takeDirtyTextureTiles( std::vector< unsigned char >& isDirty )
+{
+    std::vector< TextureTile > tiles;
+    for( size_t tile = 0; tile < isDirty.size(); ++tile )
+    {
+        if( !isDirty[tile] )
+        {
+            continue;
+        }
+        isDirty[tile] = 0;
+        size_t x0, y0, x1, y1;
+        tileBounds( tile, &x0, &y0, &x1, &y1 );
+        if( x0 == 1 ) x0 = 0;
+        if( y0 == 1 ) y0 = 0;
+        if( x1 == m_N-1 ) x1 = m_N;
+        if( y1 == m_N-1 ) y1 = m_N;
+        tiles.push_back( TextureTile( (int)x0, (int)y0, (int)( x1 - x0 ), (int)( y1 - y0 ) ) );
+    }
+    return tiles;
+}
+
+void
+spark::TissueMesh
+::diffuseTemperature( size_t iterations, float k )
+{
+    // See: Finite Difference Methods for Differential Equations, LeVeque
+    // Explicit euler w/9-pt Laplacian stencil
+    // Slowest, but fewest artifacts and explicit timestep
+    // Tiles outside m_updateTiles are at baseline in both maps, so they
+    // serve as fixed halo values and need not be written.
+    const size_t N = m_N;
+    for( size_t done = 0; done < iterations; )
+    {
+        const size_t steps = std::min( diffusionTileIterations, iterations - done );
+        const std::vector< float >& curr = *m_currTempMap;
+        std::vector< float >& next = *m_nextTempMap;
+        m_threadPool->parallelFor( 0, m_updateTiles.size(), [&]( size_t tileBegin, size_t tileEnd )
+        {
+            std::vector< float > a, b;
+            for( size_t t = tileBegin; t < tileEnd; ++t )
             {
-                ind = index(x,y);
+                // interior cells [x0,x1) x [y0,y1) of this tile
+                size_t x0, y0, x1, y1;
+                tileBounds( m_updateTiles[t], &x0, &y0, &x1, &y1 );
+                // the tile plus a halo of one cell per substep, or up to
+                // the boundary elements, which never change
+                const size_t ex0 = x0 > steps ? x0 - steps : 0;
+                const size_t ey0 = y0 > steps ? y0 - steps : 0;
+                const size_t ex1 = std::min( x1 + steps, N );
+                const size_t ey1 = std::min( y1 + steps, N );
+                const size_t w = ex1 - ex0;
+                a.resize( w * ( ey1 - ey0 ) );
+                for( size_t y = ey0; y < ey1; ++y )
+                {
+                    std::copy( &curr[index( ex0, y )], &curr[index( ex0, y )] + w, &a[w*( y - ey0 )] );
+                }
+                b = a;
+                for( size_t step = 0; step < steps; ++step )
+                {
+                    // cells whose neighbors are still valid after step substeps
+                    const size_t shrink = steps - 1 - step;
+                    const size_t rx0 = std::max( x0 > shrink ? x0 - shrink : 0, (size_t)1 );
+                    const size_t ry0 = std::max( y0 > shrink ? y0 - shrink : 0, (size_t)1 );
+                    const size_t rx1 = std::min( x1 + shrink, N-1 );
+                    const size_t ry1 = std::min( y1 + shrink, N-1 );
+                    for( size_t y = ry0; y < ry1; ++y )
+                    {
+                        const float* c = &a[w*( y - ey0 )];
+                        const float* up = c + w;
+                        const float* down = c - w;
+                        float* out = &b[w*( y - ey0 )];
+                        for( size_t x = rx0 - ex0; x < rx1 - ex0; ++x )
+                        {
+                            // Summed in pairs, so a uniform region sums
+                            // exactly to 20 c[x] and rests at baseline
+                            const float delta =
+                                k * ( 4.0f * ( ( c[x+1] + c[x-1] ) + ( up[x] + down[x] ) )
+                                      // Diagonals
+                                      + ( ( up[x+1] + up[x-1] ) + ( down[x+1] + down[x-1] ) )
+                                      - 20.0f * c[x] );
+                            out[x] = c[x] + delta;
+                        }
+                    }
+                    a.swap( b );
+                }
+                for( size_t y = y0; y < y1; ++y )
+                {
+                    std::copy( &a[w*( y - ey0 ) + x0 - ex0], &a[w*( y - ey0 ) + x1 - ex0], &next[index( x0, y )] );
+                }
+            }
+        } );
+        swapTempMaps();
+        done += steps;
+    }
+}
+
+void
+spark::TissueMesh
+::diffuseTemperatureImplicit( float r )
+{
+    // Backward Euler, split into one-dimensional solves along x then y
+    // (locally one-dimensional ADI).  Each line is the tridiagonal system
+    //   -r T'[i-1] + (1+2r) T'[i] - r T'[i+1] = T[i]
+    // with the elements just outside it as fixed values: the boundary
+    // elements, or baseline cells of tiles not being updated.  Every line
+    // has these coefficients, and the Thomas algorithm's elimination
+    // factors for a line are a prefix of those for the longest, so they
+    // are computed once.
+    const size_t N = m_N;
+    const size_t n = N - 2;
+    std::vector< float > inv( n );  // 1 / pivot of row i
+    std::vector< float > e( n );    // minus the eliminated superdiagonal
+    float previous = 0;
+    for( size_t i = 0; i < n; ++i )
+    {
+        inv[i] = 1.0f / ( 1.0f + 2.0f*r - r*previous );
+        e[i] = r * inv[i];
+        previous = e[i];
+    }
 
-                // See: Finite Difference Methods for Differential Equations, LeVeque
-
-                //////////////////
-                // SOR w/5-pt Laplacian stencil
-                //(*m_nextTempMap)[ind] = (1.0 - m_SORovershoot) * (*m_currTempMap)[ind]
-                //+ ( a * m_SORovershoot / (4.0f) )
-                //* ( (*m_currTempMap)[index(x+1,y)]
-                //   + (*m_nextTempMap)[index(x-1,y)]
-                //   + (*m_currTempMap)[index(x,y+1)]
-                //   + (*m_nextTempMap)[index(x,y-1)]
-                //   );
-
-                //////////////////
-                // Explicit euler w/5-pt Laplacian stencil
-                //float delta = 
-                //    ( dt * a / (m_diffusionIters * m_voxelDimMeters * m_voxelDimMeters) )
-                //    * (  (*m_currTempMap)[index(x+1,y)]
-                //       + (*m_nextTempMap)[index(x-1,y)]
-                //       + (*m_currTempMap)[index(x,y+1)]
-                //       + (*m_nextTempMap)[index(x,y-1)]
-                //       - (4.0f*(*m_currTempMap)[index(x,y)])
-                //      );
-                //(*m_nextTempMap)[ind] = (*m_currTempMap)[ind]
-                //    + delta 
-                //    - ( decayRate * dt * (*m_currTempMap)[ind] )
-                //   ;
-
-                //////////////////
-                // Explicit euler w/9-pt Laplacian stencil
-                // Slowest, but fewest artifacts and explicit timestep
-                //double delta =
-                //    k * ( 4.0f* ( (*m_currTempMap)[index(x+1,y)]
-                //                + (*m_currTempMap)[index(x-1,y)]
-                //                + (*m_currTempMap)[index(x,y+1)]
-                //                + (*m_currTempMap)[index(x,y-1)] 
-                //                )
-                //                // Diagonals
-                //                + (*m_currTempMap)[index(x+1,y+1)]
-                //                + (*m_currTempMap)[index(x+1,y-1)]
-                //                + (*m_currTempMap)[index(x-1,y+1)]
-                //                + (*m_currTempMap)[index(x-1,y-1)]
-                //                - (20.0f* (*m_currTempMap)[ind])
-                //    );
-                //(*m_nextTempMap)[ind] = (*m_currTempMap)[ind]
-                //    + delta 
-                //        - ( decayRate * dt * (*m_currTempMap)[ind] )
-                //        ;
-
-                // Same, but replacing index calls
-                double delta =
-                    k * ( 4.0f* ( (*m_currTempMap)[ind+1]
-                + (*m_currTempMap)[ind-1]
-                + (*m_currTempMap)[ind+m_N]
-                + (*m_currTempMap)[ind-m_N] 
-                )
-                    // Diagonals
-                    + (*m_currTempMap)[ind+1+m_N]
-                + (*m_currTempMap)[ind+1-m_N]
-                + (*m_currTempMap)[ind-1+m_N]
-                + (*m_currTempMap)[ind-1-m_N]
-                - (20.0f* (*m_currTempMap)[ind])
-                    );
-                (*m_nextTempMap)[ind] = (*m_currTempMap)[ind]
-                + delta 
-                    - ( decayRate * dt * (*m_currTempMap)[ind] )
-                    ;
+    // Runs of consecutive update tiles along each row, and each column, of tiles
+    std::vector< TileRun > rowRuns, columnRuns;
+    std::vector< unsigned char > isUpdated( m_tilesPerSide * m_tilesPerSide, 0 );
+    for( size_t t = 0; t < m_updateTiles.size(); ++t )
+    {
+        isUpdated[m_updateTiles[t]] = 1;
+    }
+    for( size_t line = 0; line < m_tilesPerSide; ++line )
+    {
+        for( size_t along = 0; along < m_tilesPerSide; )
+        {
+            size_t first = along;
+            while( first < m_tilesPerSide && !isUpdated[first + m_tilesPerSide*line] ) ++first;
+            size_t last = first;
+            while( last < m_tilesPerSide && isUpdated[last + m_tilesPerSide*line] ) ++last;
+            if( first < last )
+            {
+                TileRun run;
+                size_t x1, y1;
+                tileBounds( first + m_tilesPerSide*line, &run.begin, &run.lineBegin, &x1, &y1 );
+                tileBounds( last-1 + m_tilesPerSide*line, &x1, &y1, &run.end, &run.lineEnd );
+                rowRuns.push_back( run );
+            }
+            along = last;
+        }
+        for( size_t along = 0; along < m_tilesPerSide; )
+        {
+            size_t first = along;
+            while( first < m_tilesPerSide && !isUpdated[line + m_tilesPerSide*first] ) ++first;
+            size_t last = first;
+            while( last < m_tilesPerSide && isUpdated[line + m_tilesPerSide*last] ) ++last;
+            if( first < last )
+            {
+                TileRun run;
+                size_t x1, y1;
+                tileBounds( line + m_tilesPerSide*first, &run.lineBegin, &run.begin, &x1, &y1 );
+                tileBounds( line + m_tilesPerSide*(last-1), &x1, &y1, &run.lineEnd, &run.end );
+                columnRuns.push_back( run );
+            }
+            along = last;
+        }
+    }
+
+    std::vector< float >& T = *m_currTempMap;
+    m_threadPool->parallelFor( 0, rowRuns.size(), [&]( size_t runBegin, size_t runEnd )
+    {
+        for( size_t runIndex = runBegin; runIndex < runEnd; ++runIndex )
+        {
+            const TileRun& run = rowRuns[runIndex];
+            const size_t length = run.end - run.begin;
+            for( size_t y = run.lineBegin; y < run.lineEnd; ++y )
+            {
+                float* row = &T[index( run.begin, y )];
+                // forward elimination, starting from the element to the left
+                float d = row[-1];
+                for( size_t i = 0; i < length; ++i )
+                {
+                    const float rhs = row[i] + ( i == length-1 ? r * row[length] : 0.0f );
+                    d = ( rhs + r*d ) * inv[i];
+                    row[i] = d;
+                }
+                for( size_t i = length-1; i-- > 0; )
+                {
+                    row[i] += e[i] * row[i+1];
+                }
+            }
+        }
+    } );
+    // Columns a row at a time, so the inner loops are contiguous
+    m_threadPool->parallelFor( 0, columnRuns.size(), [&]( size_t runBegin, size_t runEnd )
+    {
+        for( size_t runIndex = runBegin; runIndex < runEnd; ++runIndex )
+        {
+            const TileRun& run = columnRuns[runIndex];
+            for( size_t y = run.begin; y < run.end; ++y )
+            {
+                float* row = &T[index( 0, y )];
+                const float* below = row - N;
+                const float* above = row + N;
+                const float boundary = ( y == run.end-1 ? r : 0.0f );
+                const float pivot = inv[y - run.begin];
+                for( size_t x = run.lineBegin; x < run.lineEnd; ++x )
+                {
+                    row[x] = ( row[x] + boundary * above[x] + r * below[x] ) * pivot;
+                }
+            }
+            for( size_t y = run.end-1; y-- > run.begin; )
+            {
+                float* row = &T[index( 0, y )];
+                const float* above = row + N;
+                const float factor = e[y - run.begin];
+                for( size_t x = run.lineBegin; x < run.lineEnd; ++x )
+                {
+                    row[x] += factor * above[x];
+                }
             }
         }
-    } // End diffusion
+    } );
+}
 
- 
+void
+spark::TissueMesh
+::tileBounds( size_t tile, size_t* x0, size_t* y0, size_t* x1, size_t* y1 ) const
+{
+    *x0 = 1 + ( tile % m_tilesPerSide ) * tileSize;
+    *y0 = 1 + ( tile / m_tilesPerSide ) * tileSize;
+    *x1 = std::min( *x0 + tileSize, m_N-1 );
+    *y1 = std::min( *y0 + tileSize, m_N-1 );
+}
 
-    // push temp data to graphics card
+size_t
+spark::TissueMesh
+::tileFromIndex( size_t ind ) const
+{
+    const size_t x = std::min( std::max( ind % m_N, (size_t)1 ), m_N-2 );
+    const size_t y = std::min( std::max( ind / m_N, (size_t)1 ), m_N-2 );
+    return ( x - 1 ) / tileSize + m_tilesPerSide * ( ( y - 1 ) / tileSize );
+}
 
-    //m_textureManager->queueLoad2DFloatTextureFromData( m_tempTextureName, *m_nextTempMap, m_N );
-    swapTempMaps();
+void
+spark::TissueMesh
+::gatherUpdateTiles( void )
+{
+    m_updateTiles.clear();
+    for( size_t ty = 0; ty < m_tilesPerSide; ++ty )
+    {
+        for( size_t tx = 0; tx < m_tilesPerSide; ++tx )
+        {
+            // this tile or any of its eight neighbors
+            const size_t nx0 = tx > 0 ? tx - 1 : 0;
+            const size_t ny0 = ty > 0 ? ty - 1 : 0;
+            const size_t nx1 = std::min( tx + 2, m_tilesPerSide );
+            const size_t ny1 = std::min( ty + 2, m_tilesPerSide );
+            bool isNeeded = false;
+            for( size_t ny = ny0; ny < ny1 && !isNeeded; ++ny )
+            {
+                for( size_t nx = nx0; nx < nx1 && !isNeeded; ++nx )
+                {
+                    const size_t neighbor = nx + m_tilesPerSide*ny;
+                    isNeeded = m_isTileActive[neighbor] || m_isTileHeated[neighbor];
+                }
+            }
+            if( isNeeded )
+            {
+                m_updateTiles.push_back( tx + m_tilesPerSide*ty );
+            }
+        }
+    }
+    std::fill( m_isTileHeated.begin(), m_isTileHeated.end(), 0 );
+}
+
+void
+spark::TissueMesh
+::coolUpdateTiles( float decay )
+{
+    // Deviations too small for decay to change in float are at baseline
+    const float epsilon = decay < 1.0f
+        ? std::max( baselineEpsilon, std::numeric_limits< float >::epsilon() * baselineTemp / ( 1.0f - decay ) )
+        : baselineEpsilon;
+    std::vector< float >& curr = *m_currTempMap;
+    std::vector< float >& next = *m_nextTempMap;
+    m_threadPool->parallelFor( 0, m_updateTiles.size(), [&]( size_t tileBegin, size_t tileEnd )
+    {
+        for( size_t t = tileBegin; t < tileEnd; ++t )
+        {
+            size_t x0, y0, x1, y1;
+            tileBounds( m_updateTiles[t], &x0, &y0, &x1, &y1 );
+            bool isActive = false;
+            for( size_t y = y0; y < y1; ++y )
+            {
+                for( size_t x = x0; x < x1; ++x )
+                {
+                    const size_t i = index( x, y );
+                    curr[i] = baselineTemp + decay * ( curr[i] - baselineTemp );
+                    isActive = isActive
+                               || std::abs( curr[i] - baselineTemp ) > epsilon
+                               || m_tissueCondition[i] == vaporizingTissue
+                               || m_tissueCondition[i] == vaporizedTissue;
+                }
+            }
+            if( !isActive )
+            {
+                // Snap to baseline, in both maps, so skipping it is exact
+                for( size_t y = y0; y < y1; ++y )
+                {
+                    std::fill( &curr[index( x0, y )], &curr[index( x1, y )], baselineTemp );
+                    std::fill( &next[index( x0, y )], &next[index( x1, y )], baselineTemp );
+                }
+            }
+            m_isTileActive[m_updateTiles[t]] = isActive;
+        }
+    } );
+}
+
+void
+spark::TissueMesh
+::setThreadCount( unsigned int threadCount )
+{
+    m_threadCount = threadCount ? threadCount : ThreadPool::hardwareThreadCount();
 }
 
 void
@@ -262,6 +595,7 @@ spark::TissueMesh
 {
     size_t centerIndex = indexFromXY( x, y );
     m_heatMap[centerIndex] += heatInJoules;
+    m_isTileHeated[tileFromIndex( centerIndex )] = 1;
     if( heatInJoules > 1e6 )
     {
         assert(false);
@@ -276,44 +610,129 @@ spark::TissueMesh
                               float radiusOfContact,
                               float dt )
 {
-    // potentially wasteful, but touch every voxel is an easy way to 
-    // capture the full heating effect
-    int ind = 0;
-    glm::vec2 center( posx, posy );
-    glm::vec2 cellPos;
-    float cellX = 0;
-    float cellY = 0;
-    float distCellToContactCenter2;
-    float distCellToContactCenter;
-    float radiusOfContact2 = radiusOfContact*radiusOfContact;
-    float areaOfContact = M_PI*radiusOfContact2;
-    float currentDensity2 = current*current / areaOfContact;
-    float unitsFactor = 1e-10;
-    for( size_t y = 1; y < m_N-1; ++y )
+    updateFalloffTable( radiusOfContact );
+    depositElectricalEnergy( posx, posy, electricalUnitsFactor * current * current * dt );
+}
+
+void 
+spark::TissueMesh
+::accumulateElectricalEnergy( const std::vector< glm::vec2 >& contacts,
+                              float /*voltage*/,
+                              float current,
+                              float /*dutyCycle*/,
+                              float radiusOfContact,
+                              float dt )
+{
+    if( contacts.empty() )
+    {
+        return;
+    }
+    updateFalloffTable( radiusOfContact );
+    const float scale = electricalUnitsFactor * current * current * dt / contacts.size();
+    for( size_t c = 0; c < contacts.size(); ++c )
     {
-        for( size_t x = 1; x < m_N-1; ++x )
+        depositElectricalEnergy( contacts[c].x, contacts[c].y, scale );
+    }
+}
+
+void
+spark::TissueMesh
+::updateFalloffTable( float radiusOfContact )
+{
+    if( radiusOfContact == m_falloffRadius )
+    {
+        return;
+    }
+    m_falloffRadius = radiusOfContact;
+    const double R = std::max( radiusOfContact, 0.0f );
+    const double h = m_voxelDimMeters;
+    // Inside the contact, elements share the current density squared,
+    // 1/(pi R^2); outside, the surface effect dissipates with the cube of
+    // the distance u from the edge, clamped to half a cell so elements
+    // just outside the edge stay finite.
+    //
+    // Over the plane, the elements beyond u hold
+    //   integral_u^inf 2 pi (R+t) / t^3 dt / h^2 = 2 pi ( 1/u + R/(2 u^2) ) / h^2
+    // and those from the clamp out at least that for u = h/2, plus 1/h^2
+    // inside.  Cut off where the first is falloffTailFraction of the second.
+    const double u0 = h / 2.0;
+    const double c = falloffTailFraction * ( 1.0/u0 + R/( 2.0*u0*u0 ) + 1.0/( 2.0*M_PI ) );
+    // solve (R/2) v^2 + v = c for v = 1/u
+    const double v = R > 0 ? ( std::sqrt( 1.0 + 2.0*R*c ) - 1.0 ) / R : c;
+    const double cutoff = ( R + 1.0/v ) / h;
+    m_falloffCutoff2 = (float)( cutoff * cutoff );
+
+    // enough samples that interpolating at the cutoff stays in the table
+    m_falloffTable.resize( (size_t)( m_falloffCutoff2 * falloffSamplesPerCell2 ) + 3 );
+    for( size_t i = 0; i < m_falloffTable.size(); ++i )
+    {
+        const double r = h * std::sqrt( i / falloffSamplesPerCell2 );
+        if( r < R )
         {
-            ind = index(x,y);
-            indexToPosition( ind, &cellX, &cellY );
-            cellPos.x = cellX - center.x;
-            cellPos.y = cellY - center.y;
-            distCellToContactCenter2 = glm::dot( cellPos, cellPos );
-            distCellToContactCenter = std::sqrt( distCellToContactCenter2 );
-            // are we inside the direct contact radius?
-            if( distCellToContactCenter2 < radiusOfContact2 )
-            {
-                m_heatMap[ind] += unitsFactor * currentDensity2 * dt;
-            }
-            else
-            {
-                // surface effect is dissipating with the cube of distance
-                float d = distCellToContactCenter - radiusOfContact;
-                float invDist3 = 1.0f / (d*d*d);
-                {
-                    float localCurrDensity2 = (current*current);// / (m_voxelDimMeters*m_voxelDimMeters);
-                    m_heatMap[ind] += unitsFactor * localCurrDensity2 * dt * invDist3;
-                }
-            }
+            m_falloffTable[i] = (float)( 1.0 / ( M_PI * R * R ) );
+        }
+        else
+        {
+            const double u = std::max( r - R, u0 );
+            m_falloffTable[i] = (float)( 1.0 / ( u*u*u ) );
+        }
+    }
+}
+
+void
+spark::TissueMesh
+::depositElectricalEnergy( float x, float y, float scale )
+{
+    // contact center in cells, the inverse of indexToPosition()
+    const float cx = x / m_voxelDimMeters + m_N/2.0f - 0.5f;
+    const float cy = y / m_voxelDimMeters + m_N/2.0f - 0.5f;
+    const float cutoff = std::sqrt( m_falloffCutoff2 );
+    if(    cx + cutoff < 1.0f || cx - cutoff > m_N-2.0f
+        || cy + cutoff < 1.0f || cy - cutoff > m_N-2.0f )
+    {
+        return;
+    }
+    const int y0 = std::max( (int)std::ceil( cy - cutoff ), 1 );
+    const int y1 = std::min( (int)std::floor( cy + cutoff ), (int)m_N-2 );
+    int minX = (int)m_N;
+    int maxX = 0;
+    const float* table = &m_falloffTable[0];
+    for( int yi = y0; yi <= y1; ++yi )
+    {
+        const float dy = yi - cy;
+        const float dy2 = dy*dy;
+        if( dy2 > m_falloffCutoff2 )
+        {
+            continue;
+        }
+        // elements of this row within the cutoff
+        const float halfWidth = std::sqrt( m_falloffCutoff2 - dy2 );
+        const int x0 = std::max( (int)std::ceil( cx - halfWidth ), 1 );
+        const int x1 = std::min( (int)std::floor( cx + halfWidth ), (int)m_N-2 );
+        double* row = &m_heatMap[index( 0, yi )];
+        // Branch-free, so it vectorizes (with gathers where available)
+        for( int xi = x0; xi <= x1; ++xi )
+        {
+            const float dx = xi - cx;
+            const float sample = ( dx*dx + dy2 ) * falloffSamplesPerCell2;
+            const int i = (int)sample;
+            const float weight = table[i] + ( sample - i ) * ( table[i+1] - table[i] );
+            row[xi] += scale * weight;
+        }
+        minX = std::min( minX, x0 );
+        maxX = std::max( maxX, x1 );
+    }
+    if( minX > maxX )
+    {
+        return;
+    }
+    for( size_t ty = tileFromIndex( index( 0, y0 ) ) / m_tilesPerSide;
+         ty <= tileFromIndex( index( 0, y1 ) ) / m_tilesPerSide; ++ty )
+    {
+        for( size_t tx = tileFromIndex( index( minX, 1 ) );
+             tx <= tileFromIndex( index( maxX, 1 ) ); ++tx )
+        {
+            m_isTileHeated[tx + m_tilesPerSide*ty] = 1;
         }
     }
 }
@@ -387,19 +806,29 @@ spark::TissueMesh
 
 void 
 spark::TissueMesh
-::acquireVaporizingLocations( std::vector<glm::vec2>& vaping )
+::acquireVaporizingLocations( std::vector<glm::vec2>& vaping,
+                              size_t maxLocations ) const
 {
-    float x = 0; float y = 0;
-    for( size_t i = 0; 
-         (i < m_tissueCondition.size()) && vaping.size() < 32; // max # of cells vaping 
-         ++i )
+    // A cell vaporizes for one update, so the cells vaporizing now are
+    // those that started in the last one.
+    std::vector< size_t > cells;
+    for( size_t e = 0; e < m_conditionEvents.size(); ++e )
     {
-        if( m_tissueCondition[i] == vaporizingTissue )
+        if( m_conditionEvents[e].newCondition == vaporizingTissue )
         {
-            indexToPosition( i, &x, &y );
-            vaping.push_back( glm::vec2( x, y ) );
+            cells.push_back( m_conditionEvents[e].index );
         }
     }
+    // Events run through each tile a row at a time, so taking every
+    // stride-th one spreads the locations over the vaporizing region.
+    const size_t count = std::min( cells.size(), maxLocations );
+    const double stride = (double)cells.size() / (double)std::max( count, (size_t)1 );
+    float x = 0; float y = 0;
+    for( size_t i = 0; i < count; ++i )
+    {
+        indexToPosition( cells[ (size_t)( ( i + 0.5 ) * stride ) ], &x, &y );
+        vaping.push_back( glm::vec2( x, y ) );
+    }
 }
 
 size_t 
@@ -0,0 +1,115 @@
+#include "WeightedSampler.hpp"
+
+namespace
+{
+    size_t lowbit( size_t k ) { return k & ( ~k + 1 ); }
+}
+
+spark::WeightedSampler
+::WeightedSampler( void )
+: m_tree( 1, 0.0 )
+{
+}
+
+void
+spark::WeightedSampler
+::assign( const std::vector< float >& weights )
+{
+    m_weights = weights;
+    m_tree.assign( weights.size() + 1, 0.0 );
+    for( size_t k = 1; k <= weights.size(); ++k )
+    {
+        m_tree[k] += weights[k-1];
+        const size_t parent = k + lowbit( k );
+        if( parent <= weights.size() )
+        {
+            m_tree[parent] += m_tree[k];
+        }
+    }
+}
+
+void
+spark::WeightedSampler
+::clear( void )
+{
+    m_weights.clear();
+    m_tree.assign( 1, 0.0 );
+}
+
+double
+spark::WeightedSampler
+::total( void ) const
+{
+    return prefixSum( m_weights.size() );
+}
+
+void
+spark::WeightedSampler
+::set( size_t i, float weight )
+{
+    const double delta = (double)weight - (double)m_weights[i];
+    m_weights[i] = weight;
+    for( size_t k = i + 1; k <= m_weights.size(); k += lowbit( k ) )
+    {
+        m_tree[k] += delta;
+    }
+}
+
+void
+spark::WeightedSampler
+::pushBack( float weight )
+{
+    const size_t k = m_weights.size() + 1;
+    m_weights.push_back( weight );
+    m_tree.push_back( weight + prefixSum( k - 1 ) - prefixSum( k - lowbit( k ) ) );
+}
+
+void
+spark::WeightedSampler
+::popBack( void )
+{
+    // No other node covers the last item
+    m_weights.pop_back();
+    m_tree.pop_back();
+}
+
+size_t
+spark::WeightedSampler
+::sample( double u ) const
+{
+    const size_t n = m_weights.size();
+    double remaining = u * total();
+    size_t step = 1;
+    while( step * 2 <= n ) step *= 2;
+    size_t count = 0;
+    for( ; step > 0; step /= 2 )
+    {
+        if( count + step <= n && m_tree[count + step] <= remaining )
+        {
+            count += step;
+            remaining -= m_tree[count];
+        }
+    }
+    // The item at count takes remaining past its weight, so it has
+    // weight, unless rounding left u * total() past the last item
+    if( count == n )
+    {
+        do
+        {
+            --count;
+        } while( count > 0 && m_weights[count] <= 0.0f );
+    }
+    return count;
+}
+
+double
+spark::WeightedSampler
+::prefixSum( size_t count ) const
+{
+    double sum = 0.0;
+    for( size_t k = count; k > 0; k -= lowbit( k ) )
+    {
+        sum += m_tree[k];
+    }
+    return sum;
+}
@@ -10,8 +10,7 @@
 #include "SlicedVolume.hpp"
 #include "RayCastVolume.hpp"
 #include "Fluid.hpp"
-
-#include <cstdlib>  // tmp for rand
+#include "Random.hpp"
 
 spark::SimulationState
 ::SimulationState( const RenderableName& name, SceneFacadePtr facade )
@@ -167,8 +166,9 @@ spark::SimulationState
 ::update( double dt )
 {
     // random starting position
-    static float x = rand()/(float)RAND_MAX;
-    static float y = rand()/(float)RAND_MAX;
+    static Random random;
+    static float x = random.uniform();
+    static float y = random.uniform();
     //float joules;
     
     //// get current wattage from network
@@ -180,8 +180,8 @@ spark::SimulationState
     //for( int i = 0; i < numContactElems; ++i )
     //{
     //    // random walk
-    //    x += 0.005 * rand()/(float)RAND_MAX - 0.0025;
-    //    y += 0.005 * rand()/(float)RAND_MAX - 0.0025;
+    //    x += random.uniform( -0.0025f, 0.0025f );
+    //    y += random.uniform( -0.0025f, 0.0025f );
     //    x = std::min( x, extent );
     //    x = std::max( x, -extent );
     //    y = std::min( y, extent );
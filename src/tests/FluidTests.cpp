@@ -0,0 +1,1007 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "SoftTestDeclarations.hpp"
+#include "FluidKernels.hpp"
+#include "Fluid.hpp"
+#include "MultigridSolver.hpp"
+#include "TripleBuffer.hpp"
+#include "FluidRecorder.hpp"
+#include "Exceptions.hpp"
+
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
+#include <boost/cstdint.hpp>
+
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <cstdlib>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <string>
+
+using namespace spark;
+
+namespace spark
+{
+    /// Runs Fluid's private Gauss-Seidel solvers on caller-owned fields
+    /// laid out as Fluid::index().
+    struct FluidSolverTestAccess
+    {
+        static void linearSolve( Fluid& fluid, float* x, float* x_prev, float a, float c )
+        {
+            fluid.linearSolve( 0, x, x_prev, a, c );
+        }
+        static void linearSolveSlow( Fluid& fluid, float* x, float* x_prev, float a, float c )
+        {
+            fluid.linearSolveSlow( 0, x, x_prev, a, c );
+        }
+    };
+}
+
+namespace
+{
+    const size_t dim = 21;  // odd so rows don't start on a vector boundary
+    const size_t dim2 = dim*dim;
+    const size_t size = dim*dim*dim;
+    const float tolerance = 1e-4f;
+
+    std::vector< float > randomField( unsigned int seed, float scale )
+    {
+        std::srand( seed );
+        std::vector< float > field( size );
+        for( size_t i = 0; i < size; ++i )
+        {
+            field[i] = scale * ( (float)std::rand() / RAND_MAX - 0.5f );
+        }
+        return field;
+    }
+
+    float maxDifference( const std::vector< float >& a, const std::vector< float >& b )
+    {
+        float maxDiff = 0;
+        for( size_t i = 0; i < a.size(); ++i )
+        {
+            maxDiff = std::max( maxDiff, std::abs( a[i] - b[i] ) );
+        }
+        return maxDiff;
+    }
+
+    /// Run every kernel of both sets over the interior rows of random
+    /// fields and check that the results agree.
+    void compareKernels( const FluidKernels& test, const FluidKernels& reference )
+    {
+        BOOST_TEST_MESSAGE( "Comparing " << test.name << " to " << reference.name );
+        const size_t n = dim - 2;
+        const std::vector< float > u = randomField( 1, 2.0f );
+        const std::vector< float > v = randomField( 2, 2.0f );
+        const std::vector< float > w = randomField( 3, 2.0f );
+        const std::vector< float > s = randomField( 4, 10.0f );
+
+        // relax, both colors
+        std::vector< float > xTest = s, xRef = s;
+        for( size_t first = 0; first < 2; ++first )
+        {
+            for( size_t k = 1; k <= n; ++k )
+            {
+                for( size_t j = 1; j <= n; ++j )
+                {
+                    const size_t ind0 = 1 + dim*j + dim2*k;
+                    test.relaxRow( &xTest[0], &u[0], ind0, n, first, dim, dim2, 0.3f, 1.0f/2.8f );
+                    reference.relaxRow( &xRef[0], &u[0], ind0, n, first, dim, dim2, 0.3f, 1.0f/2.8f );
+                }
+            }
+        }
+        BOOST_CHECK_SMALL( maxDifference( xTest, xRef ), tolerance );
+
+        // advect, with velocities large enough to hit the clamped edges
+        std::vector< float > dTest( size, 0.0f ), dRef( size, 0.0f );
+        const float maxCoord = n + 0.5f;
+        for( size_t k = 1; k <= n; ++k )
+        {
+            for( size_t j = 1; j <= n; ++j )
+            {
+                const size_t ind0 = 1 + dim*j + dim2*k;
+                test.advectRow( &dTest[0], &s[0], &u[0], &v[0], &w[0], ind0, n,
+                                1.0f, (float)j, (float)k, dim, dim2, 3.0f,
+                                maxCoord, maxCoord, maxCoord );
+                reference.advectRow( &dRef[0], &s[0], &u[0], &v[0], &w[0], ind0, n,
+                                     1.0f, (float)j, (float)k, dim, dim2, 3.0f,
+                                     maxCoord, maxCoord, maxCoord );
+            }
+        }
+        BOOST_CHECK_SMALL( maxDifference( dTest, dRef ), tolerance );
+
+        // vorticity confinement, with the field s as the magnitude
+        std::vector< float > wxTest( size, 0.0f ), wyTest( size, 0.0f ), wzTest( size, 0.0f ), magTest( size, 0.0f );
+        std::vector< float > wxRef( size, 0.0f ), wyRef( size, 0.0f ), wzRef( size, 0.0f ), magRef( size, 0.0f );
+        std::vector< float > fxTest( size, 0.0f ), fyTest( size, 0.0f ), fzTest( size, 0.0f );
+        std::vector< float > fxRef( size, 0.0f ), fyRef( size, 0.0f ), fzRef( size, 0.0f );
+        // a flat magnitude exercises the normalize epsilon
+        std::vector< float > flat( size, 1.0f ), fxFlat( size, 1.0f );
+        for( size_t k = 1; k <= n; ++k )
+        {
+            for( size_t j = 1; j <= n; ++j )
+            {
+                const size_t ind0 = 1 + dim*j + dim2*k;
+                test.vorticityRow( &wxTest[0], &wyTest[0], &wzTest[0], &magTest[0],
+                                   &u[0], &v[0], &w[0], ind0, n, dim, dim2, 0.1f );
+                reference.vorticityRow( &wxRef[0], &wyRef[0], &wzRef[0], &magRef[0],
+                                        &u[0], &v[0], &w[0], ind0, n, dim, dim2, 0.1f );
+                // the slice pointers are offset by -dim2, so shift everything to match
+                const size_t o = dim2;
+                test.confinementRow( &fxTest[o], &fyTest[o], &fzTest[o],
+                                     &s[0], &s[o], &s[2*o], &u[o], &v[o], &w[o],
+                                     ind0 - o, n, dim, 0.1f, 5.0f );
+                reference.confinementRow( &fxRef[o], &fyRef[o], &fzRef[o],
+                                          &s[0], &s[o], &s[2*o], &u[o], &v[o], &w[o],
+                                          ind0 - o, n, dim, 0.1f, 5.0f );
+                test.confinementRow( &fxFlat[o], &fxFlat[o], &fxFlat[o],
+                                     &flat[0], &flat[o], &flat[2*o], &u[o], &v[o], &w[o],
+                                     ind0 - o, n, dim, 0.1f, 5.0f );
+            }
+        }
+        BOOST_CHECK_SMALL( maxDifference( wxTest, wxRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( wyTest, wyRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( wzTest, wzRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( magTest, magRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( fxTest, fxRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( fyTest, fyRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( fzTest, fzRef ), tolerance );
+        for( size_t k = 1; k <= n; ++k )
+        {
+            for( size_t j = 1; j <= n; ++j )
+            {
+                for( size_t i = 1; i <= n; ++i )
+                {
+                    BOOST_CHECK_EQUAL( fxFlat[i + dim*j + dim2*k], 0.0f );
+                }
+            }
+        }
+
+        // velocity samples, an odd count to leave a tail, some outside the grid
+        const size_t points = 301;
+        std::vector< float > xyz( 3*points );
+        for( size_t p = 0; p < 3*points; ++p )
+        {
+            xyz[p] = s[p] * 0.15f;
+        }
+        std::vector< float > velTest( 3*points ), velRef( 3*points );
+        test.sampleVelocity( &velTest[0], &xyz[0], points, &u[0], &v[0], &w[0],
+                             dim, dim2, 2.0f*n, 0.5f*(n+1), 0.5f*(n+1), 0.5f*(n+1),
+                             maxCoord, maxCoord, maxCoord );
+        reference.sampleVelocity( &velRef[0], &xyz[0], points, &u[0], &v[0], &w[0],
+                                  dim, dim2, 2.0f*n, 0.5f*(n+1), 0.5f*(n+1), 0.5f*(n+1),
+                                  maxCoord, maxCoord, maxCoord );
+        BOOST_CHECK_SMALL( maxDifference( velTest, velRef ), tolerance );
+
+        // half floats, including ties, subnormals and out of range values
+        std::vector< float > values( s.begin(), s.begin() + 301 );
+        const float special[] = { 0.0f, -0.0f, 1.0f, 65504.0f, 65519.0f, 65520.0f, 1e6f,
+                                  6.1035156e-5f, 3.0e-5f, 2.9802322e-8f, 1.0e-8f,
+                                  1.0f + 1.0f/2048, 1.0f + 3.0f/2048 };
+        values.insert( values.end(), special, special + sizeof( special ) / sizeof( special[0] ) );
+        std::vector< unsigned short > halfTest( values.size() ), halfRef( values.size() );
+        test.floatToHalf( &halfTest[0], &values[0], values.size() );
+        reference.floatToHalf( &halfRef[0], &values[0], values.size() );
+        BOOST_CHECK( halfTest == halfRef );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( FluidSuite )
+
+BOOST_AUTO_TEST_CASE( FluidKernels_SSEMatchesScalar )
+{
+    const FluidKernels* sse = sseFluidKernels();
+    if( !sse )
+    {
+        BOOST_TEST_MESSAGE( "SSE2 kernels not available, skipping." );
+        return;
+    }
+    compareKernels( *sse, scalarFluidKernels() );
+}
+
+BOOST_AUTO_TEST_CASE( FluidKernels_AVX2MatchesScalar )
+{
+    const FluidKernels* avx2 = avx2FluidKernels();
+    if( !avx2 )
+    {
+        BOOST_TEST_MESSAGE( "AVX2 kernels not supported by this CPU, skipping." );
+        return;
+    }
+    compareKernels( *avx2, scalarFluidKernels() );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_DispatchedKernelsMatchScalar )
+{
+    const int n = 18;
+    Fluid fast( n );
+    Fluid reference( n );
+    reference.setKernels( scalarFluidKernels() );
+    BOOST_TEST_MESSAGE( "Fluid kernels: " << fast.getKernelName() );
+    for( int step = 0; step < 5; ++step )
+    {
+        fast.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        reference.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        fast.update( 0.1 );
+        reference.update( 0.1 );
+    }
+    const float* fastDensity = fast.getDensityData();
+    const float* referenceDensity = reference.getDensityData();
+    float maxDiff = 0;
+    for( int i = 0; i < n*n*n; ++i )
+    {
+        maxDiff = std::max( maxDiff, std::abs( fastDensity[i] - referenceDensity[i] ) );
+    }
+    BOOST_CHECK_SMALL( maxDiff, 1e-3f );
+}
+
+BOOST_AUTO_TEST_CASE( MultigridSolver_ConvergesForOddAndEvenSizes )
+{
+    ThreadPool pool( 2 );
+    // cubes of odd and even sizes, then anisotropic grids
+    const size_t sizes[][3] = { { 16, 16, 16 }, { 23, 23, 23 }, { 40, 40, 40 },
+                                { 12, 30, 12 }, { 30, 17, 9 } };
+    for( size_t s = 0; s < 5; ++s )
+    {
+        const size_t Nx = sizes[s][0], Ny = sizes[s][1], Nz = sizes[s][2];
+        const size_t dy = Nx + 2;
+        const size_t dz = dy * (Ny + 2);
+        std::vector< float > b( dz*(Nz + 2), 0.0f );
+        std::vector< float > x( dz*(Nz + 2), 0.0f );
+        std::srand( 7 );
+        for( size_t k = 1; k <= Nz; ++k )
+            for( size_t j = 1; j <= Ny; ++j )
+                for( size_t i = 1; i <= Nx; ++i )
+                    b[i + dy*j + dz*k] = (float)std::rand() / RAND_MAX - 0.5f;
+
+        MultigridSolver solver( Nx, Ny, Nz );
+        const unsigned int iterations = solver.solve( &x[0], &b[0], 1e-4f, 50, pool, fluidKernels() );
+        BOOST_TEST_MESSAGE( "N=" << Nx << "x" << Ny << "x" << Nz << " levels=" << solver.levelCount()
+            << " iterations=" << iterations << " residual=" << solver.getResidual() );
+        BOOST_CHECK_LE( solver.getResidual(), 1e-4f );
+        BOOST_CHECK_LE( iterations, 15u );
+
+        // independently check the residual, including the y=0 Neumann face
+        double r2 = 0, b2 = 0;
+        for( size_t k = 1; k <= Nz; ++k )
+            for( size_t j = 1; j <= Ny; ++j )
+                for( size_t i = 1; i <= Nx; ++i )
+                {
+                    const size_t ind = i + dy*j + dz*k;
+                    const float below = ( j == 1 ) ? x[ind] : x[ind-dy];
+                    const float r = b[ind] - ( 6.0f*x[ind] - ( x[ind-1] + x[ind+1]
+                        + below + x[ind+dy] + x[ind-dz] + x[ind+dz] ) );
+                    r2 += r*r;
+                    b2 += b[ind]*b[ind];
+                }
+        BOOST_CHECK_LE( std::sqrt( r2 / b2 ), 2e-4 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( MultigridSolver_HoldsFixedCells )
+{
+    ThreadPool pool( 2 );
+    const size_t N = 24;
+    const size_t dy = N + 2;
+    const size_t dz = dy * (N + 2);
+    std::vector< float > b( dz*(N + 2), 0.0f );
+    std::vector< float > x( dz*(N + 2), 0.0f );
+    std::vector< bool > isFixed( x.size(), false );
+    MultigridSolver solver( N, N, N );
+    // Laplace's equation around a cube held at 1, with the first row
+    // held at 0 in place of the y=0 face
+    for( size_t k = 1; k <= N; ++k )
+        for( size_t i = 1; i <= N; ++i )
+        {
+            solver.addFixedCell( i + dy + dz*k );
+            isFixed[i + dy + dz*k] = true;
+        }
+    for( size_t k = 10; k < 13; ++k )
+        for( size_t j = 10; j < 13; ++j )
+            for( size_t i = 10; i < 13; ++i )
+            {
+                const size_t ind = i + dy*j + dz*k;
+                x[ind] = 1.0f;
+                solver.addFixedCell( ind );
+                isFixed[ind] = true;
+            }
+    BOOST_CHECK_EQUAL( solver.fixedCellCount(), N*N + 27 );
+    const unsigned int iterations = solver.solve( &x[0], &b[0], 1e-5f, 50, pool, fluidKernels() );
+    BOOST_TEST_MESSAGE( "fixed cells: iterations=" << iterations << " residual=" << solver.getResidual() );
+    BOOST_CHECK_LE( solver.getResidual(), 1e-5f );
+
+    // the free cells solve Laplace's equation, and lie between the fixed values
+    double r2 = 0, b2 = 0;
+    float minX = 1, maxX = 0;
+    for( size_t k = 1; k <= N; ++k )
+        for( size_t j = 1; j <= N; ++j )
+            for( size_t i = 1; i <= N; ++i )
+            {
+                const size_t ind = i + dy*j + dz*k;
+                if( isFixed[ind] )
+                {
+                    BOOST_REQUIRE_EQUAL( x[ind], ( j == 1 ) ? 0.0f : 1.0f );
+                    continue;
+                }
+                // the fixed values' part of Ax moves to the right-hand side
+                float fixedSum = 0, freeSum = 0;
+                const size_t neighbors[6] = { ind-1, ind+1, ind-dy, ind+dy, ind-dz, ind+dz };
+                for( size_t n = 0; n < 6; ++n )
+                {
+                    ( isFixed[neighbors[n]] ? fixedSum : freeSum ) += x[neighbors[n]];
+                }
+                const float r = fixedSum - ( 6.0f*x[ind] - freeSum );
+                r2 += r*r;
+                b2 += fixedSum*fixedSum;
+                minX = std::min( minX, x[ind] );
+                maxX = std::max( maxX, x[ind] );
+            }
+    BOOST_CHECK_LE( std::sqrt( r2 / b2 ), 2e-5 );
+    BOOST_CHECK_GE( minX, 0.0f );
+    BOOST_CHECK_LT( maxX, 1.0f );
+
+    // with every fixed value zero, so is the solution
+    std::fill( x.begin(), x.end(), 0.5f );
+    MultigridSolver grounded( N, N, N );
+    for( size_t i = 1; i <= N; ++i )
+    {
+        grounded.addFixedCell( i + dy + dz );
+        x[i + dy + dz] = 0.0f;
+    }
+    BOOST_CHECK_EQUAL( grounded.solve( &x[0], &b[0], 1e-5f, 50, pool, fluidKernels() ), 0u );
+    BOOST_CHECK_EQUAL( *std::max_element( x.begin(), x.end() ), 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_MultigridPressureSolverStopsEarly )
+{
+    Fluid fluid( 34 );
+    fluid.setPressureSolver( Fluid::MultigridPressureSolver );
+    fluid.setPressureTolerance( 1e-3f );
+    fluid.setSolverIterations( 20 );
+    for( int step = 0; step < 5; ++step )
+    {
+        fluid.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        fluid.update( 0.1 );
+        BOOST_CHECK_LT( fluid.getPressureIterations(), 20u );
+        BOOST_CHECK_LE( fluid.getPressureResidual(), 1e-3f );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_AnisotropicGrid )
+{
+    Fluid fluid( 16, 40, 12 );
+    BOOST_CHECK_EQUAL( fluid.dimX(), 16u );
+    BOOST_CHECK_EQUAL( fluid.dimY(), 40u );
+    BOOST_CHECK_EQUAL( fluid.dimZ(), 12u );
+    BOOST_CHECK_CLOSE( fluid.getCellSize(), 1.0f / 38.0f, 1e-3f );
+
+    fluid.setPressureSolver( Fluid::MultigridPressureSolver );
+    for( int step = 0; step < 5; ++step )
+    {
+        fluid.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        fluid.update( 0.1 );
+        BOOST_CHECK_LE( fluid.getPressureResidual(), 1e-3f );
+    }
+    const float* density = fluid.getDensityData();
+    float total = 0;
+    for( size_t i = 0; i < fluid.dimX()*fluid.dimY()*fluid.dimZ(); ++i )
+    {
+        BOOST_REQUIRE( std::abs( density[i] ) < 100.0f );
+        total += density[i];
+    }
+    BOOST_CHECK_GT( total, 0.0f );
+
+    fluid.setSize( 10, 0, 0, 0.5f );
+    BOOST_CHECK_EQUAL( fluid.dimZ(), 10u );
+    BOOST_CHECK_EQUAL( fluid.getCellSize(), 0.5f );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_BrickSkippingMatchesDense )
+{
+    const int n = 50;
+    Fluid sparse( n );
+    Fluid dense( n );
+    sparse.setBrickSkipping( true );
+    for( int step = 0; step < 10; ++step )
+    {
+        sparse.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        dense.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        sparse.update( 0.1 );
+        dense.update( 0.1 );
+    }
+    BOOST_TEST_MESSAGE( "Active bricks: " << sparse.getActiveBrickCount()
+                        << " of " << sparse.getBrickCount() );
+    BOOST_CHECK_LT( sparse.getActiveBrickCount(), sparse.getBrickCount() / 2 );
+
+    const float* sparseDensity = sparse.getDensityData();
+    const float* denseDensity = dense.getDensityData();
+    float maxDiff = 0, maxDensity = 0;
+    for( int i = 0; i < n*n*n; ++i )
+    {
+        maxDiff = std::max( maxDiff, std::abs( sparseDensity[i] - denseDensity[i] ) );
+        maxDensity = std::max( maxDensity, denseDensity[i] );
+    }
+    BOOST_TEST_MESSAGE( "max diff " << maxDiff << " of max density " << maxDensity );
+    BOOST_CHECK_SMALL( maxDiff, 1e-2f * maxDensity );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_RedBlackSolveMatchesReference )
+{
+    const size_t Nx = 18, Ny = 13, Nz = 16;
+    const size_t cellCount = ( Nx + 2 ) * ( Ny + 2 ) * ( Nz + 2 );
+    // A diffusion step, as diffuse() sets it up, converges quickly, so
+    // both orderings end up at the same solution.
+    const float a = 0.5f;
+    const float c = 1 + 6*a;
+    std::srand( 7 );
+    std::vector< float > rhs( cellCount );
+    for( size_t i = 0; i < cellCount; ++i )
+    {
+        rhs[i] = (float)std::rand() / RAND_MAX;
+    }
+
+    Fluid reference( Nx, Ny, Nz );
+    reference.setSolverIterations( 60 );
+    std::vector< float > expected( cellCount, 0.0f );
+    std::vector< float > rhsCopy( rhs );
+    FluidSolverTestAccess::linearSolveSlow( reference, &expected[0], &rhsCopy[0], a, c );
+
+    std::vector< float > results[2];
+    const unsigned int threadCounts[2] = { 1, 4 };
+    for( size_t t = 0; t < 2; ++t )
+    {
+        Fluid fluid( Nx, Ny, Nz );
+        fluid.setSolverIterations( 60 );
+        fluid.setThreadCount( threadCounts[t] );
+        fluid.update( 0.0 );  // takes up the thread count
+        BOOST_REQUIRE_EQUAL( fluid.getThreadCount(), threadCounts[t] );
+        results[t].assign( cellCount, 0.0f );
+        rhsCopy = rhs;
+        FluidSolverTestAccess::linearSolve( fluid, &results[t][0], &rhsCopy[0], a, c );
+    }
+    BOOST_CHECK( results[0] == results[1] );
+
+    float maxValue = 0;
+    for( size_t i = 0; i < cellCount; ++i )
+    {
+        maxValue = std::max( maxValue, std::abs( expected[i] ) );
+    }
+    BOOST_REQUIRE_GT( maxValue, 0.0f );
+    const float diff = maxDifference( results[0], expected );
+    BOOST_TEST_MESSAGE( "red-black vs lexicographic max diff " << diff << " of " << maxValue );
+    BOOST_CHECK_SMALL( diff, 1e-5f * maxValue );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_VorticityOutputIsOptional )
+{
+    const int n = 20;
+    Fluid withOutput( n );
+    Fluid withoutOutput( n );
+    withOutput.setVorticityOutput( true );
+    for( int step = 0; step < 5; ++step )
+    {
+        withOutput.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        withoutOutput.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        withOutput.update( 0.1 );
+        withoutOutput.update( 0.1 );
+    }
+    const float *fx, *fy, *fz, *gx, *gy, *gz;
+    withOutput.getVorticityForceData( fx, fy, fz );
+    withoutOutput.getVorticityForceData( gx, gy, gz );
+    const float *wx, *wy, *wz;
+    withOutput.getVorticityData( wx, wy, wz );
+    const float* mag = withOutput.getVorticityMagnitudeData();
+    const float* noMag = withoutOutput.getVorticityMagnitudeData();
+    float maxMag = 0;
+    for( int i = 0; i < n*n*n; ++i )
+    {
+        BOOST_REQUIRE_EQUAL( fx[i], gx[i] );
+        BOOST_REQUIRE_EQUAL( fy[i], gy[i] );
+        BOOST_REQUIRE_EQUAL( fz[i], gz[i] );
+        BOOST_REQUIRE_EQUAL( noMag[i], 0.0f );
+        BOOST_REQUIRE_CLOSE( mag[i], std::sqrt( wx[i]*wx[i] + wy[i]*wy[i] + wz[i]*wz[i] ), 1e-3f );
+        maxMag = std::max( maxMag, mag[i] );
+    }
+    BOOST_CHECK_GT( maxMag, 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE( TripleBuffer_ReaderSeesWholeFramesInOrder )
+{
+    const size_t frameSize = 4096;
+    const int frameCount = 2000;
+    TripleBuffer< std::vector< int > > buffer;
+    for( unsigned int i = 0; i < 3; ++i )
+    {
+        buffer.getBuffer( i ).assign( frameSize, -1 );
+    }
+    BOOST_CHECK( !buffer.acquire() );
+
+    // every element of frame f holds f
+    boost::thread writer( [&]()
+    {
+        for( int frame = 0; frame < frameCount; ++frame )
+        {
+            std::fill( buffer.getBack().begin(), buffer.getBack().end(), frame );
+            buffer.publish();
+        }
+    } );
+    int lastFrame = -1;
+    while( lastFrame < frameCount - 1 )
+    {
+        if( buffer.acquire() )
+        {
+            const std::vector< int >& front = buffer.getFront();
+            const int frame = front[0];
+            BOOST_REQUIRE_GT( frame, lastFrame );
+            BOOST_REQUIRE( std::count( front.begin(), front.end(), frame ) == (ptrdiff_t)frameSize );
+            lastFrame = frame;
+        }
+    }
+    writer.join();
+    BOOST_CHECK( !buffer.acquire() );
+    BOOST_CHECK_EQUAL( buffer.getFront()[0], frameCount - 1 );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_DensitySnapshotIsLastUpdate )
+{
+    Fluid fluid( 16 );
+    const size_t size = fluid.dimX()*fluid.dimY()*fluid.dimZ();
+    const float* initial = fluid.getDensitySnapshot();
+    BOOST_CHECK_EQUAL( *std::max_element( initial, initial + size ), 0.0f );
+
+    fluid.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+    fluid.update( 0.1 );
+    const std::vector< float > afterUpdate( fluid.getDensityData(), fluid.getDensityData() + size );
+    // sources added after the update aren't part of a completed frame
+    fluid.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+    const float* snapshot = fluid.getDensitySnapshot();
+    BOOST_CHECK( std::equal( afterUpdate.begin(), afterUpdate.end(), snapshot ) );
+    BOOST_CHECK_GT( *std::max_element( snapshot, snapshot + size ), 0.0f );
+    // unchanged until the next update
+    BOOST_CHECK_EQUAL( fluid.getDensitySnapshot(), snapshot );
+
+    // reset() waits for the next update, as does its snapshot
+    fluid.reset();
+    BOOST_CHECK_GT( *std::max_element( fluid.getDensityData(), fluid.getDensityData() + size ), 0.0f );
+    fluid.update( 0.1 );
+    const float* cleared = fluid.getDensitySnapshot();
+    BOOST_CHECK_EQUAL( *std::max_element( cleared, cleared + size ), 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_FieldsShareOneAlignedSlab )
+{
+    for( int hugePages = 0; hugePages < 2; ++hugePages )
+    {
+        Fluid fluid( 13 );
+        fluid.setHugePages( hugePages != 0 );
+        fluid.setSize( 13, 11, 9, 0 );
+        const float* u;
+        const float* v;
+        const float* w;
+        fluid.getVelocityData( u, v, w );
+        const float* const fields[] = { fluid.getDensityData(), fluid.getTemperatureData(), u, v, w };
+        for( size_t f = 0; f < 5; ++f )
+        {
+            BOOST_CHECK_EQUAL( (size_t)fields[f] % 64, 0u );
+        }
+        // the fields are cleared, the boundary slices included
+        const size_t size = fluid.dimX()*fluid.dimY()*fluid.dimZ();
+        BOOST_CHECK_EQUAL( *std::max_element( u, u + size ), 0.0f );
+        BOOST_CHECK_EQUAL( *std::min_element( u, u + size ), 0.0f );
+        BOOST_CHECK_EQUAL( *std::min_element( fluid.getTemperatureData(), fluid.getTemperatureData() + size ),
+                           20.0f ); // the default ambient temperature
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_HalfFloatSnapshotMatchesDensity )
+{
+    Fluid fluid( 12 );
+    BOOST_CHECK( fluid.getHalfDensitySnapshot() == NULL );
+    fluid.setHalfFloatSnapshots( true );
+    fluid.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+    fluid.update( 0.1 );
+
+    const size_t size = fluid.dimX()*fluid.dimY()*fluid.dimZ();
+    const float* snapshot = fluid.getDensitySnapshot();
+    const unsigned short* halfSnapshot = fluid.getHalfDensitySnapshot();
+    BOOST_REQUIRE( halfSnapshot );
+    std::vector< unsigned short > expected( size );
+    scalarFluidKernels().floatToHalf( &expected[0], snapshot, size );
+    BOOST_CHECK( std::equal( expected.begin(), expected.end(), halfSnapshot ) );
+
+    const float one = 1.0f;
+    unsigned short halfOne = 0;
+    scalarFluidKernels().floatToHalf( &halfOne, &one, 1 );
+    BOOST_CHECK_EQUAL( halfOne, 0x3c00 );
+
+    fluid.setHalfFloatSnapshots( false );
+    BOOST_CHECK( fluid.getHalfDensitySnapshot() == NULL );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_SparseSourcesLastTheirLifetime )
+{
+    // Without diffusion or forces nothing moves, so the added density stays put
+    Fluid fluid( 14, 12, 10 );
+    fluid.setGravityFactor( 0, 0, 0 );
+    fluid.setDiffusion( 0 );
+    const size_t size = fluid.dimX()*fluid.dimY()*fluid.dimZ();
+    const float* density = fluid.getDensityData();
+    // the boundary cells copy their neighbors, so only sum the interior
+    auto totalDensity = [&]()
+    {
+        double total = 0;
+        for( size_t k = 1; k + 1 < fluid.dimZ(); ++k )
+        {
+            for( size_t j = 1; j + 1 < fluid.dimY(); ++j )
+            {
+                const float* row = density + fluid.dimX()*( j + fluid.dimY()*k );
+                total = std::accumulate( row + 1, row + fluid.dimX() - 1, total );
+            }
+        }
+        return total;
+    };
+
+    Fluid::Source brief;
+    brief.position[0] = 0.1f;
+    brief.radius = 0.2f;
+    brief.density = 2.0f;
+    brief.lifetime = 0.5f;
+    Fluid::Source lasting;
+    lasting.density = 1.0f;
+    lasting.lifetime = 3.0f;
+    fluid.addSource( brief );
+    fluid.addSourceAtCell( 3, 4, 5, lasting );
+    BOOST_CHECK_EQUAL( fluid.getSourceCount(), 0u ); // until the next update
+    fluid.update( 20.0 ); // one unit of simulation time
+    BOOST_CHECK_EQUAL( fluid.getSourceCount(), 1u );
+    BOOST_CHECK_CLOSE( totalDensity(), 2.0*0.5 + 1.0, 1e-3 );
+    BOOST_CHECK_CLOSE( density[3 + fluid.dimX()*( 4 + fluid.dimY()*5 )], 1.0f, 1e-3 );
+    // the brief source covers several cells
+    BOOST_CHECK_GT( std::count_if( density, density + size, []( float d ) { return d > 0; } ), 8 );
+
+    fluid.clearSources();
+    fluid.update( 20.0 );
+    BOOST_CHECK_EQUAL( fluid.getSourceCount(), 0u );
+    BOOST_CHECK_CLOSE( totalDensity(), 2.0, 1e-3 );
+
+    // impulses may be added while another thread updates
+    boost::atomic< bool > isDone( false );
+    boost::thread updater( [&]()
+    {
+        while( !isDone )
+        {
+            fluid.update( 1.0 );
+        }
+    } );
+    Fluid::Source impulse;
+    impulse.density = 0.01f;
+    for( int n = 0; n < 100; n++ )
+    {
+        fluid.addSourceAtCell( 7, 6, 5, impulse );
+        boost::this_thread::yield();
+    }
+    isDone = true;
+    updater.join();
+    fluid.update( 1.0 );
+    BOOST_CHECK_CLOSE( totalDensity(), 3.0, 1e-3 );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_ResizeDropsActiveSources )
+{
+    const char* filename = "FluidTests_resize.txt";
+    Fluid small( 10 );
+    small.saveToFile( filename );
+
+    // a lasting source near the far corner, whose cells are past the
+    // end of the smaller grids
+    Fluid::Source lasting;
+    lasting.density = 1.0f;
+    lasting.radius = 0.05f;
+    lasting.lifetime = 100.0f;
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        Fluid fluid( 30 );
+        fluid.setGravityFactor( 0, 0, 0 );
+        fluid.addSourceAtCell( 26, 26, 26, lasting );
+        fluid.update( 0.1 );
+        BOOST_REQUIRE_EQUAL( fluid.getSourceCount(), 1u );
+        if( pass == 0 )
+        {
+            fluid.setSize( 10 );
+        }
+        else
+        {
+            fluid.loadFromFile( filename );
+        }
+        BOOST_CHECK_EQUAL( fluid.getSourceCount(), 0u );
+        fluid.update( 0.1 );
+        const size_t size = fluid.dimX()*fluid.dimY()*fluid.dimZ();
+        BOOST_REQUIRE_EQUAL( size, 1000u );
+        const float* density = fluid.getDensityData();
+        BOOST_CHECK( std::count( density, density + size, 0.0f ) == (std::ptrdiff_t)size );
+
+        // sources queued after the resize land on the new grid
+        fluid.addSourceAtCell( 4, 4, 4, lasting );
+        fluid.update( 0.1 );
+        BOOST_CHECK_EQUAL( fluid.getSourceCount(), 1u );
+        BOOST_CHECK_GT( fluid.getDensityData()[4 + 10*( 4 + 10*4 )], 0.0f );
+    }
+    std::remove( filename );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_SubstepsHoldCFLWithinBudget )
+{
+    Fluid fluid( 16 );
+    fluid.setGravityFactor( 0, 0, -200.0f );
+    fluid.update( 0.1 );
+    BOOST_CHECK_EQUAL( fluid.getSubstepCount(), 1u );
+
+    // heavy fluid falls; a long frame would carry it across many cells
+    for( int n = 0; n < 20; n++ )
+    {
+        fluid.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+    }
+    for( int n = 0; n < 4; n++ )
+    {
+        fluid.update( 0.1 );
+    }
+    BOOST_CHECK_EQUAL( fluid.getSubstepCount(), 1u );
+    fluid.update( 20.0 );
+    BOOST_CHECK_GT( fluid.getCFL(), 4.0f );
+    BOOST_CHECK_GT( fluid.getSubstepCount(), 1u );
+
+    fluid.setMaxSubsteps( 2 );
+    fluid.update( 20.0 );
+    BOOST_CHECK_LE( fluid.getSubstepCount(), 2u );
+
+    // a spent budget still takes one substep
+    fluid.setMaxSubsteps( 8 );
+    fluid.setUpdateBudget( 1e-6f );
+    fluid.update( 20.0 );
+    BOOST_CHECK_EQUAL( fluid.getSubstepCount(), 1u );
+    BOOST_CHECK_GT( fluid.getUpdateMilliseconds(), 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_GaussSeidelPressureStopsAtTolerance )
+{
+    Fluid fluid( 24 );
+    fluid.setSolverIterations( 40 );
+    fluid.setPressureTolerance( 0.05f );
+    for( int n = 0; n < 20; n++ )
+    {
+        fluid.addSourceAtLocation( 0.0f, 0.0f, 5.0f, 10.0f );
+        fluid.update( 0.1 );
+    }
+    const std::vector< Fluid::PressureSolveStats >& stats = fluid.getPressureSolveStats();
+    BOOST_REQUIRE_EQUAL( stats.size(), 2*fluid.getSubstepCount() );
+    for( size_t n = 0; n < stats.size(); n++ )
+    {
+        BOOST_CHECK_LT( stats[n].iterations, 40u );
+        BOOST_CHECK_LE( stats[n].residual, 0.05f );
+        BOOST_CHECK_GT( stats[n].residualMax, 0.0f );
+    }
+    BOOST_CHECK_EQUAL( fluid.getPressureResidual(), stats.back().residual );
+
+    // without a tolerance every iteration runs
+    fluid.setPressureTolerance( 0 );
+    fluid.update( 0.1 );
+    BOOST_CHECK_EQUAL( fluid.getPressureIterations(), 40u );
+    BOOST_CHECK_GT( fluid.getPressureResidual(), 0.0f );
+
+    // as it does by default
+    Fluid defaults( 24 );
+    defaults.setSolverIterations( 40 );
+    defaults.addSourceAtLocation( 0.0f, 0.0f, 5.0f, 10.0f );
+    defaults.update( 0.1 );
+    BOOST_CHECK_EQUAL( defaults.getPressureIterations(), 40u );
+    BOOST_CHECK_GT( defaults.getPressureResidual(), 0.0f );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_SamplesVelocityTrilinearly )
+{
+    Fluid fluid( 12, 16, 20 );
+    const float h = fluid.getCellSize();
+    // a linear field, which trilinear interpolation reproduces exactly
+    const float* cu; const float* cv; const float* cw;
+    fluid.getVelocityData( cu, cv, cw );
+    float* u = const_cast< float* >( cu );
+    float* v = const_cast< float* >( cv );
+    float* w = const_cast< float* >( cw );
+    const size_t dx = fluid.dimX(), dy = fluid.dimY(), dz = fluid.dimZ();
+    for( size_t k = 0; k < dz; k++ )
+    {
+        for( size_t j = 0; j < dy; j++ )
+        {
+            for( size_t i = 0; i < dx; i++ )
+            {
+                // world-space position of the cell center
+                const float x = h*( i - 0.5f*(dx-1) );
+                const float y = h*( j - 0.5f*(dy-1) );
+                const float z = h*( k - 0.5f*(dz-1) );
+                const size_t ind = i + dx*( j + dy*k );
+                u[ind] = x + 2*y;
+                v[ind] = 3*z;
+                w[ind] = 1 - x;
+            }
+        }
+    }
+
+    std::srand( 7 );
+    const size_t n = 37;
+    std::vector< float > xyz( 3*n ), velocities( 3*n );
+    for( size_t p = 0; p < 3*n; ++p )
+    {
+        // within the cell centers of the interior along each axis
+        const float extent = h*( (p%3 == 0 ? dx : p%3 == 1 ? dy : dz) - 3 );
+        xyz[p] = extent*( (float)std::rand() / RAND_MAX - 0.5f );
+    }
+    fluid.velocityAtPositions( &xyz[0], n, &velocities[0] );
+    for( size_t p = 0; p < n; ++p )
+    {
+        const float x = xyz[3*p], y = xyz[3*p+1], z = xyz[3*p+2];
+        BOOST_CHECK_SMALL( velocities[3*p]   - ( x + 2*y ), 1e-4f );
+        BOOST_CHECK_SMALL( velocities[3*p+1] - ( 3*z ), 1e-4f );
+        BOOST_CHECK_SMALL( velocities[3*p+2] - ( 1 - x ), 1e-4f );
+        const Eigen::Vector3f single = fluid.velocityAtPosition( Eigen::Vector3f( x, y, z ) );
+        BOOST_CHECK_SMALL( single.x() - velocities[3*p], 1e-5f );
+    }
+
+    // outside, the velocity halfway into the boundary cells
+    const Eigen::Vector3f far = fluid.velocityAtPosition( Eigen::Vector3f( 10.0f, 0.0f, 0.0f ) );
+    const Eigen::Vector3f edge = fluid.velocityAtPosition( Eigen::Vector3f( h*0.5f*(dx-2), 0.0f, 0.0f ) );
+    BOOST_CHECK_SMALL( ( far - edge ).norm(), 1e-5f );
+}
+
+BOOST_AUTO_TEST_CASE( Fluid_CheckpointRestoresState )
+{
+    const char* filename = "FluidTests_checkpoint.bin";
+    Fluid saved( 12, 20, 16 );
+    saved.setViscosity( 0.001f );
+    saved.setGravityFactor( 0, 0.1f, 0.5f );
+    for( int n = 0; n < 5; n++ )
+    {
+        saved.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        saved.update( 0.1 );
+    }
+    saved.saveCheckpoint( filename );
+
+    const size_t size = saved.dimX()*saved.dimY()*saved.dimZ();
+    for( int pass = 0; pass < 2; pass++ )
+    {
+        // the second pass checks that updating the first didn't write the file
+        Fluid loaded( 8 );
+        loaded.loadCheckpoint( filename );
+        BOOST_REQUIRE_EQUAL( loaded.dimX(), saved.dimX() );
+        BOOST_REQUIRE_EQUAL( loaded.dimY(), saved.dimY() );
+        BOOST_REQUIRE_EQUAL( loaded.dimZ(), saved.dimZ() );
+        BOOST_CHECK_EQUAL( loaded.getCellSize(), saved.getCellSize() );
+        BOOST_CHECK( std::equal( saved.getDensityData(), saved.getDensityData() + size, 
+                                 loaded.getDensityData() ) );
+        const float* su; const float* sv; const float* sw;
+        const float* lu; const float* lv; const float* lw;
+        saved.getVelocityData( su, sv, sw );
+        loaded.getVelocityData( lu, lv, lw );
+        BOOST_CHECK( std::equal( su, su + size, lu ) );
+        BOOST_CHECK( std::equal( sw, sw + size, lw ) );
+
+        // same state and parameters, so the same next step
+        Fluid resumed( 12, 20, 16 );
+        resumed.loadCheckpoint( filename );
+        resumed.update( 0.1 );
+        loaded.update( 0.1 );
+        BOOST_CHECK( std::equal( resumed.getDensityData(), resumed.getDensityData() + size, 
+                                 loaded.getDensityData() ) );
+    }
+    // and the same as if never saved
+    Fluid reference( 12, 20, 16 );
+    reference.loadCheckpoint( filename );
+    saved.update( 0.1 );
+    reference.update( 0.1 );
+    BOOST_CHECK( std::equal( saved.getDensityData(), saved.getDensityData() + size, 
+                             reference.getDensityData() ) );
+
+    // truncated and corrupt checkpoints leave the fluid as it was
+    std::string bytes;
+    {
+        std::ifstream in( filename, std::ios::binary );
+        bytes.assign( std::istreambuf_iterator< char >( in ), std::istreambuf_iterator< char >() );
+    }
+    std::vector< std::string > corrupt;
+    corrupt.push_back( bytes.substr( 0, bytes.size() / 2 ) );
+    // fieldStride (at byte 72 of the header) of 2^63, so fieldCount
+    // strides wrap around to 0
+    corrupt.push_back( bytes );
+    const boost::uint64_t hugeStride = (boost::uint64_t)1 << 63;
+    std::memcpy( &corrupt.back()[72], &hugeStride, sizeof( hugeStride ) );
+    // nx (at byte 20) so large the cell count overflows
+    corrupt.push_back( bytes );
+    const boost::uint32_t hugeSide = 0xfffffff0u;
+    std::memcpy( &corrupt.back()[20], &hugeSide, sizeof( hugeSide ) );
+    for( size_t c = 0; c < corrupt.size(); ++c )
+    {
+        {
+            std::ofstream out( filename, std::ios::binary | std::ios::trunc );
+            out.write( corrupt[c].data(), corrupt[c].size() );
+        }
+        Fluid small( 8 );
+        BOOST_CHECK_THROW( small.loadCheckpoint( filename ), SparkRunTimeException );
+        BOOST_CHECK_EQUAL( small.dimX(), 8u );
+        BOOST_CHECK_EQUAL( small.dimY(), 8u );
+        BOOST_CHECK_EQUAL( small.dimZ(), 8u );
+        small.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+        small.update( 0.1 );
+    }
+
+    // text files aren't checkpoints
+    saved.saveToFile( filename );
+    Fluid other( 8 );
+    BOOST_CHECK_THROW( other.loadCheckpoint( filename ), SparkRunTimeException );
+    BOOST_CHECK_THROW( other.loadCheckpoint( "FluidTests_missing.bin" ), SparkRunTimeException );
+    std::remove( filename );
+}
+
+BOOST_AUTO_TEST_CASE( FluidRecorder_WritesEveryIntervalFrame )
+{
+    const char* filename = "FluidTests_recording.npy";
+    Fluid fluid( 10, 12, 14 );
+    std::vector< size_t > slices;
+    slices.push_back( 3 );
+    slices.push_back( 6 );
+    std::vector< std::vector< float > > expected;
+    {
+        FluidRecorderPtr recorder( new FluidRecorder( filename, fluid,
+                                                      FluidRecorder::DensityField | FluidRecorder::VelocityField,
+                                                      2, slices, 16 ) );
+        fluid.setRecorder( recorder );
+        for( int n = 0; n < 7; n++ )
+        {
+            fluid.addSourceAtLocation( 0.0f, 0.0f, 1.0f, 10.0f );
+            fluid.update( 0.1 );
+            if( n % 2 == 0 )
+            {
+                // density at y = 6, z = 5
+                const float* row = fluid.getDensityData() + fluid.dimX()*( 6 + fluid.dimY()*5 );
+                expected.push_back( std::vector< float >( row, row + fluid.dimX() ) );
+            }
+        }
+        fluid.setRecorder( FluidRecorderPtr() );
+        BOOST_CHECK_EQUAL( recorder->getFrameCount(), 4u );
+        BOOST_CHECK_EQUAL( recorder->getDroppedFrameCount(), 0u );
+    }
+
+    // two NPY arrays per frame: the index, then (fields, slices, z, x)
+    std::ifstream in( filename, std::ios::binary );
+    const size_t frameFloats = 4 * slices.size() * fluid.dimZ() * fluid.dimX();
+    for( size_t frame = 0; frame < expected.size(); ++frame )
+    {
+        char prefix[10];
+        BOOST_REQUIRE( in.read( prefix, 10 ) );
+        BOOST_REQUIRE( std::equal( prefix, prefix + 6, "\x93NUMPY" ) );
+        const size_t headerSize = (unsigned char)prefix[8] | ( (unsigned char)prefix[9] << 8 );
+        BOOST_CHECK_EQUAL( ( 10 + headerSize ) % 64, 0u );
+        in.ignore( headerSize );
+        long long index[2];
+        in.read( (char*)index, sizeof( index ) );
+        BOOST_CHECK_EQUAL( index[0], (long long)frame );
+        BOOST_CHECK_EQUAL( index[1], (long long)( 2*frame ) );
+
+        BOOST_REQUIRE( in.read( prefix, 10 ) );
+        std::string header( (unsigned char)prefix[8] | ( (unsigned char)prefix[9] << 8 ), ' ' );
+        in.read( &header[0], header.size() );
+        BOOST_CHECK( header.find( "'shape': (4, 2, 14, 10, )" ) != std::string::npos );
+        std::vector< float > data( frameFloats );
+        in.read( (char*)&data[0], frameFloats * sizeof( float ) );
+        const float* row = &data[ fluid.dimX()*( fluid.dimZ() + 5 ) ];
+        BOOST_CHECK( std::equal( expected[frame].begin(), expected[frame].end(), row ) );
+    }
+    BOOST_CHECK_EQUAL( in.peek(), std::char_traits< char >::eof() );
+    in.close();
+    std::remove( filename );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -1,139 +1,211 @@
-
-#define BOOST_TEST_DYN_LINK
-#include <boost/test/unit_test.hpp>
-#include <algorithm>
-
-#include "SoftTestDeclarations.hpp"
-#include "config.hpp"
-#include "FileAssetFinder.hpp"
-#include "ShaderManager.hpp"
-
-#include "Renderable.hpp"
-#include "RenderCommand.hpp"
-#include "ShaderInstance.hpp"
-#include "TextureManager.hpp"
-#include "RenderTarget.hpp"
-#include "Projection.hpp"
-#include "RenderPass.hpp"
-#include "Scene.hpp"
-
-using namespace spark;
-
-class TestRenderable : public spark::Renderable
-{
-public:
-    TestRenderable( TextureManagerPtr tm, ShaderManagerPtr sm ) 
-        : Renderable( "TestRenderable" ), 
-          renderedCount( 0 ) 
-    { }
-    mutable int renderedCount;
-    virtual void render( const RenderCommand& rc ) const override
-    {
-        std::cout << "rendering TestRender";
-        renderedCount++;
-    }
-    virtual void attachShaderAttributes( GLuint shaderIndex )
-    {
-        // glBindBuffer( GL_ARRAY_BUFFER, m_vertexBufferId );
-        // glVertexAttribPointer( ... );
-        // glEnableVertexAttribArray( position_loc_in_shader );
-    }
-};
-
-BOOST_AUTO_TEST_SUITE( RenderPipelineSuite )
-BOOST_AUTO_TEST_CASE( CreateRenderCommands )
-{
-    OpenGLWindow( "Unit Tests - RenderPipelineSuite" );
-    // busy wait until window opens
-    FileAssetFinderPtr finder( new FileAssetFinder() );
-    finder->addRecursiveSearchPath( DATA_PATH );
-    TextureManagerPtr textureManager( new TextureManager( finder ) );
-    ShaderManagerPtr shaderManager( new ShaderManager( finder ) );
-    
-    PerspectiveProjectionPtr camera( new PerspectiveProjection );
-    int width = 400; int height = 400;
-    RenderTargetPtr frameBufferTarget( new FrameBufferRenderTarget( width, height ) );
-    frameBufferTarget->initialize( textureManager );
-
-    ScenePtr scene( new Scene );
-
-    RenderPassPtr primaryRenderPass( new RenderPass("TestRenderPass") );
-    primaryRenderPass->initialize( frameBufferTarget, camera );
-    scene->add( primaryRenderPass );
-
-    std::shared_ptr< TestRenderable > testObject( new TestRenderable( textureManager, shaderManager ) );
-    shaderManager->loadShaderFromFiles( "ColorShader", "color.vert", "color.frag" );
-    ShaderInstancePtr testShader( new ShaderInstance( "ColorShader", shaderManager ) );
-    MaterialPtr material( new Material( textureManager, testShader ) );
-    testObject->setMaterialForPassName( "TestRenderPass", material );
-    scene->add( testObject ); 
-
-    scene->prepareRenderCommands();
-
-    // expect output of "rendering TestRender"
-    BOOST_REQUIRE_EQUAL( testObject->renderedCount, 0 );   
-    scene->prepareRenderCommands();
-    scene->render();
-    BOOST_REQUIRE_EQUAL( testObject->renderedCount, 1 );    
-    scene->render();
-    BOOST_REQUIRE_EQUAL( testObject->renderedCount, 1 );    
-    scene->prepareRenderCommands();
-    scene->render();
-    BOOST_REQUIRE_EQUAL( testObject->renderedCount, 2 );    
-
-}
-BOOST_AUTO_TEST_SUITE_END()
-
-
-//TODO move to own test file
-BOOST_AUTO_TEST_SUITE( FileAssetSuite )
-
-BOOST_AUTO_TEST_CASE( FailWithNoPaths )
-{
-    FileAssetFinder finder;
-    std::string sparkPath;
-    BOOST_REQUIRE( ! finder.findFile( DATA_PATH "textures/spark.png", sparkPath ) );
-}
-BOOST_AUTO_TEST_CASE( FileAsset_NonRecursiveSearch )
-{
-    FileAssetFinder finder;
-    finder.addSearchPath( DATA_PATH "textures/" );
-    std::string sparkPath;
-    BOOST_REQUIRE( finder.findFile( "spark.png", sparkPath ) );
-    BOOST_REQUIRE_EQUAL( sparkPath, DATA_PATH "textures/spark.png" );
-}
-BOOST_AUTO_TEST_CASE( FileAsset_RecursiveSearch )
-{
-    FileAssetFinder finder;
-    finder.addRecursiveSearchPath( DATA_PATH );
-    std::string sparkPath;
-    BOOST_REQUIRE( finder.findFile( "spark.png", sparkPath ) );
-    std::replace( sparkPath.begin(), sparkPath.end(), '\\', '/' ); // standardize slashes
-    BOOST_REQUIRE_EQUAL( sparkPath, DATA_PATH "textures/spark.png" );
-}
-
-BOOST_AUTO_TEST_SUITE_END()
-
-
-BOOST_AUTO_TEST_SUITE( ManagerSuite )
-
-BOOST_AUTO_TEST_CASE( TextureMangerTests )
-{
-    FileAssetFinderPtr finder(new FileAssetFinder);
-    finder->addRecursiveSearchPath( DATA_PATH );
-    TextureManager tm;
-    tm.setAssetFinder( finder );
-    tm.loadTextureFromImageFile( "TestSpark", "spark.png" );
-    BOOST_REQUIRE_NE( tm.getTextureIdForHandle( "TestSpark" ), -1 );
-}
-BOOST_AUTO_TEST_CASE( ShaderMangerTests )
-{
-    FileAssetFinderPtr finder(new FileAssetFinder);
-    finder->addRecursiveSearchPath( DATA_PATH );
-    ShaderManager sm;
-    sm.setAssetFinder( finder );
-
-}
-
-BOOST_AUTO_TEST_SUITE_END()
-
+
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include <boost/thread/locks.hpp>
+#include <algorithm>
+#include <vector>
+
+#include "SoftTestDeclarations.hpp"
+#include "config.hpp"
+#include "FileAssetFinder.hpp"
+#include "ShaderManager.hpp"
+
+#include "Renderable.hpp"
+#include "RenderCommand.hpp"
+#include "ShaderInstance.hpp"
+#include "TextureManager.hpp"
+#include "RenderTarget.hpp"
+#include "Projection.hpp"
+#include "RenderPass.hpp"
+#include "Scene.hpp"
+
+using namespace spark;
+
+namespace spark
+{
+    /// Reads the loads queued in a TextureManager.
+    struct TextureManagerTestAccess
+    {
+        static size_t queuedCount( const TextureManager& tm )
+        {
+            boost::lock_guard<boost::mutex> lock( tm.m_commandQueueMutex );
+            return tm.m_commandQueue.size();
+        }
+        /// The tiles and texels of the subset load of T texels queued for
+        /// aHandle.  False if no such load is queued for it.
+        template< typename T >
+        static bool queuedSubsetLoad( const TextureManager& tm, const TextureName& aHandle,
+                                      std::vector< TextureTile >& tiles, std::vector< T >& texels )
+        {
+            boost::lock_guard<boost::mutex> lock( tm.m_commandQueueMutex );
+            for( auto iter = tm.m_commandQueue.begin(); iter != tm.m_commandQueue.end(); ++iter )
+            {
+                const TextureManager::SubsetLoad2DTextureFromDataCommand<T>* load
+                    = dynamic_cast< const TextureManager::SubsetLoad2DTextureFromDataCommand<T>* >( iter->get() );
+                if( load && load->m_handle == aHandle )
+                {
+                    tiles = load->m_tiles;
+                    texels = load->m_subsetData;
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+}
+
+class TestRenderable : public spark::Renderable
+{
+public:
+    TestRenderable( TextureManagerPtr tm, ShaderManagerPtr sm ) 
+        : Renderable( "TestRenderable" ), 
+          renderedCount( 0 ) 
+    { }
+    mutable int renderedCount;
+    virtual void render( const RenderCommand& rc ) const override
+    {
+        std::cout << "rendering TestRender";
+        renderedCount++;
+    }
+    virtual void attachShaderAttributes( GLuint shaderIndex )
+    {
+        // glBindBuffer( GL_ARRAY_BUFFER, m_vertexBufferId );
+        // glVertexAttribPointer( ... );
+        // glEnableVertexAttribArray( position_loc_in_shader );
+    }
+};
+
+BOOST_AUTO_TEST_SUITE( RenderPipelineSuite )
+BOOST_AUTO_TEST_CASE( CreateRenderCommands )
+{
+    OpenGLWindow( "Unit Tests - RenderPipelineSuite" );
+    // busy wait until window opens
+    FileAssetFinderPtr finder( new FileAssetFinder() );
+    finder->addRecursiveSearchPath( DATA_PATH );
+    TextureManagerPtr textureManager( new TextureManager( finder ) );
+    ShaderManagerPtr shaderManager( new ShaderManager( finder ) );
+    
+    PerspectiveProjectionPtr camera( new PerspectiveProjection );
+    int width = 400; int height = 400;
+    RenderTargetPtr frameBufferTarget( new FrameBufferRenderTarget( width, height ) );
+    frameBufferTarget->initialize( textureManager );
+
+    ScenePtr scene( new Scene );
+
+    RenderPassPtr primaryRenderPass( new RenderPass("TestRenderPass") );
+    primaryRenderPass->initialize( frameBufferTarget, camera );
+    scene->add( primaryRenderPass );
+
+    std::shared_ptr< TestRenderable > testObject( new TestRenderable( textureManager, shaderManager ) );
+    shaderManager->loadShaderFromFiles( "ColorShader", "color.vert", "color.frag" );
+    ShaderInstancePtr testShader( new ShaderInstance( "ColorShader", shaderManager ) );
+    MaterialPtr material( new Material( textureManager, testShader ) );
+    testObject->setMaterialForPassName( "TestRenderPass", material );
+    scene->add( testObject ); 
+
+    scene->prepareRenderCommands();
+
+    // expect output of "rendering TestRender"
+    BOOST_REQUIRE_EQUAL( testObject->renderedCount, 0 );   
+    scene->prepareRenderCommands();
+    scene->render();
+    BOOST_REQUIRE_EQUAL( testObject->renderedCount, 1 );    
+    scene->render();
+    BOOST_REQUIRE_EQUAL( testObject->renderedCount, 1 );    
+    scene->prepareRenderCommands();
+    scene->render();
+    BOOST_REQUIRE_EQUAL( testObject->renderedCount, 2 );    
+
+}
+BOOST_AUTO_TEST_SUITE_END()
+
+
+//TODO move to own test file
+BOOST_AUTO_TEST_SUITE( FileAssetSuite )
+
+BOOST_AUTO_TEST_CASE( FailWithNoPaths )
+{
+    FileAssetFinder finder;
+    std::string sparkPath;
+    BOOST_REQUIRE( ! finder.findFile( DATA_PATH "textures/spark.png", sparkPath ) );
+}
+BOOST_AUTO_TEST_CASE( FileAsset_NonRecursiveSearch )
+{
+    FileAssetFinder finder;
+    finder.addSearchPath( DATA_PATH "textures/" );
+    std::string sparkPath;
+    BOOST_REQUIRE( finder.findFile( "spark.png", sparkPath ) );
+    BOOST_REQUIRE_EQUAL( sparkPath, DATA_PATH "textures/spark.png" );
+}
+BOOST_AUTO_TEST_CASE( FileAsset_RecursiveSearch )
+{
+    FileAssetFinder finder;
+    finder.addRecursiveSearchPath( DATA_PATH );
+    std::string sparkPath;
+    BOOST_REQUIRE( finder.findFile( "spark.png", sparkPath ) );
+    std::replace( sparkPath.begin(), sparkPath.end(), '\\', '/' ); // standardize slashes
+    BOOST_REQUIRE_EQUAL( sparkPath, DATA_PATH "textures/spark.png" );
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+
+BOOST_AUTO_TEST_SUITE( ManagerSuite )
+
+BOOST_AUTO_TEST_CASE( TextureMangerTests )
+{
+    FileAssetFinderPtr finder(new FileAssetFinder);
+    finder->addRecursiveSearchPath( DATA_PATH );
+    TextureManager tm;
+    tm.setAssetFinder( finder );
+    tm.loadTextureFromImageFile( "TestSpark", "spark.png" );
+    BOOST_REQUIRE_NE( tm.getTextureIdForHandle( "TestSpark" ), -1 );
+}
+BOOST_AUTO_TEST_CASE( TextureManager_MergesQueuedSubsetLoads )
+{
+    TextureManager tm;
+    // a 4x4 texture, and the same texture a frame later
+    std::vector<unsigned char> first( 16 ), second( 16 );
+    for( size_t i = 0; i < 16; ++i )
+    {
+        first[i] = (unsigned char)i;
+        second[i] = (unsigned char)( 100 + i );
+    }
+    std::vector<TextureTile> tiles;
+    std::vector<unsigned char> texels;
+
+    // pending tiles are merged in, once each, with texels from the newer data
+    std::vector<TextureTile> topLeft( 1, TextureTile( 0, 0, 2, 2 ) );
+    tm.queueSubsetLoad2DByteTextureFromData( "Subset", first, 4, topLeft );
+    std::vector<TextureTile> bottomRight( 1, TextureTile( 2, 2, 2, 2 ) );
+    bottomRight.push_back( TextureTile( 0, 0, 2, 2 ) );
+    tm.queueSubsetLoad2DByteTextureFromData( "Subset", second, 4, bottomRight );
+    BOOST_CHECK_EQUAL( TextureManagerTestAccess::queuedCount( tm ), 1u );
+    BOOST_REQUIRE( TextureManagerTestAccess::queuedSubsetLoad( tm, "Subset", tiles, texels ) );
+    BOOST_REQUIRE_EQUAL( tiles.size(), 2u );
+    BOOST_CHECK( tiles[0] == TextureTile( 2, 2, 2, 2 ) );
+    BOOST_CHECK( tiles[1] == TextureTile( 0, 0, 2, 2 ) );
+    const unsigned char merged[] = { 110, 111, 114, 115, 100, 101, 104, 105 };
+    BOOST_CHECK_EQUAL_COLLECTIONS( texels.begin(), texels.end(), merged, merged + 8 );
+
+    // over a pending full load, all of the newer data is loaded
+    tm.queueLoad2DByteTextureFromData( "Full", first, 4 );
+    tm.queueSubsetLoad2DByteTextureFromData( "Full", second, 4,
+                                             std::vector<TextureTile>( 1, TextureTile( 1, 1, 1, 1 ) ) );
+    BOOST_CHECK_EQUAL( TextureManagerTestAccess::queuedCount( tm ), 2u );
+    BOOST_REQUIRE( TextureManagerTestAccess::queuedSubsetLoad( tm, "Full", tiles, texels ) );
+    BOOST_REQUIRE_EQUAL( tiles.size(), 1u );
+    BOOST_CHECK( tiles[0] == TextureTile( 0, 0, 4, 4 ) );
+    BOOST_CHECK( texels == second );
+}
+BOOST_AUTO_TEST_CASE( ShaderMangerTests )
+{
+    FileAssetFinderPtr finder(new FileAssetFinder);
+    finder->addRecursiveSearchPath( DATA_PATH );
+    ShaderManager sm;
+    sm.setAssetFinder( finder );
+
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
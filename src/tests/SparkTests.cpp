@@ -0,0 +1,335 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "SoftTestDeclarations.hpp"
+#include "ChargeOctree.hpp"
+#include "ChargeFieldKernels.hpp"
+#include "DBMSpark.hpp"
+#include "GridDBMSpark.hpp"
+#include "Random.hpp"
+#include "WeightedSampler.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using namespace spark;
+
+namespace
+{
+    /// Random point in the ball of the given radius and center
+    Eigen::Vector3f randomInBall( Random& random, float radius, const Eigen::Vector3f& center )
+    {
+        Eigen::Vector3f p;
+        do
+        {
+            // separate statements fix the draw order
+            p.x() = random.uniform( -1.0f, 1.0f );
+            p.y() = random.uniform( -1.0f, 1.0f );
+            p.z() = random.uniform( -1.0f, 1.0f );
+        } while( p.squaredNorm() > 1.0f );
+        return center + radius * p;
+    }
+
+    float maxDifference( const std::vector< float >& a, const std::vector< float >& b )
+    {
+        float result = 0;
+        for( size_t i = 0; i < a.size(); ++i )
+        {
+            result = std::max( result, std::abs( a[i] - b[i] ) );
+        }
+        return result;
+    }
+
+    void compareChargeKernels( const ChargeFieldKernels& test, const ChargeFieldKernels& reference )
+    {
+        const float tolerance = 1e-4f;
+        // an odd count to leave a tail, around two charges outside them
+        const size_t points = 301;
+        Random random( 3 );
+        std::vector< float > x( points ), y( points ), z( points );
+        random.fillUniform( &x[0], points, -1.0f, 1.0f );
+        random.fillUniform( &y[0], points, -1.0f, 1.0f );
+        random.fillUniform( &z[0], points, -1.0f, 1.0f );
+        std::vector< float > phiXTest( points, 0.0f ), phiYTest( points, 0.0f ), phiZTest( points, 0.0f ), phiTest( points );
+        std::vector< float > phiXRef( points, 0.0f ), phiYRef( points, 0.0f ), phiZRef( points, 0.0f ), phiRef( points );
+        const float charges[2][4] = { { 2.0f, 2.0f, 2.0f, -1.0f }, { -3.0f, 0.5f, 1.0f, 1.0f } };
+        float minTest = 1e10f, maxTest = 0.0f, minRef = 1e10f, maxRef = 0.0f;
+        for( size_t c = 0; c < 2; ++c )
+        {
+            test.addChargeField( &phiXTest[0], &phiYTest[0], &phiZTest[0],
+                                 &phiTest[0], &minTest, &maxTest,
+                                 &x[0], &y[0], &z[0], points,
+                                 charges[c][0], charges[c][1], charges[c][2], charges[c][3], 0.025f );
+            reference.addChargeField( &phiXRef[0], &phiYRef[0], &phiZRef[0],
+                                      &phiRef[0], &minRef, &maxRef,
+                                      &x[0], &y[0], &z[0], points,
+                                      charges[c][0], charges[c][1], charges[c][2], charges[c][3], 0.025f );
+        }
+        BOOST_CHECK_SMALL( maxDifference( phiXTest, phiXRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( phiYTest, phiYRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( phiZTest, phiZRef ), tolerance );
+        BOOST_CHECK_SMALL( maxDifference( phiTest, phiRef ), tolerance );
+        BOOST_CHECK_SMALL( minTest - minRef, tolerance );
+        BOOST_CHECK_SMALL( maxTest - maxRef, tolerance );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( SparkSuite )
+
+BOOST_AUTO_TEST_CASE( ChargeOctree_MatchesDirectSum )
+{
+    const float h = 0.025f;
+    Random random( 1 );
+    ChargeOctree tree;
+    // Far apart clusters, so the root has to grow, of mixed sign
+    for( size_t i = 0; i < 20000; ++i )
+    {
+        tree.insert( randomInBall( random, 0.5f, Eigen::Vector3f( 0, 0, 0 ) ), -1.0f );
+    }
+    for( size_t i = 0; i < 2000; ++i )
+    {
+        tree.insert( randomInBall( random, 0.2f, Eigen::Vector3f( 4, -3, 1 ) ), 2.0f );
+    }
+    // coincident charges can't be split apart
+    for( size_t i = 0; i < 100; ++i )
+    {
+        tree.insert( Eigen::Vector3f( 0.1f, 0.1f, 0.1f ), -1.0f );
+    }
+    BOOST_REQUIRE_EQUAL( tree.size(), 22100u );
+
+    float exactError = 0;
+    float approxError = 0;
+    for( size_t i = 0; i < 200; ++i )
+    {
+        const Eigen::Vector3f p = randomInBall( random, 2.0f, Eigen::Vector3f( 0, 0, 0 ) );
+        const Eigen::Vector3f direct = tree.directField( p, h );
+        exactError = std::max( exactError, ( tree.field( p, h, 0.0f ) - direct ).norm() / direct.norm() );
+        approxError = std::max( approxError, ( tree.field( p, h, 0.3f ) - direct ).norm() / direct.norm() );
+    }
+    BOOST_TEST_MESSAGE( "Barnes-Hut relative error " << approxError );
+    BOOST_CHECK_LT( exactError, 1e-4f );
+    BOOST_CHECK_LT( approxError, 1e-3f );
+}
+
+BOOST_AUTO_TEST_CASE( ChargeFieldKernels_SSEMatchesScalar )
+{
+    const ChargeFieldKernels* sse = sseChargeFieldKernels();
+    if( !sse )
+    {
+        BOOST_TEST_MESSAGE( "SSE2 kernels not available, skipping." );
+        return;
+    }
+    compareChargeKernels( *sse, scalarChargeFieldKernels() );
+}
+
+BOOST_AUTO_TEST_CASE( ChargeFieldKernels_AVX2MatchesScalar )
+{
+    const ChargeFieldKernels* avx2 = avx2ChargeFieldKernels();
+    if( !avx2 )
+    {
+        BOOST_TEST_MESSAGE( "AVX2 kernels not supported by this CPU, skipping." );
+        return;
+    }
+    compareChargeKernels( *avx2, scalarChargeFieldKernels() );
+}
+
+BOOST_AUTO_TEST_CASE( DBMSpark_BarnesHutMatchesDirect )
+{
+    DBMSparkPtr spark = buildSpark_pointInBall( 1.0f );
+    spark->setSeed( 2 );
+    spark->setFieldEvaluator( DBMSpark::BarnesHutFieldEvaluator );
+    spark->setFieldCheck( true );
+    for( size_t i = 0; i < 1000; ++i )
+    {
+        spark->update( 0.01 );
+    }
+    // the first update only seeds the candidates
+    BOOST_CHECK_EQUAL( spark->aggregate().size(), 1000u );
+    BOOST_TEST_MESSAGE( "Largest relative field error " << spark->getMaxFieldError() );
+    BOOST_CHECK_GT( spark->getMaxFieldError(), 0.0f );
+    BOOST_CHECK_LT( spark->getMaxFieldError(), 0.01f );
+}
+
+BOOST_AUTO_TEST_CASE( DBMSpark_ThreadCountDoesNotChangeGrowth )
+{
+    // Enough steps for several blocks of candidates
+    const size_t steps = 1200;
+    DBMSparkPtr sparks[2];
+    for( size_t s = 0; s < 2; ++s )
+    {
+        sparks[s] = buildSpark_pointInBall( 1.0f );
+        sparks[s]->setSeed( 5 );
+        sparks[s]->setFieldEvaluator( DBMSpark::BarnesHutFieldEvaluator );
+        sparks[s]->setThreadCount( s == 0 ? 1 : 4 );
+        for( size_t i = 0; i < steps; ++i )
+        {
+            sparks[s]->update( 0.01 );
+        }
+    }
+    BOOST_CHECK_EQUAL( sparks[1]->getThreadCount(), 4u );
+    const PointCharges& serial = sparks[0]->candidate();
+    const PointCharges& threaded = sparks[1]->candidate();
+    BOOST_REQUIRE_GT( serial.size(), 4096u );
+    BOOST_REQUIRE_EQUAL( serial.size(), threaded.size() );
+    for( size_t i = 0; i < serial.size(); ++i )
+    {
+        BOOST_REQUIRE( serial[i].pos == threaded[i].pos );
+        BOOST_REQUIRE( serial[i].phi == threaded[i].phi );
+    }
+    BOOST_CHECK_EQUAL( sparks[0]->aggregate().size(), steps );
+    BOOST_CHECK( sparks[0]->aggregate().back().pos == sparks[1]->aggregate().back().pos );
+}
+
+BOOST_AUTO_TEST_CASE( GridDBMSpark_GrowsUntilItStrikes )
+{
+    const size_t N = 24;
+    GridDBMSparkPtr spark = buildGridSpark_pointInBox( N, 1.0f );
+    spark->setSeed( 4 );
+    const float h = 2.0f / N;
+    BOOST_REQUIRE_EQUAL( spark->aggregate().size(), 1u );
+    BOOST_REQUIRE_EQUAL( spark->candidate().size(), 26u );
+    size_t steps = 0;
+    unsigned int maxIterations = 0;
+    while( !spark->hasStruck() && steps < 2000 )
+    {
+        spark->update( 0.01 );
+        ++steps;
+        maxIterations = std::max( maxIterations, spark->getSolverIterations() );
+    }
+    BOOST_REQUIRE( spark->hasStruck() );
+    BOOST_TEST_MESSAGE( "Struck after " << steps << " steps, at most "
+                        << maxIterations << " solver iterations" );
+    BOOST_CHECK_LT( maxIterations, 50u );
+    const PointCharges& aggregate = spark->aggregate();
+    BOOST_CHECK_EQUAL( aggregate.size(), steps + 1 );
+
+    // each cell joined beside an earlier one, and reached a face
+    float reach = 0;
+    for( size_t a = 1; a < aggregate.size(); ++a )
+    {
+        float nearest = 1e10f;
+        for( size_t b = 0; b < a; ++b )
+        {
+            nearest = std::min( nearest, ( aggregate[a].pos - aggregate[b].pos ).norm() );
+        }
+        BOOST_REQUIRE_LT( nearest, 1.8f * h );
+        reach = std::max( reach, aggregate[a].pos.cwiseAbs().maxCoeff() );
+    }
+    BOOST_CHECK_GT( reach, 1.0f - 2.0f * h );
+
+    // update() stops once struck
+    spark->update( 0.01 );
+    BOOST_CHECK_EQUAL( spark->aggregate().size(), steps + 1 );
+    const PointCharges& candidate = spark->candidate();
+    BOOST_REQUIRE( !candidate.empty() );
+    for( size_t c = 0; c < candidate.size(); ++c )
+    {
+        BOOST_REQUIRE_LT( candidate[c].pos.cwiseAbs().maxCoeff(), 1.0f );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( Random_IsSeededAndUniform )
+{
+    Random a( 7 ), b( 7 ), c( 8 );
+    size_t differences = 0;
+    for( size_t i = 0; i < 100; ++i )
+    {
+        const boost::uint32_t x = a.next();
+        BOOST_REQUIRE_EQUAL( x, b.next() );
+        differences += ( x != c.next() );
+    }
+    BOOST_CHECK_GT( differences, 95u );
+
+    // a batch matches the same draws made one at a time
+    std::vector< float > batch( 1001 );
+    a.fillUniform( &batch[0], batch.size(), -2.0f, 3.0f );
+    for( size_t i = 0; i < batch.size(); ++i )
+    {
+        BOOST_REQUIRE_EQUAL( batch[i], b.uniform( -2.0f, 3.0f ) );
+    }
+    BOOST_CHECK_EQUAL( a.next(), b.next() );
+
+    a.seed( 9 );
+    b.seed( 9 );
+    BOOST_CHECK_EQUAL( a.next(), b.next() );
+
+    // mean and bucket counts of [0,1) draws
+    const size_t n = 100000;
+    const size_t bucketCount = 10;
+    size_t buckets[bucketCount] = { 0 };
+    double sum = 0;
+    for( size_t i = 0; i < n; ++i )
+    {
+        const float u = a.uniform();
+        const double d = a.uniformDouble();
+        BOOST_REQUIRE( u >= 0.0f && u < 1.0f );
+        BOOST_REQUIRE( d >= 0.0 && d < 1.0 );
+        sum += u;
+        ++buckets[(size_t)( u * bucketCount )];
+    }
+    BOOST_CHECK_CLOSE( sum / n, 0.5, 1.0 );
+    for( size_t k = 0; k < bucketCount; ++k )
+    {
+        BOOST_CHECK_CLOSE( (double)buckets[k], (double)n / bucketCount, 5.0 );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( WeightedSampler_MatchesLinearScan )
+{
+    Random random( 3 );
+    WeightedSampler sampler;
+    std::vector< float > weights;
+    for( size_t step = 0; step < 2000; ++step )
+    {
+        // Mostly grow, with a few zero weights, like DBM candidates
+        const int op = random.next() % 4;
+        const float w = ( random.next() % 5 == 0 ) ? 0.0f : random.uniform();
+        if( op == 0 && !weights.empty() )
+        {
+            const size_t i = random.next() % weights.size();
+            weights[i] = w;
+            sampler.set( i, w );
+        }
+        else if( op == 1 && !weights.empty() )
+        {
+            weights.pop_back();
+            sampler.popBack();
+        }
+        else
+        {
+            weights.push_back( w );
+            sampler.pushBack( w );
+        }
+        if( step % 100 == 0 )
+        {
+            WeightedSampler rebuilt;
+            rebuilt.assign( weights );
+            BOOST_REQUIRE_CLOSE( rebuilt.total(), sampler.total(), 1e-9 );
+        }
+    }
+    BOOST_REQUIRE_EQUAL( sampler.size(), weights.size() );
+    BOOST_REQUIRE_GT( sampler.total(), 0.0 );
+
+    double total = 0;
+    for( size_t i = 0; i < weights.size(); ++i )
+    {
+        total += weights[i];
+    }
+    BOOST_CHECK_CLOSE( sampler.total(), total, 1e-9 );
+    for( size_t k = 0; k < 1000; ++k )
+    {
+        const double u = ( k + 0.5 ) / 1000.0;
+        size_t expected = 0;
+        double sum = weights[0];
+        while( sum <= u * total )
+        {
+            sum += weights[++expected];
+        }
+        const size_t i = sampler.sample( u );
+        BOOST_REQUIRE_EQUAL( i, expected );
+        BOOST_REQUIRE_GT( weights[i], 0.0f );
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,381 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "SoftTestDeclarations.hpp"
+#include "TissueMesh.hpp"
+#include "TextureManager.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+
+using namespace spark;
+
+namespace spark
+{
+    /// Takes TissueMesh's dirty tiles, as queueing its uploads would.
+    struct TissueMeshTestAccess
+    {
+        static std::vector< TextureTile > takeConditionTiles( TissueMesh& tissue )
+        {
+            return tissue.takeDirtyTextureTiles( tissue.m_isConditionTileDirty );
+        }
+        static std::vector< TextureTile > takeDepthTiles( TissueMesh& tissue )
+        {
+            return tissue.takeDirtyTextureTiles( tissue.m_isDepthTileDirty );
+        }
+        static std::vector< TextureTile > takeTemperatureTiles( TissueMesh& tissue )
+        {
+            return tissue.takeDirtyTextureTiles( tissue.m_isTempTileDirty );
+        }
+    };
+}
+
+namespace
+{
+    const size_t heatDim = 150; // tiles don't divide it evenly
+    const size_t N = heatDim + 2;
+    const float lengthMeters = 0.0024f; // diffusion k of about 0.04 at dt = 0.1
+    const float bodyTemp = 273.15f + 37.0f;
+
+    /// World position of the center of cell (x,y) of a map length wide
+    void cellPosition( size_t x, size_t y, float* pX, float* pY, float length = lengthMeters )
+    {
+        const float h = length / heatDim;
+        // a quarter cell off-center, clear of rounding at the cell edges
+        *pX = h * ( x - N/2.0f + 0.75f );
+        *pY = h * ( y - N/2.0f + 0.75f );
+    }
+
+    /// Heat some cells: next to tile edges, by the boundary and in the middle.
+    void addHeat( TissueMesh& tissue, float joules )
+    {
+        const size_t cells[][2] = { { 64, 64 }, { 65, 64 }, { 1, 1 }, { 150, 77 }, { 100, 129 } };
+        for( size_t c = 0; c < sizeof( cells ) / sizeof( cells[0] ); ++c )
+        {
+            float x, y;
+            cellPosition( cells[c][0], cells[c][1], &x, &y );
+            tissue.accumulateHeat( x, y, joules );
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE( TissueSuite )
+
+BOOST_AUTO_TEST_CASE( TissueMesh_TiledDiffusionMatchesSweeps )
+{
+    const double dt = 0.1;
+    const float h = lengthMeters / heatDim;
+    const double c = 3500.0;
+    const double m = (float)( h*h*h ) * 1060.0f;
+    // warm the cells by 15 K, staying below dessication
+    const float joules = (float)( 15.0 * c * m / dt );
+
+    TissueMesh tissue( "TissueTests", TextureManagerPtr(), lengthMeters, heatDim );
+    tissue.setThreadCount( 3 );
+    addHeat( tissue, joules );
+    tissue.update( dt );
+
+    // Reference: the same heat, then full-map sweeps
+    std::vector< double > curr( N*N, bodyTemp );
+    const size_t cells[][2] = { { 64, 64 }, { 65, 64 }, { 1, 1 }, { 150, 77 }, { 100, 129 } };
+    for( size_t i = 0; i < 5; ++i )
+    {
+        curr[cells[i][0] + N*cells[i][1]] += dt * joules / ( c * m );
+    }
+    const size_t iterations = 100;
+    const double k = dt * 1e-8 / ( iterations * h * h );
+    const double decay = 0.3 * dt / iterations;
+    BOOST_REQUIRE_LT( k, 0.05 );
+    std::vector< double > next( curr );
+    for( size_t iter = 0; iter < iterations; ++iter )
+    {
+        for( size_t y = 1; y < N-1; ++y )
+        {
+            for( size_t x = 1; x < N-1; ++x )
+            {
+                const size_t ind = x + N*y;
+                const double delta
+                    = k * ( 4.0 * ( curr[ind+1] + curr[ind-1] + curr[ind+N] + curr[ind-N] )
+                            + curr[ind+1+N] + curr[ind+1-N] + curr[ind-1+N] + curr[ind-1-N]
+                            - 20.0 * curr[ind] );
+                next[ind] = curr[ind] + delta - decay * ( curr[ind] - bodyTemp );
+            }
+        }
+        curr.swap( next );
+    }
+
+    // Tiles left within 0.01 K of baseline are reset to it exactly
+    const float* temp = tissue.getTemperatureData();
+    double maxDiff = 0;
+    for( size_t i = 0; i < N*N; ++i )
+    {
+        if( temp[i] != bodyTemp || std::abs( curr[i] - bodyTemp ) > 1e-2 )
+        {
+            maxDiff = std::max( maxDiff, std::abs( temp[i] - curr[i] ) );
+        }
+    }
+    BOOST_CHECK_SMALL( maxDiff, 1e-3 );
+    // the heat spread
+    BOOST_CHECK_GT( temp[66 + N*64], temp[70 + N*64] );
+
+    // and the split across threads doesn't change the result
+    TissueMesh single( "TissueTests", TextureManagerPtr(), lengthMeters, heatDim );
+    single.setThreadCount( 1 );
+    addHeat( single, joules );
+    single.update( dt );
+    BOOST_CHECK( std::equal( temp, temp + N*N, single.getTemperatureData() ) );
+}
+
+BOOST_AUTO_TEST_CASE( TissueMesh_ImplicitSolverMatchesExplicit )
+{
+    // Cells 8 times as wide as above, so each update spreads heat by
+    // about a cell: 6*a*dt/h^2 is about 0.4
+    const float length = 8.0f * lengthMeters;
+    const double dt = 0.1;
+    const float h = length / heatDim;
+    const double m = (float)( h*h*h ) * 1060.0f;
+    const float joules = (float)( 15.0 * 3500.0 * m / dt );
+
+    TissueMesh explicitTissue( "TissueTests", TextureManagerPtr(), length, heatDim );
+    TissueMesh implicitTissue( "TissueTests", TextureManagerPtr(), length, heatDim );
+    implicitTissue.setThermalSolver( TissueMesh::ImplicitThermalSolver );
+    for( int frame = 0; frame < 10; ++frame )
+    {
+        // a contact-sized spot, 9 cells across
+        for( size_t y = 60; y < 69 && frame < 3; ++y )
+        {
+            for( size_t x = 60; x < 69; ++x )
+            {
+                float px, py;
+                cellPosition( x, y, &px, &py, length );
+                explicitTissue.accumulateHeat( px, py, joules );
+                implicitTissue.accumulateHeat( px, py, joules );
+            }
+        }
+        explicitTissue.update( dt );
+        implicitTissue.update( dt );
+    }
+
+    // compare the change from baseline
+    const float* ex = explicitTissue.getTemperatureData();
+    const float* im = implicitTissue.getTemperatureData();
+    float maxRise = 0;
+    float maxDiff = 0;
+    for( size_t y = 1; y < N-1; ++y )
+    {
+        for( size_t x = 1; x < N-1; ++x )
+        {
+            const size_t i = x + N*y;
+            maxRise = std::max( maxRise, ex[i] - bodyTemp );
+            maxDiff = std::max( maxDiff, std::abs( ex[i] - im[i] ) );
+        }
+    }
+    BOOST_TEST_MESSAGE( "Implicit solver differs by " << maxDiff << " K of " << maxRise << " K" );
+    BOOST_CHECK_GT( maxRise, 1.0f );
+    BOOST_CHECK_LT( maxDiff, 0.05f * maxRise );
+}
+
+BOOST_AUTO_TEST_CASE( TissueMesh_ActiveTilesFollowHeat )
+{
+    const double dt = 0.1;
+    const float h = lengthMeters / heatDim;
+    const double m = (float)( h*h*h ) * 1060.0f;
+    const float joules = (float)( 15.0 * 3500.0 * m / dt );
+    const size_t tileCount = 5*5; // 32-cell tiles
+
+    TissueMesh tissue( "TissueTests", TextureManagerPtr(), lengthMeters, heatDim );
+    tissue.update( dt );
+    BOOST_CHECK_EQUAL( tissue.getActiveTileCount(), 0u );
+
+    float x, y;
+    cellPosition( 64, 64, &x, &y );
+    tissue.accumulateHeat( x, y, joules );
+    tissue.update( dt );
+    // the heated tile and its neighbors
+    BOOST_CHECK_EQUAL( tissue.getActiveTileCount(), 9u );
+    BOOST_CHECK_GT( tissue.getTemperatureData()[64 + N*64], bodyTemp + 0.01f );
+
+    // the heat spreads and decays until every tile drops out
+    size_t frames = 0;
+    while( tissue.getActiveTileCount() > 0 && frames < 2000 )
+    {
+        BOOST_REQUIRE_LT( tissue.getActiveTileCount(), tileCount );
+        tissue.update( dt );
+        ++frames;
+    }
+    BOOST_TEST_MESSAGE( "Cooled to baseline in " << frames << " updates" );
+    BOOST_CHECK_EQUAL( tissue.getActiveTileCount(), 0u );
+    const float* temp = tissue.getTemperatureData();
+    for( size_t i = 0; i < N*N; ++i )
+    {
+        BOOST_REQUIRE_EQUAL( temp[i], bodyTemp );
+    }
+}
+
+BOOST_AUTO_TEST_CASE( TissueMesh_ElectricalEnergyIsConserved )
+{
+    // the simulator's scale: cells of 1.7 mm, a contact a cell wide
+    const float length = 0.25f;
+    const float h = length / heatDim;
+    const float radius = 0.002f;
+    const float current = 3.0f;
+    const float dt = 0.1f;
+    const float cx = 0.0013f;
+    const float cy = -0.0041f;
+
+    TissueMesh tissue( "TissueTests", TextureManagerPtr(), length, heatDim );
+    tissue.accumulateElectricalEnergy( cx, cy, 100.0f, current, 0.5f, radius, dt );
+    const double* heat = tissue.getHeatData();
+
+    // Every element's share, as the falloff describes it
+    double expected = 0;
+    double deposited = 0;
+    for( size_t y = 1; y < N-1; ++y )
+    {
+        for( size_t x = 1; x < N-1; ++x )
+        {
+            const double dx = h * ( x - N/2.0 + 0.5 ) - cx;
+            const double dy = h * ( y - N/2.0 + 0.5 ) - cy;
+            const double r = std::sqrt( dx*dx + dy*dy );
+            const double u = std::max( r - radius, h / 2.0 );
+            const double weight = r < radius ? 1.0 / ( M_PI * radius * radius ) : 1.0 / ( u*u*u );
+            expected += 1e-10 * current * current * dt * weight;
+            deposited += heat[x + N*y];
+        }
+    }
+    BOOST_TEST_MESSAGE( "Deposited " << deposited << " J of " << expected << " J" );
+    BOOST_CHECK_CLOSE( deposited, expected, 1.0 ); // percent
+    // distant elements were skipped
+    BOOST_CHECK_EQUAL( heat[1 + N*1], 0.0 );
+
+    // points of one contact share its energy
+    TissueMesh batched( "TissueTests", TextureManagerPtr(), length, heatDim );
+    std::vector< glm::vec2 > contacts( 4, glm::vec2( cx, cy ) );
+    batched.accumulateElectricalEnergy( contacts, 100.0f, current, 0.5f, radius, dt );
+    double batchedDeposited = 0;
+    for( size_t i = 0; i < N*N; ++i )
+    {
+        batchedDeposited += batched.getHeatData()[i];
+    }
+    BOOST_CHECK_CLOSE( batchedDeposited, deposited, 1e-3 );
+}
+
+BOOST_AUTO_TEST_CASE( TissueMesh_ConditionEventsTrackVaporization )
+{
+    const double dt = 0.1;
+    const float h = lengthMeters / heatDim;
+    const double m = (float)( h*h*h ) * 1060.0f;
+    // past vaporization (about 890 K) in one update
+    const float joules = (float)( 700.0 * 3500.0 * m / dt );
+    const size_t x0 = 40, x1 = 52, y0 = 40, y1 = 52;
+
+    TissueMesh tissue( "TissueTests", TextureManagerPtr(), lengthMeters, heatDim );
+    for( size_t y = y0; y < y1; ++y )
+    {
+        for( size_t x = x0; x < x1; ++x )
+        {
+            float px, py;
+            cellPosition( x, y, &px, &py );
+            tissue.accumulateHeat( px, py, joules );
+        }
+    }
+    tissue.update( dt );
+
+    const std::vector< TissueMesh::ConditionEvent >& events = tissue.getConditionEvents();
+    BOOST_REQUIRE_EQUAL( events.size(), ( x1 - x0 ) * ( y1 - y0 ) );
+    for( size_t e = 0; e < events.size(); ++e )
+    {
+        const size_t x = events[e].index % N;
+        const size_t y = events[e].index / N;
+        BOOST_REQUIRE( x >= x0 && x < x1 && y >= y0 && y < y1 );
+        BOOST_CHECK_EQUAL( events[e].oldCondition, TissueMesh::normalTissue );
+        BOOST_CHECK_EQUAL( events[e].newCondition, TissueMesh::vaporizingTissue );
+        BOOST_CHECK_EQUAL( tissue.getConditionData()[events[e].index], TissueMesh::vaporizingTissue );
+    }
+
+    std::vector< glm::vec2 > all;
+    tissue.acquireVaporizingLocations( all, 1000 );
+    BOOST_CHECK_EQUAL( all.size(), events.size() );
+
+    // a few locations, spread over the whole block
+    std::vector< glm::vec2 > some;
+    tissue.acquireVaporizingLocations( some, 16 );
+    BOOST_REQUIRE_EQUAL( some.size(), 16u );
+    float minX, minY, maxX, maxY;
+    cellPosition( x1, y1, &minX, &minY );
+    cellPosition( x0, y0, &maxX, &maxY );
+    for( size_t i = 0; i < some.size(); ++i )
+    {
+        minX = std::min( minX, some[i].x );
+        minY = std::min( minY, some[i].y );
+        maxX = std::max( maxX, some[i].x );
+        maxY = std::max( maxY, some[i].y );
+    }
+    BOOST_CHECK_GT( maxX - minX, 0.75f * h * ( x1 - x0 ) );
+    BOOST_CHECK_GT( maxY - minY, 0.75f * h * ( y1 - y0 ) );
+
+    // vaporizing lasts one update
+    const size_t vaporizing = events.size();
+    tissue.update( dt );
+    size_t vaporized = 0;
+    for( size_t e = 0; e < tissue.getConditionEvents().size(); ++e )
+    {
+        vaporized += tissue.getConditionEvents()[e].newCondition == TissueMesh::vaporizedTissue;
+    }
+    BOOST_CHECK_EQUAL( vaporized, vaporizing );
+    std::vector< glm::vec2 > none;
+    tissue.acquireVaporizingLocations( none );
+    BOOST_CHECK( none.empty() );
+}
+
+BOOST_AUTO_TEST_CASE( TissueMesh_DepositDirtiesOnlyTouchedTiles )
+{
+    const double dt = 0.1;
+    const float h = lengthMeters / heatDim;
+    const double m = (float)( h*h*h ) * 1060.0f;
+    // 40 K, enough to dessicate the cell but not to vaporize it
+    const float joules = (float)( 40.0 * 3500.0 * m / dt );
+
+    TissueMesh tissue( "TissueTests", TextureManagerPtr(), lengthMeters, heatDim );
+    // the first upload is in full: the tiles cover the whole map
+    const std::vector< TextureTile > all = TissueMeshTestAccess::takeConditionTiles( tissue );
+    int area = 0;
+    for( size_t t = 0; t < all.size(); ++t )
+    {
+        area += all[t].width * all[t].height;
+    }
+    BOOST_CHECK_EQUAL( area, (int)( N*N ) );
+    TissueMeshTestAccess::takeDepthTiles( tissue );
+    TissueMeshTestAccess::takeTemperatureTiles( tissue );
+
+    // cell (48,48) is inside the second tile of the second row, whose
+    // texels are [33,65) along each axis
+    float x, y;
+    cellPosition( 48, 48, &x, &y );
+    tissue.accumulateHeat( x, y, joules );
+    tissue.update( dt );
+
+    const std::vector< TextureTile > condition = TissueMeshTestAccess::takeConditionTiles( tissue );
+    BOOST_REQUIRE_EQUAL( condition.size(), 1u );
+    BOOST_CHECK( condition[0] == TextureTile( 33, 33, 32, 32 ) );
+    BOOST_CHECK( TissueMeshTestAccess::takeDepthTiles( tissue ).empty() );
+    // temperatures may change in the heated tile and its neighbors,
+    // which cover [0,97) along each axis (taking in the boundary cells)
+    const std::vector< TextureTile > temperature = TissueMeshTestAccess::takeTemperatureTiles( tissue );
+    BOOST_CHECK_EQUAL( temperature.size(), 9u );
+    area = 0;
+    for( size_t t = 0; t < temperature.size(); ++t )
+    {
+        BOOST_CHECK_LE( temperature[t].x + temperature[t].width, 97 );
+        BOOST_CHECK_LE( temperature[t].y + temperature[t].height, 97 );
+        area += temperature[t].width * temperature[t].height;
+    }
+    BOOST_CHECK_EQUAL( area, 97*97 );
+
+    // taking the tiles cleared them
+    BOOST_CHECK( TissueMeshTestAccess::takeConditionTiles( tissue ).empty() );
+    BOOST_CHECK( TissueMeshTestAccess::takeTemperatureTiles( tissue ).empty() );
+}
+
+BOOST_AUTO_TEST_SUITE_END()